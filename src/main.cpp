@@ -1,4 +1,5 @@
 ﻿#include "imgui.h"
+#include "imgui_internal.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
 #include <GLFW/glfw3.h>
@@ -9,243 +10,6562 @@
 #include <filesystem>
 #include <map>
 #include <set>
+#include <cctype>
+#include <cmath>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <queue>
+#include <deque>
+#include <list>
+#include <array>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <cstring>
+#include <span>
+#include <bit>
 #include <nfd.h>
+#include <zlib.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <io.h>
+#include <fcntl.h>
+using SocketHandle = SOCKET;
+constexpr SocketHandle INVALID_SOCKET_HANDLE = INVALID_SOCKET;
+inline void CloseSocket(SocketHandle socket) { closesocket(socket); }
+inline int PollSockets(WSAPOLLFD* fds, unsigned count, int timeoutMs) { return WSAPoll(fds, count, timeoutMs); }
+using PollFd = WSAPOLLFD;
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+using SocketHandle = int;
+constexpr SocketHandle INVALID_SOCKET_HANDLE = -1;
+inline void CloseSocket(SocketHandle socket) { close(socket); }
+inline int PollSockets(pollfd* fds, unsigned count, int timeoutMs) { return poll(fds, count, timeoutMs); }
+using PollFd = pollfd;
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#define HAS_IO_URING 1
+#else
+#define HAS_IO_URING 0
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HAS_SSE2 1
+#else
+#define HAS_SSE2 0
+#endif
+
+// =========================================================
+// --- 0. THREADING ---
+// Small shared worker pool. ParallelFor splits [0, count) in ranges and the
+// calling thread works on them too, so it is safe to call from inside a task.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threadCount = std::max(1u, std::thread::hardware_concurrency())) {
+        for (unsigned i = 0; i < threadCount; ++i)
+            Workers.emplace_back([this] { WorkerLoop(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(Mutex);
+            Stopping = true;
+        }
+        WakeUp.notify_all();
+        for (auto& worker : Workers) worker.join();
+    }
+
+    unsigned Size() const { return static_cast<unsigned>(Workers.size()); }
+
+    void Submit(std::function<void()> task) {
+        {
+            std::lock_guard lock(Mutex);
+            Tasks.push(std::move(task));
+        }
+        WakeUp.notify_one();
+    }
+
+    // Calls fn(begin, end) on ranges of at most grain items, returns when all are done
+    void ParallelFor(int count, int grain, const std::function<void(int, int)>& fn) {
+        if (count <= 0) return;
+        // Helpers may only get a worker after every range is done and this call returned:
+        // they must find the counters alive (and no range left, so fn is never called late)
+        struct Progress {
+            std::atomic<int> NextRange = 0;
+            std::atomic<int> DoneRanges = 0;
+            std::mutex Mutex;
+            std::condition_variable Done;
+        };
+        const int rangeCount = (count + grain - 1) / grain;
+        auto progress = std::make_shared<Progress>();
+
+        auto work = [progress, rangeCount, count, grain, &fn] {
+            for (int r = progress->NextRange++; r < rangeCount; r = progress->NextRange++) {
+                fn(r * grain, std::min(count, (r + 1) * grain));
+                if (++progress->DoneRanges == rangeCount) {
+                    std::lock_guard lock(progress->Mutex);
+                    progress->Done.notify_all();
+                }
+            }
+        };
+        const int helpers = std::min<int>(rangeCount - 1, Size());
+        for (int i = 0; i < helpers; ++i) Submit(work);
+        work();
+
+        std::unique_lock lock(progress->Mutex);
+        progress->Done.wait(lock, [&] { return progress->DoneRanges == rangeCount; });
+    }
+
+private:
+    void WorkerLoop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock(Mutex);
+                WakeUp.wait(lock, [this] { return Stopping || !Tasks.empty(); });
+                if (Stopping && Tasks.empty()) return;
+                task = std::move(Tasks.front());
+                Tasks.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> Workers;
+    std::queue<std::function<void()>> Tasks;
+    std::mutex Mutex;
+    std::condition_variable WakeUp;
+    bool Stopping = false;
+};
+
+ThreadPool g_ThreadPool;
+
+// =========================================================
+// --- FILE READING ---
+// Logs are read in READ_BLOCK_SIZE blocks with READ_QUEUE_DEPTH reads in flight, so the next
+// blocks are fetched (cold disk cache, NFS/SMB build shares) while the current one is parsed.
+// Backends:
+//   IoUring  Linux only: the reads are queued on an io_uring from the parsing thread itself
+//   Threads  READ_THREADS threads doing positional reads (pread / ReadFile) into the ring
+//   Stream   std::ifstream, one read at a time (the original path, kept for --bench-load)
+// Auto picks IoUring when the kernel supports it, Threads otherwise.
+constexpr size_t READ_BLOCK_SIZE = 4 << 20;
+constexpr int READ_QUEUE_DEPTH = 8;
+constexpr int READ_THREADS = 4;
+
+enum class ReadBackend { Auto, IoUring, Threads, Stream };
+
+const char* ReadBackendName(ReadBackend backend) {
+    switch (backend) {
+        case ReadBackend::Auto:    return "auto";
+        case ReadBackend::IoUring: return "io_uring";
+        case ReadBackend::Threads: return "threads";
+        case ReadBackend::Stream:  return "ifstream";
+    }
+    return "";
+}
+
+#ifdef _WIN32
+using FileHandle = HANDLE;
+static const FileHandle INVALID_FILE_HANDLE = INVALID_HANDLE_VALUE;
+
+static FileHandle OpenReadHandle(const std::filesystem::path& path) {
+    return CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                       nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+}
+
+static void CloseReadHandle(FileHandle file) { CloseHandle(file); }
+
+// Returns the number of bytes read, 0 at the end of the file, -1 on error
+static long long ReadAt(FileHandle file, char* buffer, size_t size, uint64_t offset) {
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD read = 0;
+    if (!ReadFile(file, buffer, static_cast<DWORD>(size), &read, &overlapped))
+        return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+    return read;
+}
+
+// Best effort, lets --bench-load measure cold reads. Not available on Windows.
+static bool DropFileCache(const std::filesystem::path&) { return false; }
+#else
+using FileHandle = int;
+static const FileHandle INVALID_FILE_HANDLE = -1;
+
+static FileHandle OpenReadHandle(const std::filesystem::path& path) {
+    const FileHandle file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+#ifdef POSIX_FADV_SEQUENTIAL
+    if (file >= 0) posix_fadvise(file, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    return file;
+}
+
+static void CloseReadHandle(FileHandle file) { close(file); }
+
+// Returns the number of bytes read, 0 at the end of the file, -1 on error
+static long long ReadAt(FileHandle file, char* buffer, size_t size, uint64_t offset) {
+    for (;;) {
+        const ssize_t read = pread(file, buffer, size, static_cast<off_t>(offset));
+        if (read >= 0 || errno != EINTR) return read;
+    }
+}
+
+// Best effort, lets --bench-load measure cold reads
+static bool DropFileCache(const std::filesystem::path& path) {
+#ifdef POSIX_FADV_DONTNEED
+    const int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) return false;
+    const bool dropped = fdatasync(file) == 0 && posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(file);
+    return dropped;
+#else
+    return false;
+#endif
+}
+#endif
+
+#if HAS_IO_URING
+// Minimal io_uring through the raw syscalls (no liburing dependency): one submission and one
+// completion ring, READV requests only.
+class IoUringQueue {
+public:
+    ~IoUringQueue() { Close(); }
+
+    bool Init(unsigned entries) {
+        io_uring_params params = {};
+        RingFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (RingFd < 0) return false;
+
+        SqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap) SqRingSize = CqRingSize = std::max(SqRingSize, CqRingSize);
+
+        SqRing = MapRing(SqRingSize, IORING_OFF_SQ_RING);
+        CqRing = singleMap ? SqRing : MapRing(CqRingSize, IORING_OFF_CQ_RING);
+        SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        Sqes = static_cast<io_uring_sqe*>(MapRing(SqesSize, IORING_OFF_SQES));
+        if (!SqRing || !CqRing || !Sqes) {
+            Close();
+            return false;
+        }
+
+        char* sq = static_cast<char*>(SqRing);
+        SqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        SqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        SqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(CqRing);
+        CqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        CqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        CqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        Cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    void Close() {
+        if (Sqes) munmap(Sqes, SqesSize);
+        if (CqRing && CqRing != SqRing) munmap(CqRing, CqRingSize);
+        if (SqRing) munmap(SqRing, SqRingSize);
+        if (RingFd >= 0) close(RingFd);
+        Sqes = nullptr;
+        SqRing = CqRing = nullptr;
+        RingFd = -1;
+    }
+
+    // Queues a read, sent to the kernel by the next WaitCompletion. vec must stay alive until it completes.
+    void PrepareRead(int file, const iovec* vec, uint64_t offset, uint64_t userData) {
+        const unsigned tail = *SqTail; // Only this thread writes the tail
+        const unsigned index = tail & SqMask;
+        io_uring_sqe& sqe = Sqes[index];
+        sqe = {};
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = file;
+        sqe.addr = reinterpret_cast<uint64_t>(vec);
+        sqe.len = 1;
+        sqe.off = offset;
+        sqe.user_data = userData;
+        SqArray[index] = index;
+        __atomic_store_n(SqTail, tail + 1, __ATOMIC_RELEASE);
+        Unsubmitted++;
+    }
+
+    // Submits the queued reads and waits for one completion. result is the byte count or -errno.
+    bool WaitCompletion(uint64_t& userData, int& result) {
+        for (;;) {
+            const unsigned head = *CqHead;
+            if (head != __atomic_load_n(CqTail, __ATOMIC_ACQUIRE)) {
+                const io_uring_cqe& cqe = Cqes[head & CqMask];
+                userData = cqe.user_data;
+                result = cqe.res;
+                __atomic_store_n(CqHead, head + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+            const long submitted = syscall(__NR_io_uring_enter, RingFd, Unsubmitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (submitted < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            Unsubmitted -= static_cast<unsigned>(submitted);
+        }
+    }
+
+private:
+    void* MapRing(size_t size, off_t offset) {
+        void* ring = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, RingFd, offset);
+        return ring == MAP_FAILED ? nullptr : ring;
+    }
+
+    int RingFd = -1;
+    void* SqRing = nullptr;
+    void* CqRing = nullptr;
+    size_t SqRingSize = 0, CqRingSize = 0, SqesSize = 0;
+    io_uring_sqe* Sqes = nullptr;
+    io_uring_cqe* Cqes = nullptr;
+    unsigned* SqTail = nullptr;
+    unsigned* SqArray = nullptr;
+    unsigned* CqHead = nullptr;
+    unsigned* CqTail = nullptr;
+    unsigned SqMask = 0, CqMask = 0;
+    unsigned Unsubmitted = 0;
+};
+#endif
+
+// Reads a file front to back through a ring of READ_QUEUE_DEPTH block buffers.
+//   FileBlockReader reader;
+//   if (reader.Open(path)) while (reader.Next(block)) Parse(block);
+class FileBlockReader {
+public:
+    ~FileBlockReader() { Close(); }
+
+    ReadBackend Backend() const { return ActiveBackend; }
+    bool Failed() const { return Error; }
+
+    // Reads from startOffset to the end of the file (its size when opened)
+    bool Open(const std::filesystem::path& path, ReadBackend backend = ReadBackend::Auto, uint64_t startOffset = 0) {
+        Close();
+        std::error_code error;
+        FileSize = std::filesystem::file_size(path, error);
+        if (error) return false;
+        StartOffset = std::min(startOffset, FileSize);
+        BlockCount = static_cast<size_t>((FileSize - StartOffset + READ_BLOCK_SIZE - 1) / READ_BLOCK_SIZE);
+        NextBlock = 0;
+        Error = false;
+
+        if (backend == ReadBackend::Stream) {
+            Stream.open(path, std::ios::binary);
+            if (!Stream.is_open()) return false;
+            Stream.seekg(static_cast<std::streamoff>(StartOffset));
+            Slots[0].Data = std::make_unique<char[]>(READ_BLOCK_SIZE);
+            ActiveBackend = ReadBackend::Stream;
+            return true;
+        }
+
+        File = OpenReadHandle(path);
+        if (File == INVALID_FILE_HANDLE) return false;
+        for (Slot& slot : Slots) slot.Data = std::make_unique<char[]>(READ_BLOCK_SIZE);
+
+#if HAS_IO_URING
+        if (backend != ReadBackend::Threads && Ring.Init(READ_QUEUE_DEPTH)) {
+            ActiveBackend = ReadBackend::IoUring;
+            for (size_t block = 0; block < std::min<size_t>(READ_QUEUE_DEPTH, BlockCount); ++block) QueueBlock(block);
+            return true;
+        }
+#endif
+        ActiveBackend = ReadBackend::Threads;
+        Stopping = false;
+        ReleasedBlocks = 0;
+        for (int t = 0; t < READ_THREADS; ++t) Readers.emplace_back([this, t] { ReaderLoop(t); });
+        return true;
+    }
+
+    // Next block in file order, valid until the following call. False at the end of the file or on error.
+    bool Next(std::string_view& block) {
+        if (ActiveBackend == ReadBackend::Stream) {
+            Stream.read(Slots[0].Data.get(), READ_BLOCK_SIZE);
+            block = std::string_view(Slots[0].Data.get(), static_cast<size_t>(Stream.gcount()));
+            return !block.empty();
+        }
+        if (NextBlock > 0) ReleaseBlock(NextBlock - 1);
+        if (Error || NextBlock >= BlockCount) return false;
+
+        Slot& slot = Slots[NextBlock % READ_QUEUE_DEPTH];
+        if (ActiveBackend == ReadBackend::IoUring) {
+#if HAS_IO_URING
+            while (!slot.Ready && !Error) ReapCompletion();
+#endif
+        } else {
+            std::unique_lock lock(Mutex);
+            BlockReady.wait(lock, [&] { return Error || (slot.Ready && slot.Block == NextBlock); });
+        }
+        if (Error) return false;
+        NextBlock++;
+        block = std::string_view(slot.Data.get(), slot.Filled);
+        return true;
+    }
+
+    void Close() {
+        if (ActiveBackend == ReadBackend::Threads) {
+            {
+                std::lock_guard lock(Mutex);
+                Stopping = true;
+            }
+            SlotFree.notify_all();
+            for (std::thread& reader : Readers) reader.join();
+            Readers.clear();
+        }
+#if HAS_IO_URING
+        if (ActiveBackend == ReadBackend::IoUring) {
+            // The kernel still writes into the buffers of the reads in flight, failed or not
+            DrainCompletions();
+            Ring.Close();
+            if (InFlight > 0) {
+                for (Slot& slot : Slots) (void)slot.Data.release(); // The ring can't be waited on: leaked, never freed under the kernel
+                InFlight = 0;
+            }
+        }
+#endif
+        if (File != INVALID_FILE_HANDLE) CloseReadHandle(File);
+        File = INVALID_FILE_HANDLE;
+        Stream.close();
+        for (Slot& slot : Slots) slot = {};
+        ActiveBackend = ReadBackend::Auto;
+    }
+
+private:
+    struct Slot {
+        std::unique_ptr<char[]> Data;
+        size_t Block = 0;
+        size_t Size = 0;   // Bytes wanted
+        size_t Filled = 0; // Bytes read so far
+        bool Ready = false;
+#if HAS_IO_URING
+        iovec Vec = {};
+#endif
+    };
+
+    uint64_t BlockOffset(size_t block) const { return StartOffset + static_cast<uint64_t>(block) * READ_BLOCK_SIZE; }
+    size_t BlockSize(size_t block) const { return static_cast<size_t>(std::min<uint64_t>(READ_BLOCK_SIZE, FileSize - BlockOffset(block))); }
+
+    // The consumer is done with block: its slot can receive block + READ_QUEUE_DEPTH
+    void ReleaseBlock(size_t block) {
+        if (ActiveBackend == ReadBackend::IoUring) {
+#if HAS_IO_URING
+            Slots[block % READ_QUEUE_DEPTH].Ready = false;
+            if (block + READ_QUEUE_DEPTH < BlockCount) QueueBlock(block + READ_QUEUE_DEPTH);
+#endif
+            return;
+        }
+        {
+            std::lock_guard lock(Mutex);
+            Slots[block % READ_QUEUE_DEPTH].Ready = false;
+            ReleasedBlocks = block + 1;
+        }
+        SlotFree.notify_all();
+    }
+
+#if HAS_IO_URING
+    void QueueBlock(size_t block) {
+        Slot& slot = Slots[block % READ_QUEUE_DEPTH];
+        slot.Block = block;
+        slot.Size = BlockSize(block);
+        slot.Filled = 0;
+        slot.Ready = false;
+        QueueSlotRead(slot);
+    }
+
+    void QueueSlotRead(Slot& slot) {
+        slot.Vec.iov_base = slot.Data.get() + slot.Filled;
+        slot.Vec.iov_len = slot.Size - slot.Filled;
+        Ring.PrepareRead(File, &slot.Vec, BlockOffset(slot.Block) + slot.Filled, slot.Block % READ_QUEUE_DEPTH);
+        InFlight++;
+    }
+
+    // Waits for every queued read without looking at the results (Close)
+    void DrainCompletions() {
+        uint64_t slotIndex = 0;
+        int result = 0;
+        while (InFlight > 0 && Ring.WaitCompletion(slotIndex, result)) InFlight--;
+    }
+
+    void ReapCompletion() {
+        uint64_t slotIndex = 0;
+        int result = 0;
+        if (!Ring.WaitCompletion(slotIndex, result)) {
+            Error = true;
+            return;
+        }
+        InFlight--;
+        Slot& slot = Slots[slotIndex];
+        if (result == -EINTR || result == -EAGAIN) {
+            QueueSlotRead(slot);
+        } else if (result < 0) {
+            Error = true;
+        } else if (result > 0 && slot.Filled + result < slot.Size) {
+            slot.Filled += result; // Short read (common on network file systems): read the rest
+            QueueSlotRead(slot);
+        } else {
+            slot.Filled += result; // result == 0: the file was truncated meanwhile
+            slot.Ready = true;
+        }
+    }
+#endif
+
+    // Thread t reads blocks t, t + READ_THREADS, t + 2 * READ_THREADS...
+    void ReaderLoop(int thread) {
+        for (size_t block = thread; block < BlockCount; block += READ_THREADS) {
+            Slot& slot = Slots[block % READ_QUEUE_DEPTH];
+            {
+                std::unique_lock lock(Mutex);
+                SlotFree.wait(lock, [&] { return Stopping || block < ReleasedBlocks + READ_QUEUE_DEPTH; });
+                if (Stopping) return;
+            }
+            const size_t size = BlockSize(block);
+            size_t filled = 0;
+            bool failed = false;
+            while (filled < size) {
+                const long long read = ReadAt(File, slot.Data.get() + filled, size - filled, BlockOffset(block) + filled);
+                if (read <= 0) {
+                    failed = read < 0;
+                    break;
+                }
+                filled += static_cast<size_t>(read);
+            }
+            {
+                std::lock_guard lock(Mutex);
+                slot.Block = block;
+                slot.Filled = filled;
+                slot.Ready = true;
+                if (failed) Error = true;
+            }
+            BlockReady.notify_all();
+        }
+    }
+
+    ReadBackend ActiveBackend = ReadBackend::Auto;
+    FileHandle File = INVALID_FILE_HANDLE;
+    std::ifstream Stream;
+    uint64_t FileSize = 0;
+    uint64_t StartOffset = 0;
+    size_t BlockCount = 0;
+    size_t NextBlock = 0; // Next block handed to the consumer
+    Slot Slots[READ_QUEUE_DEPTH];
+    std::atomic<bool> Error = false;
+
+#if HAS_IO_URING
+    IoUringQueue Ring;
+    int InFlight = 0;
+#endif
+
+    // Threads backend
+    std::vector<std::thread> Readers;
+    std::mutex Mutex;
+    std::condition_variable BlockReady;
+    std::condition_variable SlotFree;
+    size_t ReleasedBlocks = 0;
+    bool Stopping = false;
+};
+
+// Hands the complete lines of data to onLine (an rvalue std::string, returns false to stop),
+// the unterminated end waits in partial for the next block. Returns the bytes consumed.
+template <typename Fn>
+size_t SplitLines(std::string& partial, std::string_view data, Fn&& onLine) {
+    size_t lineStart = 0;
+    for (size_t newline = data.find('\n'); newline != std::string_view::npos; newline = data.find('\n', lineStart)) {
+        partial.append(data.substr(lineStart, newline - lineStart));
+        lineStart = newline + 1;
+        const bool more = onLine(std::move(partial));
+        partial.clear();
+        if (!more) return lineStart;
+    }
+    partial.append(data.substr(lineStart));
+    return data.size();
+}
+
+// =========================================================
+// --- BINARY FILES ---
+// Little helpers for the on-disk indexes (plain native-endian POD dumps)
+struct BinaryWriter {
+    std::ofstream File;
+
+    explicit BinaryWriter(const std::filesystem::path& path, std::ios::openmode mode = std::ios::trunc)
+        : File(path, std::ios::binary | mode) {}
+
+    template <typename T> void Write(const T& value) { File.write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+    void WriteString(const std::string& text) {
+        Write(static_cast<uint32_t>(text.size()));
+        File.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+    template <typename T> void WriteVector(const std::vector<T>& values) {
+        Write(static_cast<uint64_t>(values.size()));
+        File.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+    }
+};
+
+struct BinaryReader {
+    std::ifstream File;
+    uint64_t Size = 0;
+
+    explicit BinaryReader(const std::filesystem::path& path) : File(path, std::ios::binary) {
+        std::error_code error;
+        Size = std::filesystem::file_size(path, error);
+    }
+
+    bool Ok() const { return static_cast<bool>(File); }
+    uint64_t Remaining() {
+        const std::streamoff position = File ? static_cast<std::streamoff>(File.tellg()) : -1;
+        return position >= 0 && static_cast<uint64_t>(position) <= Size ? Size - position : 0;
+    }
+    // Sizes come from disk: a corrupt file must fail the read, not allocate gigabytes
+    bool CanRead(uint64_t count, uint64_t itemBytes = 1) {
+        if (Ok() && count <= Remaining() / itemBytes) return true;
+        File.setstate(std::ios::failbit);
+        return false;
+    }
+    template <typename T> T Read() {
+        T value{};
+        File.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return value;
+    }
+    std::string ReadString() {
+        const uint32_t length = Read<uint32_t>();
+        if (!CanRead(length)) return {};
+        std::string text(length, '\0');
+        File.read(text.data(), static_cast<std::streamsize>(text.size()));
+        return text;
+    }
+    template <typename T> std::vector<T> ReadVector() {
+        const uint64_t count = Read<uint64_t>();
+        if (!CanRead(count, sizeof(T))) return {};
+        std::vector<T> values(count);
+        File.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(count * sizeof(T)));
+        return values;
+    }
+};
+
+int64_t FileModifiedTime(const std::filesystem::path& path) {
+    std::error_code error;
+    const auto time = std::filesystem::last_write_time(path, error);
+    return error ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+// Milliseconds since epoch, like LogEntry::Timestamp
+int64_t FileModifiedTimeMs(const std::filesystem::path& path) {
+    std::error_code error;
+    const auto time = std::filesystem::last_write_time(path, error);
+    if (error) return 0;
+    // Through the current time of both clocks: clock_cast isn't available everywhere
+    const auto systemTime = std::chrono::system_clock::now() + (time - std::filesystem::file_time_type::clock::now());
+    return std::chrono::duration_cast<std::chrono::milliseconds>(systemTime.time_since_epoch()).count();
+}
+
+// =========================================================
+// --- GZIP INDEX ---
+// gzip can't be seeked, so the first pass over a .gz records decompressor checkpoints
+// (zran-style: compressed bit position + the last 32 KB of output) about every GZIP_SPAN
+// bytes of output, along with the line number there. The index is saved next to the file
+// in <file>.ulrx. From a checkpoint any byte or line range is decompressed without starting
+// over, and full passes inflate the segments between checkpoints on all cores.
+constexpr uint64_t GZIP_SPAN = 4 << 20;
+constexpr uint32_t GZIP_WINDOW = 32768;
+constexpr uint32_t GZIP_INDEX_VERSION = 3;
+constexpr size_t GZIP_INPUT_CHUNK = 1 << 16;
+
+struct GzipCheckpoint {
+    uint64_t Out = 0; // Uncompressed offset
+    uint64_t In = 0;  // Compressed offset of the first full byte
+    int32_t Bits = 0; // Bits of the byte before In that still belong to the stream (0-7)
+    int64_t Line = 0; // Newlines before Out
+    std::vector<unsigned char> Window; // Output preceding Out, the inflate dictionary
+};
+
+bool IsGzipFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    unsigned char magic[2] = {};
+    file.read(reinterpret_cast<char*>(magic), 2);
+    return file && magic[0] == 0x1f && magic[1] == 0x8b;
+}
+
+class GzipIndex {
+public:
+    std::filesystem::path Path;
+    std::vector<GzipCheckpoint> Checkpoints;
+    uint64_t TotalOut = 0;
+    int64_t TotalLines = 0;
+    std::vector<unsigned char> Synopses; // Block synopses of the parsed lines (see BLOCK SYNOPSES)
+    bool HasSynopses = false;            // Set by the first full load, Synopses are empty for a file under one block
+
+    static std::filesystem::path SidecarPath(const std::filesystem::path& path) { return path.string() + ".ulrx"; }
+
+    // Reads the sidecar, if it matches the current file. Empty on failure.
+    bool Load(const std::filesystem::path& path) {
+        Path = path;
+        if (ReadSidecar(path)) return true;
+        Checkpoints.clear();
+        Synopses.clear();
+        HasSynopses = false;
+        return false;
+    }
+
+    // Inflates the whole file, through the sidecar when there is one. Corpus and baseline scans
+    // read each file once, so no sidecar is written next to them (archives may be shared or read-only).
+    bool ReadAll(const std::filesystem::path& path, const std::function<bool(std::string_view)>& onData) {
+        if (Load(path)) return ReadFrom(0, onData);
+        return Build(path, onData);
+    }
+
+    bool Save() const {
+        std::error_code error;
+        const uint64_t size = std::filesystem::file_size(Path, error);
+        // Written aside and renamed over the sidecar, so a crash never leaves a half index behind
+        const std::filesystem::path sidecarPath = SidecarPath(Path);
+        std::filesystem::path tempPath = sidecarPath;
+        tempPath += ".tmp";
+        if (error || !WriteSidecar(tempPath, size)) {
+            std::filesystem::remove(tempPath, error);
+            return false; // Read-only share: the index only lives in memory
+        }
+        std::filesystem::rename(tempPath, sidecarPath, error);
+        if (!error) return true;
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    // First pass: inflates the whole file, records the checkpoints and hands the output to
+    // onData in order. Once onData returns false it is not called anymore, but the pass goes
+    // on so the index is complete. progress receives the compressed bytes consumed so far.
+    bool Build(const std::filesystem::path& path, const std::function<bool(std::string_view)>& onData,
+               std::atomic<uint64_t>* progress = nullptr, const std::atomic<bool>* cancel = nullptr) {
+        Path = path;
+        Checkpoints.clear();
+        Synopses.clear();
+        HasSynopses = false;
+        TotalOut = 0;
+        TotalLines = 0;
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+
+        z_stream stream = {};
+        if (inflateInit2(&stream, 47) != Z_OK) return false; // 47: gzip or zlib header, 32 KB window
+        std::vector<unsigned char> input(GZIP_INPUT_CHUNK);
+        std::vector<unsigned char> window(GZIP_WINDOW); // Circular, inflate writes straight into it
+        uint64_t totalIn = 0;
+        uint64_t lastPoint = 0;
+        bool ok = true;
+        bool done = false;
+        bool delivering = static_cast<bool>(onData);
+        stream.avail_out = 0;
+
+        while (ok && !done) {
+            file.read(reinterpret_cast<char*>(input.data()), static_cast<std::streamsize>(input.size()));
+            stream.avail_in = static_cast<uInt>(file.gcount());
+            stream.next_in = input.data();
+            if (stream.avail_in == 0) {
+                ok = Checkpoints.size() > 0 && TotalOut > 0; // Truncated file: keep what was inflated
+                break;
+            }
+            while (stream.avail_in > 0) {
+                if (stream.avail_out == 0) {
+                    stream.avail_out = GZIP_WINDOW;
+                    stream.next_out = window.data();
+                }
+                unsigned char* produced = stream.next_out;
+                totalIn += stream.avail_in;
+                TotalOut += stream.avail_out;
+                int result = inflate(&stream, Z_BLOCK);
+                totalIn -= stream.avail_in;
+                TotalOut -= stream.avail_out;
+
+                const std::string_view data(reinterpret_cast<const char*>(produced), stream.next_out - produced);
+                TotalLines += std::ranges::count(data, '\n');
+                if (!data.empty() && delivering) delivering = onData(data);
+
+                if (result == Z_STREAM_END) {
+                    // Concatenated members (multi-member gzip): go on with the next one
+                    if (stream.avail_in == 0 && file.peek() == std::char_traits<char>::eof()) {
+                        done = true;
+                        break;
+                    }
+                    inflateReset(&stream);
+                    continue;
+                }
+                if (result != Z_OK && result != Z_BUF_ERROR) {
+                    // Trailing garbage after a complete member is ignored, like gzip does
+                    ok = TotalOut > 0 && !Checkpoints.empty();
+                    done = true;
+                    break;
+                }
+
+                // End of a deflate block that is not the last one of the member: a checkpoint candidate
+                if ((stream.data_type & 128) && !(stream.data_type & 64) && (Checkpoints.empty() || TotalOut - lastPoint >= GZIP_SPAN)) {
+                    AddCheckpoint(stream.data_type & 7, totalIn, window, stream.avail_out);
+                    lastPoint = TotalOut;
+                }
+            }
+            if (progress) *progress = totalIn;
+            if (cancel && *cancel) ok = false;
+        }
+        inflateEnd(&stream);
+        return ok;
+    }
+
+    // Inflates [from, to) of the output, from the nearest checkpoint. fn may stop early by returning false.
+    bool Inflate(uint64_t from, uint64_t to, const std::function<bool(std::string_view)>& fn) const {
+        if (Checkpoints.empty() || from >= to) return from >= to;
+        const GzipCheckpoint& point = CheckpointBefore(from);
+        std::ifstream file(Path, std::ios::binary);
+        file.seekg(static_cast<std::streamoff>(point.In - (point.Bits ? 1 : 0)));
+
+        z_stream stream = {};
+        if (!file || inflateInit2(&stream, -15) != Z_OK) return false; // Raw deflate, the checkpoint is mid-stream
+        if (point.Bits) inflatePrime(&stream, point.Bits, file.get() >> (8 - point.Bits));
+        inflateSetDictionary(&stream, point.Window.data(), static_cast<uInt>(point.Window.size()));
+
+        std::vector<unsigned char> input(GZIP_INPUT_CHUNK);
+        std::vector<unsigned char> output(1 << 18);
+        auto refill = [&] {
+            if (stream.avail_in > 0) return true;
+            file.read(reinterpret_cast<char*>(input.data()), static_cast<std::streamsize>(input.size()));
+            stream.next_in = input.data();
+            stream.avail_in = static_cast<uInt>(file.gcount());
+            return stream.avail_in > 0;
+        };
+
+        uint64_t position = point.Out;
+        bool raw = true;
+        bool ok = true;
+        while (position < to && refill()) {
+            stream.next_out = output.data();
+            stream.avail_out = static_cast<uInt>(std::min<uint64_t>(output.size(), to - position));
+            const int result = inflate(&stream, Z_NO_FLUSH);
+            const size_t produced = stream.next_out - output.data();
+
+            // Only the part of [from, to) reaches fn
+            const uint64_t skip = position < from ? std::min<uint64_t>(from - position, produced) : 0;
+            position += produced;
+            if (produced > skip && !fn(std::string_view(reinterpret_cast<const char*>(output.data()) + skip, produced - skip))) break;
+
+            if (result == Z_STREAM_END) {
+                if (raw) {
+                    // The member entered mid-stream has no wrapper handling: skip its trailer (CRC32 + size)
+                    for (int trailer = 8; trailer > 0 && refill();) {
+                        const uInt skipped = std::min<uInt>(trailer, stream.avail_in);
+                        stream.next_in += skipped;
+                        stream.avail_in -= skipped;
+                        trailer -= skipped;
+                    }
+                    inflateReset2(&stream, 31);
+                    raw = false;
+                } else {
+                    inflateReset(&stream);
+                }
+            } else if (result != Z_OK && result != Z_BUF_ERROR) {
+                ok = position >= TotalOut; // Trailing garbage after the last member
+                break;
+            }
+        }
+        inflateEnd(&stream);
+        return ok;
+    }
+
+    // Copies lines [first, first + count) (every line of the file, empty ones included)
+    bool ReadLines(int64_t first, int64_t count, std::vector<std::string>& lines) const {
+        if (Checkpoints.empty()) return false;
+        const GzipCheckpoint* start = &Checkpoints.front();
+        for (const GzipCheckpoint& point : Checkpoints) {
+            if (point.Line > first) break;
+            start = &point;
+        }
+        int64_t line = start->Line;
+        std::string current;
+        return Inflate(start->Out, TotalOut, [&](std::string_view data) {
+            size_t lineStart = 0;
+            for (size_t newline = data.find('\n'); newline != std::string_view::npos; newline = data.find('\n', lineStart)) {
+                if (line >= first) {
+                    current.append(data.substr(lineStart, newline - lineStart));
+                    lines.push_back(std::move(current));
+                    current.clear();
+                    if ((int64_t)lines.size() == count) return false;
+                }
+                line++;
+                lineStart = newline + 1;
+            }
+            if (line >= first) current.append(data.substr(lineStart));
+            return true;
+        });
+    }
+
+    // Hands [from, TotalOut) to fn in order. The segments between checkpoints are inflated in
+    // parallel, a batch at a time. fn may stop early by returning false.
+    bool ReadFrom(uint64_t from, const std::function<bool(std::string_view)>& fn) const {
+        std::vector<uint64_t> bounds = {from};
+        for (const GzipCheckpoint& point : Checkpoints)
+            if (point.Out > from) bounds.push_back(point.Out);
+        bounds.push_back(TotalOut);
+
+        const int batch = static_cast<int>(g_ThreadPool.Size()) * 2;
+        for (size_t first = 0; first + 1 < bounds.size(); first += batch) {
+            const int count = static_cast<int>(std::min<size_t>(batch, bounds.size() - 1 - first));
+            std::vector<std::string> segments(count);
+            std::atomic<bool> ok = true;
+            g_ThreadPool.ParallelFor(count, 1, [&](int begin, int end) {
+                for (int n = begin; n < end; ++n) {
+                    std::string& segment = segments[n];
+                    segment.reserve(bounds[first + n + 1] - bounds[first + n]);
+                    if (!Inflate(bounds[first + n], bounds[first + n + 1], [&](std::string_view data) { segment.append(data); return true; }))
+                        ok = false;
+                }
+            });
+            for (const std::string& segment : segments)
+                if (!fn(segment)) return ok;
+            if (!ok) return false;
+        }
+        return true;
+    }
+
+private:
+    bool ReadSidecar(const std::filesystem::path& path) {
+        Checkpoints.clear();
+        Synopses.clear();
+        HasSynopses = false;
+        std::error_code error;
+        const uint64_t size = std::filesystem::file_size(path, error);
+        BinaryReader reader(SidecarPath(path));
+        if (error || !reader.Ok() || reader.Read<uint32_t>() != GZIP_INDEX_VERSION) return false;
+        if (reader.Read<uint64_t>() != size || reader.Read<int64_t>() != FileModifiedTime(path)) return false;
+        TotalOut = reader.Read<uint64_t>();
+        TotalLines = reader.Read<int64_t>();
+        const uint32_t count = reader.Read<uint32_t>();
+        constexpr uint64_t minCheckpointBytes = 40; // Fixed fields, window size and packed length
+        if (TotalLines < 0 || !reader.CanRead(count, minCheckpointBytes)) return false;
+        Checkpoints.reserve(count);
+        for (uint32_t n = 0; n < count && reader.Ok(); ++n) {
+            GzipCheckpoint point;
+            point.Out = reader.Read<uint64_t>();
+            point.In = reader.Read<uint64_t>();
+            point.Bits = reader.Read<int32_t>();
+            point.Line = reader.Read<int64_t>();
+            const uint32_t windowSize = reader.Read<uint32_t>();
+            if (!reader.Ok() || windowSize > GZIP_WINDOW || point.Bits < 0 || point.Bits > 7 || point.In > size) return false;
+            if (point.Out > TotalOut || point.Line < 0 || point.Line > TotalLines) return false;
+            // Checkpoints are in stream order: a stale or corrupt sidecar would seek to the wrong lines
+            if (!Checkpoints.empty() && (point.Out <= Checkpoints.back().Out || point.Line < Checkpoints.back().Line)) return false;
+            // Windows are stored deflated, raw they would weigh 32 KB per checkpoint
+            point.Window.resize(windowSize);
+            const std::vector<unsigned char> packed = reader.ReadVector<unsigned char>();
+            uLongf unpackedSize = static_cast<uLongf>(point.Window.size());
+            if (!reader.Ok() || uncompress(point.Window.data(), &unpackedSize, packed.data(), static_cast<uLong>(packed.size())) != Z_OK
+                || unpackedSize != windowSize)
+                return false;
+            Checkpoints.push_back(std::move(point));
+        }
+        HasSynopses = reader.Read<uint8_t>() != 0;
+        Synopses = reader.ReadVector<unsigned char>();
+        return reader.Ok() && !Checkpoints.empty();
+    }
+
+    bool WriteSidecar(const std::filesystem::path& path, uint64_t size) const {
+        BinaryWriter writer(path);
+        if (!writer.File) return false;
+        writer.Write(GZIP_INDEX_VERSION);
+        writer.Write(size);
+        writer.Write(FileModifiedTime(Path));
+        writer.Write(TotalOut);
+        writer.Write(TotalLines);
+        writer.Write(static_cast<uint32_t>(Checkpoints.size()));
+        for (const GzipCheckpoint& point : Checkpoints) {
+            writer.Write(point.Out);
+            writer.Write(point.In);
+            writer.Write(point.Bits);
+            writer.Write(point.Line);
+            std::vector<unsigned char> packed(compressBound(static_cast<uLong>(point.Window.size())));
+            uLongf packedSize = static_cast<uLongf>(packed.size());
+            compress2(packed.data(), &packedSize, point.Window.data(), static_cast<uLong>(point.Window.size()), 1);
+            packed.resize(packedSize);
+            writer.Write(static_cast<uint32_t>(point.Window.size()));
+            writer.WriteVector(packed);
+        }
+        writer.Write(static_cast<uint8_t>(HasSynopses));
+        writer.WriteVector(Synopses);
+        writer.File.flush();
+        return static_cast<bool>(writer.File);
+    }
+
+    const GzipCheckpoint& CheckpointBefore(uint64_t offset) const {
+        auto it = std::ranges::upper_bound(Checkpoints, offset, {}, &GzipCheckpoint::Out);
+        return *std::prev(it == Checkpoints.begin() ? std::next(it) : it);
+    }
+
+    // window is circular and ends at the write position of inflate (avail bytes left before wrapping)
+    void AddCheckpoint(int bits, uint64_t in, const std::vector<unsigned char>& window, unsigned avail) {
+        GzipCheckpoint point;
+        point.Out = TotalOut;
+        point.In = in;
+        point.Bits = bits;
+        point.Line = TotalLines;
+        const size_t windowSize = static_cast<size_t>(std::min<uint64_t>(TotalOut, GZIP_WINDOW));
+        std::vector<unsigned char> ordered(GZIP_WINDOW);
+        if (avail) std::copy(window.end() - avail, window.end(), ordered.begin());
+        std::copy(window.begin(), window.end() - avail, ordered.begin() + avail);
+        point.Window.assign(ordered.end() - windowSize, ordered.end());
+        Checkpoints.push_back(std::move(point));
+    }
+};
+
+// =========================================================
+// --- CASE FOLDING ---
+// Case-insensitive search folds both sides with the simple case folding of Unicode (CaseFolding.txt,
+// status C and S) instead of ::tolower, which depends on the C locale and mangles UTF-8 bytes.
+// Every script with case is covered; CJK, Hangul and the rest have none.
+// Lines are flagged as pure ASCII when parsed (LogEntry::Ascii) and those skip the decoding.
+
+inline char AsciiLower(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c; }
+
+// Eight bytes at a time, the compiler vectorizes the rest
+bool IsAsciiText(std::string_view text) {
+    size_t i = 0;
+    uint64_t high = 0;
+    for (; i + 8 <= text.size(); i += 8) {
+        uint64_t word;
+        std::memcpy(&word, text.data() + i, sizeof(word));
+        high |= word;
+    }
+    for (; i < text.size(); ++i) high |= static_cast<unsigned char>(text[i]);
+    return (high & 0x8080808080808080ull) == 0;
+}
+
+// Simple case folding of Unicode 14.0 (CaseFolding.txt, status C and S) as sorted ranges: the code
+// points First, First + Stride, ... up to Last fold to themselves plus Delta. Generated from the
+// UCD, not to be edited by hand. ASCII is folded by AsciiLower.
+struct CaseFoldRange {
+    char32_t First;
+    char32_t Last;
+    int32_t Delta;
+    int32_t Stride;
+};
+
+static constexpr CaseFoldRange CASE_FOLD_RANGES[] = {
+    {0x00B5, 0x00B5, 775, 1}, {0x00C0, 0x00D6, 32, 1}, {0x00D8, 0x00DE, 32, 1}, {0x0100, 0x012E, 1, 2},
+    {0x0132, 0x0136, 1, 2}, {0x0139, 0x0147, 1, 2}, {0x014A, 0x0176, 1, 2}, {0x0178, 0x0178, -121, 1},
+    {0x0179, 0x017D, 1, 2}, {0x017F, 0x017F, -268, 1}, {0x0181, 0x0181, 210, 1}, {0x0182, 0x0184, 1, 2},
+    {0x0186, 0x0186, 206, 1}, {0x0187, 0x0187, 1, 1}, {0x0189, 0x018A, 205, 1}, {0x018B, 0x018B, 1, 1},
+    {0x018E, 0x018E, 79, 1}, {0x018F, 0x018F, 202, 1}, {0x0190, 0x0190, 203, 1}, {0x0191, 0x0191, 1, 1},
+    {0x0193, 0x0193, 205, 1}, {0x0194, 0x0194, 207, 1}, {0x0196, 0x0196, 211, 1}, {0x0197, 0x0197, 209, 1},
+    {0x0198, 0x0198, 1, 1}, {0x019C, 0x019C, 211, 1}, {0x019D, 0x019D, 213, 1}, {0x019F, 0x019F, 214, 1},
+    {0x01A0, 0x01A4, 1, 2}, {0x01A6, 0x01A6, 218, 1}, {0x01A7, 0x01A7, 1, 1}, {0x01A9, 0x01A9, 218, 1},
+    {0x01AC, 0x01AC, 1, 1}, {0x01AE, 0x01AE, 218, 1}, {0x01AF, 0x01AF, 1, 1}, {0x01B1, 0x01B2, 217, 1},
+    {0x01B3, 0x01B5, 1, 2}, {0x01B7, 0x01B7, 219, 1}, {0x01B8, 0x01B8, 1, 1}, {0x01BC, 0x01BC, 1, 1},
+    {0x01C4, 0x01C4, 2, 1}, {0x01C5, 0x01C5, 1, 1}, {0x01C7, 0x01C7, 2, 1}, {0x01C8, 0x01C8, 1, 1},
+    {0x01CA, 0x01CA, 2, 1}, {0x01CB, 0x01DB, 1, 2}, {0x01DE, 0x01EE, 1, 2}, {0x01F1, 0x01F1, 2, 1},
+    {0x01F2, 0x01F4, 1, 2}, {0x01F6, 0x01F6, -97, 1}, {0x01F7, 0x01F7, -56, 1}, {0x01F8, 0x021E, 1, 2},
+    {0x0220, 0x0220, -130, 1}, {0x0222, 0x0232, 1, 2}, {0x023A, 0x023A, 10795, 1}, {0x023B, 0x023B, 1, 1},
+    {0x023D, 0x023D, -163, 1}, {0x023E, 0x023E, 10792, 1}, {0x0241, 0x0241, 1, 1}, {0x0243, 0x0243, -195, 1},
+    {0x0244, 0x0244, 69, 1}, {0x0245, 0x0245, 71, 1}, {0x0246, 0x024E, 1, 2}, {0x0345, 0x0345, 116, 1},
+    {0x0370, 0x0372, 1, 2}, {0x0376, 0x0376, 1, 1}, {0x037F, 0x037F, 116, 1}, {0x0386, 0x0386, 38, 1},
+    {0x0388, 0x038A, 37, 1}, {0x038C, 0x038C, 64, 1}, {0x038E, 0x038F, 63, 1}, {0x0391, 0x03A1, 32, 1},
+    {0x03A3, 0x03AB, 32, 1}, {0x03C2, 0x03C2, 1, 1}, {0x03CF, 0x03CF, 8, 1}, {0x03D0, 0x03D0, -30, 1},
+    {0x03D1, 0x03D1, -25, 1}, {0x03D5, 0x03D5, -15, 1}, {0x03D6, 0x03D6, -22, 1}, {0x03D8, 0x03EE, 1, 2},
+    {0x03F0, 0x03F0, -54, 1}, {0x03F1, 0x03F1, -48, 1}, {0x03F4, 0x03F4, -60, 1}, {0x03F5, 0x03F5, -64, 1},
+    {0x03F7, 0x03F7, 1, 1}, {0x03F9, 0x03F9, -7, 1}, {0x03FA, 0x03FA, 1, 1}, {0x03FD, 0x03FF, -130, 1},
+    {0x0400, 0x040F, 80, 1}, {0x0410, 0x042F, 32, 1}, {0x0460, 0x0480, 1, 2}, {0x048A, 0x04BE, 1, 2},
+    {0x04C0, 0x04C0, 15, 1}, {0x04C1, 0x04CD, 1, 2}, {0x04D0, 0x052E, 1, 2}, {0x0531, 0x0556, 48, 1},
+    {0x10A0, 0x10C5, 7264, 1}, {0x10C7, 0x10C7, 7264, 1}, {0x10CD, 0x10CD, 7264, 1}, {0x13F8, 0x13FD, -8, 1},
+    {0x1C80, 0x1C80, -6222, 1}, {0x1C81, 0x1C81, -6221, 1}, {0x1C82, 0x1C82, -6212, 1}, {0x1C83, 0x1C84, -6210, 1},
+    {0x1C85, 0x1C85, -6211, 1}, {0x1C86, 0x1C86, -6204, 1}, {0x1C87, 0x1C87, -6180, 1}, {0x1C88, 0x1C88, 35267, 1},
+    {0x1C90, 0x1CBA, -3008, 1}, {0x1CBD, 0x1CBF, -3008, 1}, {0x1E00, 0x1E94, 1, 2}, {0x1E9B, 0x1E9B, -58, 1},
+    {0x1E9E, 0x1E9E, -7615, 1}, {0x1EA0, 0x1EFE, 1, 2}, {0x1F08, 0x1F0F, -8, 1}, {0x1F18, 0x1F1D, -8, 1},
+    {0x1F28, 0x1F2F, -8, 1}, {0x1F38, 0x1F3F, -8, 1}, {0x1F48, 0x1F4D, -8, 1}, {0x1F59, 0x1F5F, -8, 2},
+    {0x1F68, 0x1F6F, -8, 1}, {0x1F88, 0x1F8F, -8, 1}, {0x1F98, 0x1F9F, -8, 1}, {0x1FA8, 0x1FAF, -8, 1},
+    {0x1FB8, 0x1FB9, -8, 1}, {0x1FBA, 0x1FBB, -74, 1}, {0x1FBC, 0x1FBC, -9, 1}, {0x1FBE, 0x1FBE, -7173, 1},
+    {0x1FC8, 0x1FCB, -86, 1}, {0x1FCC, 0x1FCC, -9, 1}, {0x1FD8, 0x1FD9, -8, 1}, {0x1FDA, 0x1FDB, -100, 1},
+    {0x1FE8, 0x1FE9, -8, 1}, {0x1FEA, 0x1FEB, -112, 1}, {0x1FEC, 0x1FEC, -7, 1}, {0x1FF8, 0x1FF9, -128, 1},
+    {0x1FFA, 0x1FFB, -126, 1}, {0x1FFC, 0x1FFC, -9, 1}, {0x2126, 0x2126, -7517, 1}, {0x212A, 0x212A, -8383, 1},
+    {0x212B, 0x212B, -8262, 1}, {0x2132, 0x2132, 28, 1}, {0x2160, 0x216F, 16, 1}, {0x2183, 0x2183, 1, 1},
+    {0x24B6, 0x24CF, 26, 1}, {0x2C00, 0x2C2F, 48, 1}, {0x2C60, 0x2C60, 1, 1}, {0x2C62, 0x2C62, -10743, 1},
+    {0x2C63, 0x2C63, -3814, 1}, {0x2C64, 0x2C64, -10727, 1}, {0x2C67, 0x2C6B, 1, 2}, {0x2C6D, 0x2C6D, -10780, 1},
+    {0x2C6E, 0x2C6E, -10749, 1}, {0x2C6F, 0x2C6F, -10783, 1}, {0x2C70, 0x2C70, -10782, 1}, {0x2C72, 0x2C72, 1, 1},
+    {0x2C75, 0x2C75, 1, 1}, {0x2C7E, 0x2C7F, -10815, 1}, {0x2C80, 0x2CE2, 1, 2}, {0x2CEB, 0x2CED, 1, 2},
+    {0x2CF2, 0x2CF2, 1, 1}, {0xA640, 0xA66C, 1, 2}, {0xA680, 0xA69A, 1, 2}, {0xA722, 0xA72E, 1, 2},
+    {0xA732, 0xA76E, 1, 2}, {0xA779, 0xA77B, 1, 2}, {0xA77D, 0xA77D, -35332, 1}, {0xA77E, 0xA786, 1, 2},
+    {0xA78B, 0xA78B, 1, 1}, {0xA78D, 0xA78D, -42280, 1}, {0xA790, 0xA792, 1, 2}, {0xA796, 0xA7A8, 1, 2},
+    {0xA7AA, 0xA7AA, -42308, 1}, {0xA7AB, 0xA7AB, -42319, 1}, {0xA7AC, 0xA7AC, -42315, 1},
+    {0xA7AD, 0xA7AD, -42305, 1}, {0xA7AE, 0xA7AE, -42308, 1}, {0xA7B0, 0xA7B0, -42258, 1},
+    {0xA7B1, 0xA7B1, -42282, 1}, {0xA7B2, 0xA7B2, -42261, 1}, {0xA7B3, 0xA7B3, 928, 1}, {0xA7B4, 0xA7C2, 1, 2},
+    {0xA7C4, 0xA7C4, -48, 1}, {0xA7C5, 0xA7C5, -42307, 1}, {0xA7C6, 0xA7C6, -35384, 1}, {0xA7C7, 0xA7C9, 1, 2},
+    {0xA7D0, 0xA7D0, 1, 1}, {0xA7D6, 0xA7D8, 1, 2}, {0xA7F5, 0xA7F5, 1, 1}, {0xAB70, 0xABBF, -38864, 1},
+    {0xFF21, 0xFF3A, 32, 1}, {0x10400, 0x10427, 40, 1}, {0x104B0, 0x104D3, 40, 1}, {0x10570, 0x1057A, 39, 1},
+    {0x1057C, 0x1058A, 39, 1}, {0x1058C, 0x10592, 39, 1}, {0x10594, 0x10595, 39, 1}, {0x10C80, 0x10CB2, 64, 1},
+    {0x118A0, 0x118BF, 32, 1}, {0x16E40, 0x16E5F, 32, 1}, {0x1E900, 0x1E921, 34, 1},
+};
+
+static char32_t FoldCodePoint(char32_t c) {
+    if (c < 0x80) return (c >= 'A' && c <= 'Z') ? c + 0x20 : c;
+    const auto range = std::ranges::lower_bound(CASE_FOLD_RANGES, c, {}, &CaseFoldRange::Last);
+    if (range == std::end(CASE_FOLD_RANGES) || c < range->First || (c - range->First) % range->Stride != 0) return c;
+    return static_cast<char32_t>(static_cast<int32_t>(c) + range->Delta);
+}
+
+// Length of the UTF-8 sequence at the start of text, 0 if it is malformed (overlong, surrogate, truncated)
+static size_t DecodeUtf8(std::string_view text, char32_t& c) {
+    const unsigned char lead = static_cast<unsigned char>(text[0]);
+    size_t length;
+    if (lead >= 0xC2 && lead <= 0xDF) { length = 2; c = lead & 0x1F; }
+    else if (lead >= 0xE0 && lead <= 0xEF) { length = 3; c = lead & 0x0F; }
+    else if (lead >= 0xF0 && lead <= 0xF4) { length = 4; c = lead & 0x07; }
+    else return 0;
+    if (text.size() < length) return 0;
+    for (size_t n = 1; n < length; ++n) {
+        const unsigned char next = static_cast<unsigned char>(text[n]);
+        if ((next & 0xC0) != 0x80) return 0;
+        c = (c << 6) | (next & 0x3F);
+    }
+    if ((length == 3 && (c < 0x800 || (c >= 0xD800 && c <= 0xDFFF))) || (length == 4 && (c < 0x10000 || c > 0x10FFFF)))
+        return 0;
+    return length;
+}
+
+static void AppendUtf8(std::string& out, char32_t c) {
+    if (c < 0x80) {
+        out.push_back(static_cast<char>(c));
+    } else if (c < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (c >> 6)));
+        out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    } else if (c < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (c >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (c >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    }
+}
+
+bool IsValidUtf8(std::string_view text) {
+    for (size_t i = 0; i < text.size();) {
+        if (static_cast<unsigned char>(text[i]) < 0x80) {
+            i++;
+            continue;
+        }
+        char32_t c;
+        const size_t length = DecodeUtf8(text.substr(i), c);
+        if (length == 0) return false;
+        i += length;
+    }
+    return true;
+}
+
+// Appends text with every byte that isn't part of valid UTF-8 replaced by U+FFFD
+void AppendValidUtf8(std::string& out, std::string_view text) {
+    for (size_t i = 0; i < text.size();) {
+        char32_t c;
+        const size_t length = static_cast<unsigned char>(text[i]) < 0x80 ? 1 : DecodeUtf8(text.substr(i), c);
+        if (length == 0) {
+            out += "\xEF\xBF\xBD";
+            i++;
+            continue;
+        }
+        out.append(text.substr(i, length));
+        i += length;
+    }
+}
+
+// Replaces out with the folded text. Bytes that aren't valid UTF-8 are kept as they are.
+void FoldCase(std::string_view text, std::string& out) {
+    out.clear();
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size();) {
+        if (static_cast<unsigned char>(text[i]) < 0x80) {
+            out.push_back(AsciiLower(text[i++]));
+            continue;
+        }
+        char32_t c;
+        const size_t length = DecodeUtf8(text.substr(i), c);
+        if (length == 0) {
+            out.push_back(text[i++]);
+            continue;
+        }
+        const char32_t folded = FoldCodePoint(c);
+        if (folded == c) out.append(text.substr(i, length));
+        else AppendUtf8(out, folded);
+        i += length;
+    }
+}
+
+std::string FoldCase(std::string_view text) {
+    std::string out;
+    FoldCase(text, out);
+    return out;
+}
+
+// Folded ASCII needle in ASCII text. With SSE2, 16 positions are tested at once on the first and
+// last byte of the needle (letters compared with the case bit set), and only those candidates are
+// compared in full.
+static bool FindAsciiFolded(std::string_view text, std::string_view needle) {
+    const size_t size = needle.size();
+    if (size == 0) return true;
+    if (text.size() < size) return false;
+    const auto equalAt = [&](size_t at, size_t from, size_t to) {
+        for (size_t n = from; n < to; ++n)
+            if (AsciiLower(text[at + n]) != needle[n]) return false;
+        return true;
+    };
+    size_t i = 0;
+#if HAS_SSE2
+    const auto caseBit = [](char c) { return static_cast<char>(c >= 'a' && c <= 'z' ? 0x20 : 0); };
+    const __m128i firstByte = _mm_set1_epi8(needle[0]), firstCase = _mm_set1_epi8(caseBit(needle[0]));
+    const __m128i lastByte = _mm_set1_epi8(needle[size - 1]), lastCase = _mm_set1_epi8(caseBit(needle[size - 1]));
+    for (; i + size - 1 + 16 <= text.size(); i += 16) {
+        const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i));
+        const __m128i last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i + size - 1));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(_mm_or_si128(first, firstCase), firstByte),
+            _mm_cmpeq_epi8(_mm_or_si128(last, lastCase), lastByte))));
+        for (; mask != 0; mask &= mask - 1)
+            if (equalAt(i + std::countr_zero(mask), 1, size - 1)) return true;
+    }
+#endif
+    for (; i + size <= text.size(); ++i)
+        if (equalAt(i, 0, size)) return true;
+    return false;
+}
+
+// Case-insensitive substring search with the needle folded once
+class CaseInsensitiveSearch {
+public:
+    CaseInsensitiveSearch() = default;
+    explicit CaseInsensitiveSearch(std::string_view needle) : Needle(FoldCase(needle)), NeedleAscii(IsAsciiText(Needle)) {}
+
+    bool Empty() const { return Needle.empty(); }
+    const std::string& Folded() const { return Needle; }
+
+    // ascii: the text is known to be pure ASCII, so it doesn't have to be decoded
+    bool Matches(std::string_view text, bool ascii) const {
+        if (ascii) return NeedleAscii && FindAsciiFolded(text, Needle);
+        thread_local std::string folded;
+        FoldCase(text, folded);
+        return folded.find(Needle) != std::string::npos;
+    }
+    bool Matches(std::string_view text) const { return Matches(text, IsAsciiText(text)); }
+
+private:
+    std::string Needle;
+    bool NeedleAscii = true;
+};
 
 // =========================================================
 // --- 1. DATA STRUCTURES ---
 enum class LogLevel { Display, Warning, Error };
 
-struct LogEntry {
-    std::string FullText;
-    std::string Category;
-    LogLevel Level = LogLevel::Error;
-    size_t ContentHash = 0;
-    bool IsHeader = false;
-    int LogIndex = 0;
+// Append-only storage in fixed-size segments. Growing never moves existing entries (no
+// reallocation storm when millions of lines stream in) and whole segments can be dropped
+// from the front to bound memory. All segments but the last are always full.
+// A dropped segment is kept as a spare and reused by the next push_back, so a store that
+// keeps rolling over doesn't allocate segment arrays anymore (ring behaviour).
+template <typename T, size_t SegmentSize = 65536>
+class SegmentedStore {
+public:
+    static constexpr size_t SEGMENT_SIZE = SegmentSize;
+
+    template <bool IsConst>
+    struct Iterator {
+        using Store = std::conditional_t<IsConst, const SegmentedStore, SegmentedStore>;
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
+
+        Store* Owner = nullptr;
+        size_t Index = 0;
+
+        reference operator*() const { return (*Owner)[Index]; }
+        pointer operator->() const { return &(*Owner)[Index]; }
+        Iterator& operator++() { ++Index; return *this; }
+        Iterator operator++(int) { Iterator copy = *this; ++Index; return copy; }
+        bool operator==(const Iterator& other) const { return Index == other.Index; }
+    };
+
+    size_t size() const { return Count; }
+    bool empty() const { return Count == 0; }
+    T& operator[](size_t index) { return (*Segments[index / SegmentSize])[index % SegmentSize]; }
+    const T& operator[](size_t index) const { return (*Segments[index / SegmentSize])[index % SegmentSize]; }
+    T& back() { return Segments.back()->back(); }
+
+    Iterator<false> begin() { return {this, 0}; }
+    Iterator<false> end() { return {this, Count}; }
+    Iterator<true> begin() const { return {this, 0}; }
+    Iterator<true> end() const { return {this, Count}; }
+
+    void push_back(T value) {
+        if (Count % SegmentSize == 0) {
+            if (Spare) {
+                Segments.push_back(std::move(Spare));
+            } else {
+                Segments.push_back(std::make_unique<std::vector<T>>());
+                Segments.back()->reserve(SegmentSize);
+            }
+        }
+        Segments.back()->push_back(std::move(value));
+        Count++;
+    }
+
+    void clear() {
+        Segments.clear();
+        Spare.reset();
+        Count = 0;
+    }
+
+    size_t SegmentCount() const { return Segments.size(); }
+    size_t FrontSegmentSize() const { return Segments.empty() ? 0 : Segments.front()->size(); }
+
+    // Removes the oldest SegmentSize entries; the indices of the others shift down by SegmentSize
+    void DropFrontSegment() {
+        Count -= Segments.front()->size();
+        Spare = std::move(Segments.front());
+        Spare->clear(); // Destroys the entries, keeps the capacity
+        Segments.pop_front();
+    }
+
+private:
+    std::deque<std::unique_ptr<std::vector<T>>> Segments;
+    std::unique_ptr<std::vector<T>> Spare;
+    size_t Count = 0;
+};
+
+struct LogEntry {
+    std::string FullText;
+    std::string Category;
+    LogLevel Level = LogLevel::Error;
+    uint64_t ContentHash = 0; // Fingerprint of the message (HashText), 0 for continuation lines
+    bool IsHeader = false;
+    bool Ascii = true;      // No byte above 0x7F, case-insensitive search can skip the UTF-8 folding
+    int64_t LogIndex = 0;   // Line number since the start of the file or stream (keeps counting past dropped lines)
+    int CategoryId = 0;     // Index in LogViewerState::CategoryNames
+    int MessageId = -1;     // Index in LogViewerState::MessageCounts, shared by a header and its continuation lines
+    int64_t Timestamp = 0;  // Milliseconds since epoch, 0 if the line has none
+    uint16_t SourceId = 0;  // Index in LogViewerState::SourceNames (network ingestion), 0 otherwise
+};
+
+const char* LogLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Display: return "Display";
+        case LogLevel::Warning: return "Warning";
+        case LogLevel::Error:   return "Error";
+    }
+    return "";
+}
+
+// Parses the "[2024.01.01-14.22.33:123]" prefix. Returns 0 if the line doesn't start with one.
+int64_t ParseLogTimestamp(std::string_view line) {
+    if (line.size() < 25 || line[0] != '[' || line[24] != ']') return 0;
+    int fields[7] = {};
+    const int offsets[7] = {1, 6, 9, 12, 15, 18, 21};
+    const int lengths[7] = {4, 2, 2, 2, 2, 2, 3};
+    for (int f = 0; f < 7; ++f) {
+        for (int c = 0; c < lengths[f]; ++c) {
+            const char ch = line[offsets[f] + c];
+            if (ch < '0' || ch > '9') return 0;
+            fields[f] = fields[f] * 10 + (ch - '0');
+        }
+    }
+    using namespace std::chrono;
+    const sys_days day = year{fields[0]} / month{static_cast<unsigned>(fields[1])} / fields[2];
+    return duration_cast<milliseconds>(day.time_since_epoch()).count() +
+           ((fields[3] * 60LL + fields[4]) * 60LL + fields[5]) * 1000LL + fields[6];
+}
+
+// Inverse of ParseLogTimestamp: "2024.01.01-14.22.33:123"
+std::string FormatLogTimestamp(int64_t timestamp) {
+    using namespace std::chrono;
+    const sys_days day = floor<days>(sys_time<milliseconds>(milliseconds(timestamp)));
+    const year_month_day ymd{day};
+    const int64_t msOfDay = timestamp - duration_cast<milliseconds>(day.time_since_epoch()).count();
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%04d.%02u.%02u-%02d.%02d.%02d:%03d",
+             static_cast<int>(ymd.year()), static_cast<unsigned>(ymd.month()), static_cast<unsigned>(ymd.day()),
+             static_cast<int>(msOfDay / 3600000), static_cast<int>(msOfDay / 60000 % 60),
+             static_cast<int>(msOfDay / 1000 % 60), static_cast<int>(msOfDay % 1000));
+    return buffer;
+}
+
+// =========================================================
+// --- STRUCTURED FIELDS ---
+// Our code (and UE5 structured logging) writes "Key=Value" pairs in messages:
+//   LogNet: Display: Client joined Player=123 LatencyMs=250 Map="/Game/Maps/Lobby"
+// Fields are extracted lazily, one chunk of lines at a time, into a columnar
+// side store keyed by interned field names. Extraction only happens when a field
+// predicate needs the chunk, and the result is kept for every later filter.
+constexpr int LOG_CHUNK_LINES = 4096;
+
+struct FieldColumn {
+    std::vector<int> Rows;          // Lines carrying this field, relative to the chunk start
+    std::vector<double> Numbers;    // Parsed value, NaN when the value is not numeric
+    std::vector<std::string> Texts; // Raw value text
+};
+
+struct FieldChunk {
+    int ExtractedLines = 0; // The last chunk keeps growing while a file is followed
+    std::vector<FieldColumn> Columns; // Indexed by field id
+};
+
+enum class FieldOp { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual };
+
+struct FieldPredicate {
+    int FieldId = -1;
+    FieldOp Op = FieldOp::Equal;
+    std::string Text;
+    double Number = NAN;
+};
+
+static bool IsFieldKeyChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+}
+
+// Returns NaN when the whole string is not a number
+static double ParseFieldNumber(const std::string& text) {
+    if (text.empty()) return NAN;
+    char* end = nullptr;
+    const double value = std::strtod(text.c_str(), &end);
+    return (end == text.c_str() + text.size()) ? value : NAN;
+}
+
+struct FieldStore {
+    std::unordered_map<std::string, int> FieldIds;
+    std::vector<std::string> FieldNames;
+    std::deque<FieldChunk> Chunks; // Chunk n covers lines [n * LOG_CHUNK_LINES, (n + 1) * LOG_CHUNK_LINES)
+    std::mutex Mutex; // Extraction is lazy, so filters running on other threads mutate the store
+
+    void Clear() {
+        FieldIds.clear();
+        FieldNames.clear();
+        Chunks.clear();
+    }
+
+    int InternField(std::string_view name) {
+        auto it = FieldIds.find(std::string(name));
+        if (it != FieldIds.end()) return it->second;
+        const int id = static_cast<int>(FieldNames.size());
+        FieldNames.emplace_back(name);
+        FieldIds.emplace(FieldNames.back(), id);
+        return id;
+    }
+
+    // Scans "Key=Value" / Key="quoted value" pairs of one line into the chunk columns.
+    // row is relative to the chunk, so chunks stay valid when older lines are dropped.
+    void ExtractLine(const std::string& text, int row, FieldChunk& chunk) {
+        size_t eq = text.find('=');
+        while (eq != std::string::npos) {
+            size_t keyStart = eq;
+            while (keyStart > 0 && IsFieldKeyChar(text[keyStart - 1])) keyStart--;
+
+            size_t valueStart = eq + 1;
+            size_t valueEnd = valueStart;
+            if (valueStart < text.size() && text[valueStart] == '"') {
+                valueStart++;
+                valueEnd = text.find('"', valueStart);
+                if (valueEnd == std::string::npos) valueEnd = text.size();
+            } else {
+                while (valueEnd < text.size() && !std::isspace(static_cast<unsigned char>(text[valueEnd])) &&
+                       text[valueEnd] != ',' && text[valueEnd] != ';' && text[valueEnd] != ')' && text[valueEnd] != ']') {
+                    valueEnd++;
+                }
+            }
+
+            if (keyStart < eq && !std::isdigit(static_cast<unsigned char>(text[keyStart]))) {
+                const int id = InternField(std::string_view(text).substr(keyStart, eq - keyStart));
+                if (id >= (int)chunk.Columns.size()) chunk.Columns.resize(id + 1);
+                FieldColumn& column = chunk.Columns[id];
+                std::string value = text.substr(valueStart, valueEnd - valueStart);
+                column.Rows.push_back(row);
+                column.Numbers.push_back(ParseFieldNumber(value));
+                column.Texts.push_back(std::move(value));
+            }
+            eq = text.find('=', std::max(valueEnd, eq + 1));
+        }
+    }
+
+    // Memory of the extracted columns (values are assumed to fit the small string buffer)
+    size_t ApproxBytes() const {
+        size_t bytes = 0;
+        for (const FieldChunk& chunk : Chunks) {
+            for (const FieldColumn& column : chunk.Columns)
+                bytes += column.Rows.capacity() * sizeof(int) + column.Numbers.capacity() * sizeof(double) +
+                         column.Texts.capacity() * sizeof(std::string);
+        }
+        return bytes;
+    }
+
+    template <typename Logs>
+    FieldChunk& EnsureChunk(int chunkIndex, const Logs& logs) {
+        if (chunkIndex >= (int)Chunks.size()) Chunks.resize(chunkIndex + 1);
+        FieldChunk& chunk = Chunks[chunkIndex];
+        const int start = chunkIndex * LOG_CHUNK_LINES;
+        const int end = std::min(start + LOG_CHUNK_LINES, static_cast<int>(logs.size()));
+        for (int i = start + chunk.ExtractedLines; i < end; ++i)
+            ExtractLine(logs[i].FullText, i - start, chunk);
+        chunk.ExtractedLines = std::max(chunk.ExtractedLines, end - start);
+        return chunk;
+    }
+};
+
+static bool EvalFieldPredicate(const FieldPredicate& pred, double number, const std::string& text) {
+    // Numeric comparison when both sides are numbers, text comparison otherwise
+    if (!std::isnan(pred.Number) && !std::isnan(number)) {
+        switch (pred.Op) {
+            case FieldOp::Equal:        return number == pred.Number;
+            case FieldOp::NotEqual:     return number != pred.Number;
+            case FieldOp::Less:         return number < pred.Number;
+            case FieldOp::LessEqual:    return number <= pred.Number;
+            case FieldOp::Greater:      return number > pred.Number;
+            case FieldOp::GreaterEqual: return number >= pred.Number;
+        }
+    }
+    switch (pred.Op) {
+        case FieldOp::Equal:        return text == pred.Text;
+        case FieldOp::NotEqual:     return text != pred.Text;
+        case FieldOp::Less:         return text < pred.Text;
+        case FieldOp::LessEqual:    return text <= pred.Text;
+        case FieldOp::Greater:      return text > pred.Text;
+        case FieldOp::GreaterEqual: return text >= pred.Text;
+    }
+    return false;
+}
+
+// Parses "Player=123 LatencyMs>200 Map!=\"Lobby\"" (all terms must match).
+// Returns false if a term is malformed.
+bool ParseFieldPredicates(const std::string& input, FieldStore& store, std::vector<FieldPredicate>& out) {
+    out.clear();
+    size_t pos = 0;
+    while (pos < input.size()) {
+        while (pos < input.size() && std::isspace(static_cast<unsigned char>(input[pos]))) pos++;
+        if (pos >= input.size()) break;
+
+        const size_t keyStart = pos;
+        while (pos < input.size() && IsFieldKeyChar(input[pos])) pos++;
+        if (pos == keyStart) return false;
+        const std::string_view key = std::string_view(input).substr(keyStart, pos - keyStart);
+
+        FieldPredicate pred;
+        auto consume = [&](std::string_view op) {
+            if (input.compare(pos, op.size(), op) != 0) return false;
+            pos += op.size();
+            return true;
+        };
+        if (consume(">=")) pred.Op = FieldOp::GreaterEqual;
+        else if (consume("<=")) pred.Op = FieldOp::LessEqual;
+        else if (consume("!=")) pred.Op = FieldOp::NotEqual;
+        else if (consume("==") || consume("=")) pred.Op = FieldOp::Equal;
+        else if (consume(">")) pred.Op = FieldOp::Greater;
+        else if (consume("<")) pred.Op = FieldOp::Less;
+        else return false;
+
+        if (pos < input.size() && input[pos] == '"') {
+            const size_t close = input.find('"', pos + 1);
+            if (close == std::string::npos) return false;
+            pred.Text = input.substr(pos + 1, close - pos - 1);
+            pos = close + 1;
+        } else {
+            const size_t valueStart = pos;
+            while (pos < input.size() && !std::isspace(static_cast<unsigned char>(input[pos]))) pos++;
+            pred.Text = input.substr(valueStart, pos - valueStart);
+        }
+        pred.Number = ParseFieldNumber(pred.Text);
+        pred.FieldId = store.InternField(key);
+        out.push_back(std::move(pred));
+    }
+    return true;
+}
+
+struct HighlightWidget {
+    char SearchBuffer[128] = {};
+    ImVec4 Color;
+    int NextOccurrence = 0;
+};
+
+// UE Logs usually look like:
+// [2024.01.01-14.22.33:123] LogCook: Error: Missing Texture...
+// We want to extract "LogCook" (Category) and "Error" (Level)
+void ParseLogLine(const std::string& line, LogEntry& entry) {
+    entry.FullText = line;
+    entry.Level = LogLevel::Display;
+    entry.Category = "General";
+
+    // 1. Detect Level (Simple string check is fastest)
+    if (line.find("Error:") != std::string::npos || line.find("Critical:") != std::string::npos) {
+        entry.Level = LogLevel::Error;
+    } else if (line.find("Warning:") != std::string::npos) {
+        entry.Level = LogLevel::Warning;
+    }
+
+    // 2. Detect Category (Text before the first colon, or specifically LogX)
+    // Adjust this logic based on your specific log format needs
+    size_t catStart = line.find("]Log");
+    if (catStart != std::string::npos) {
+        // Found standard UE category format like [123]LogTemp:
+        catStart++; // Skip ']'
+        const size_t catEnd = line.find(':', catStart);
+        if (catEnd != std::string::npos) {
+            entry.Category = line.substr(catStart, catEnd - catStart);
+        }
+    }
+}
+
+// FNV-1a. Unlike std::hash, stable across compilers and runs, so fingerprints can be persisted.
+uint64_t HashText(std::string_view text) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const char c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Fills level, category, fingerprint and timestamp of a "[timestamp][frame]LogX: ..." line
+void ParseHeaderLine(const std::string& line, LogEntry& entry) {
+    entry.IsHeader = true;
+
+    // --- 1. PARSE PROPERTIES ---
+    entry.Level = LogLevel::Display;
+    entry.Category = "General";
+
+    if (line.find("Error:") != std::string::npos ||
+        line.find("Critical:") != std::string::npos ||
+        line.find("Fatal:") != std::string::npos) {
+        entry.Level = LogLevel::Error;
+    }
+    else if (line.find("Warning:") != std::string::npos) {
+        entry.Level = LogLevel::Warning;
+    }
+
+    // Extract Category
+    size_t catStart = line.find("Log");
+    if (catStart != std::string::npos) {
+         // Safety check to ensure it's the category tag
+        if (catStart > 0 && (line[catStart-1] == ']' || line[catStart-1] == ' ' || line[catStart-1] == ':')) {
+            size_t catEnd = line.find(':', catStart);
+            if (catEnd != std::string::npos) {
+                entry.Category = line.substr(catStart, catEnd - catStart);
+            }
+        }
+    }
+
+    // --- 2. COMPUTE HASH (Unique ID) ---
+    // We want to hash ONLY the message, skipping the timestamp "[2024...][123]"
+    // If we find "Log", start hashing from there. Otherwise hash the whole line.
+    const std::string_view textToHash = (catStart != std::string::npos) ? std::string_view(line).substr(catStart) : std::string_view(line);
+    entry.ContentHash = HashText(textToHash);
+
+    entry.Timestamp = ParseLogTimestamp(line);
+}
+
+// Turns raw lines into entries. Continuation lines (not starting with '[') inherit the
+// level, category and timestamp of the last header line, so each input needs its own parser.
+struct LogLineParser {
+    bool ReachedSummary = false;
+    LogLevel ContinuationLevel = LogLevel::Display;
+    std::string ContinuationCategory = "General";
+    int64_t ContinuationTimestamp = 0;
+
+    // Returns false when the line produces no entry (empty line, summary and everything after it)
+    bool Parse(std::string line, LogEntry& entry) {
+        if (ReachedSummary) return false;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        // Stop at summary
+        if (line.find("Warning/Error Summary") != std::string::npos) {
+            ReachedSummary = true;
+            return false;
+        }
+        if (line.empty()) return false;
+
+        // --- 1. IDENTIFY IF HEADER OR CONTINUATION ---
+        if (line[0] == '[') {
+            // --- 2. PARSE PROPERTIES & HASH ---
+            ParseHeaderLine(line, entry);
+            entry.FullText = std::move(line);
+
+            // Update "Current" state
+            ContinuationLevel = entry.Level;
+            ContinuationCategory = entry.Category;
+            ContinuationTimestamp = entry.Timestamp;
+        }
+        else {
+            // Continuation line
+            entry.IsHeader = false;
+            entry.Level = ContinuationLevel;
+            entry.Category = ContinuationCategory;
+            entry.Timestamp = ContinuationTimestamp;
+            entry.FullText = "      " + line; // Visual indent
+            entry.ContentHash = 0; // Hash irrelevant for children, they follow parent
+        }
+        entry.Ascii = IsAsciiText(entry.FullText);
+        return true;
+    }
+};
+
+// Occurrences of each message fingerprint in a log that isn't loaded (rare messages baseline)
+using FingerprintCounts = std::unordered_map<uint64_t, uint32_t>;
+
+// Everything that decides which lines are visible. Shared by the UI and the query server.
+struct LogFilter {
+    bool ShowErrors = true;
+    bool ShowWarnings = true;
+    bool ShowDisplay = true;
+    bool ShowDuplicates = true;
+    std::vector<std::string> Categories; // Empty = every category
+    std::string Search;
+    std::string Fields; // Structured field predicates, see ParseFieldPredicates
+    int SourceId = -1;  // -1 = every source
+    int MaxOccurrences = -1; // Rare messages only: seen at most this many times, -1 = every message
+    std::shared_ptr<const FingerprintCounts> Baseline; // Occurrences counted in this log instead of the loaded one
+    int64_t FromTime = 0; // Lines timestamped in [FromTime, ToTime), ms since epoch, 0 = unbounded.
+    int64_t ToTime = 0;   // With a bound set, lines without a timestamp don't pass.
+};
+
+// Bounds the memory of endless follow / stream / network sessions. Limits are checked after
+// every append and the oldest segments of AllLogs are dropped as a whole. 0 = no limit.
+struct RetentionPolicy {
+    size_t MaxLines = 0;  // Keeps at least the MaxLines most recent lines
+    size_t MaxBytes = 0;  // Approximate memory of the retained lines (text + entry)
+    int64_t MaxAgeMs = 0; // Segments whose newest line was received longer ago are dropped
+
+    bool IsSet() const { return MaxLines > 0 || MaxBytes > 0 || MaxAgeMs > 0; }
+};
+
+// Per-segment bookkeeping of the retention policy, parallel to the AllLogs segments
+struct SegmentUsage {
+    size_t Bytes = 0;
+    int64_t LastAppendMs = 0; // Wall clock (ms since epoch) of the newest line
+};
+
+// Duplicate tracking of a filter pass, kept between incremental passes
+struct FilterScan {
+    std::set<uint64_t> SeenHashes;
+    bool SkippingDuplicates = false;
+};
+
+// =========================================================
+// --- BLOCK SYNOPSES ---
+// Every LOG_BLOCK_BYTES of lines get a synopsis: the levels and categories present, the time
+// range and a bloom filter of the byte trigrams of the case folded text (FoldCase). A filter
+// pass skips the blocks whose synopsis proves no line can pass, without a full trigram index:
+// a synopsis weighs under 1% of the text it covers. Blocks are closed as lines arrive; the lines
+// after the last one are always scanned. Synopses of a .gz are kept in its GzipIndex sidecar.
+constexpr size_t LOG_BLOCK_BYTES = 64 << 10;
+constexpr int BLOCK_BLOOM_BITS = 4096; // One hash: the optimum for the number of trigrams in 64 KB
+
+inline uint32_t BlockTrigramBit(uint32_t trigram) { return (trigram * 0x9E3779B1u) >> 20; }
+
+// What a filter requires of a block for any of its lines to pass
+struct BlockProbe {
+    uint32_t Levels = 0b111;               // Bit per LogLevel
+    uint64_t Categories = ~0ull;           // Bit CategoryId % 64
+    int64_t FromTime = 0;                  // Timestamps in [FromTime, ToTime), 0 = unbounded
+    int64_t ToTime = 0;
+    std::vector<uint16_t> TrigramBits;     // Bloom bits of the folded search text
+
+    void SetSearch(std::string_view folded) {
+        uint32_t trigram = 0;
+        for (size_t i = 0; i < folded.size(); ++i) {
+            trigram = ((trigram << 8) | static_cast<unsigned char>(folded[i])) & 0xFFFFFF;
+            if (i >= 2) TrigramBits.push_back(static_cast<uint16_t>(BlockTrigramBit(trigram)));
+        }
+        std::ranges::sort(TrigramBits);
+        TrigramBits.erase(std::unique(TrigramBits.begin(), TrigramBits.end()), TrigramBits.end());
+    }
+};
+
+// Plain data, so it is stored as is in the sidecar
+struct BlockSynopsis {
+    std::array<uint64_t, BLOCK_BLOOM_BITS / 64> Trigrams{};
+    uint64_t Categories = 0;
+    int64_t MinTimestamp = INT64_MAX; // Of the lines that have one
+    int64_t MaxTimestamp = INT64_MIN;
+    int FirstLine = 0;                // Index in AllLogs
+    int LineCount = 0;
+    uint32_t Levels = 0;
+    uint32_t Reserved = 0;            // Explicit padding, so no uninitialized byte reaches the sidecar
+
+    bool MayMatch(const BlockProbe& probe) const {
+        if (!(Levels & probe.Levels) || !(Categories & probe.Categories)) return false;
+        if (probe.FromTime != 0 || probe.ToTime != 0) {
+            if (MinTimestamp > MaxTimestamp) return false; // Lines without a timestamp never pass a time range
+            if (probe.FromTime != 0 && MaxTimestamp < probe.FromTime) return false;
+            if (probe.ToTime != 0 && MinTimestamp >= probe.ToTime) return false;
+        }
+        for (const uint16_t bit : probe.TrigramBits)
+            if (!(Trigrams[bit >> 6] & (1ull << (bit & 63)))) return false;
+        return true;
+    }
+};
+
+static_assert(std::has_unique_object_representations_v<BlockSynopsis>, "BlockSynopsis has padding bytes");
+
+// Builds the synopsis of consecutive lines. Bloom bits are set as bytes, cheaper than read-modify-write of bits.
+struct BlockSynopsisBuilder {
+    BlockSynopsis Block;
+    std::array<uint8_t, BLOCK_BLOOM_BITS> TrigramBytes{};
+
+    void Add(LogLevel level, int categoryId, int64_t timestamp, std::string_view text, bool ascii) {
+        Block.Levels |= 1u << static_cast<int>(level);
+        Block.Categories |= 1ull << (categoryId & 63);
+        if (timestamp != 0) {
+            Block.MinTimestamp = std::min(Block.MinTimestamp, timestamp);
+            Block.MaxTimestamp = std::max(Block.MaxTimestamp, timestamp);
+        }
+        thread_local std::string folded;
+        if (!ascii) {
+            FoldCase(text, folded);
+            text = folded;
+        }
+        if (text.size() < 3) return;
+        uint32_t trigram = (static_cast<unsigned char>(AsciiLower(text[0])) << 8) | static_cast<unsigned char>(AsciiLower(text[1]));
+        for (size_t i = 2; i < text.size(); ++i) {
+            trigram = ((trigram << 8) | static_cast<unsigned char>(AsciiLower(text[i]))) & 0xFFFFFF;
+            TrigramBytes[BlockTrigramBit(trigram)] = 1;
+        }
+    }
+
+    const BlockSynopsis& Finish() {
+        for (int bit = 0; bit < BLOCK_BLOOM_BITS; ++bit)
+            Block.Trigrams[bit >> 6] |= static_cast<uint64_t>(TrigramBytes[bit]) << (bit & 63);
+        return Block;
+    }
+};
+
+// Dense ids of message fingerprints, in order of first insertion. Open addressing over a flat
+// array: a log can have millions of distinct messages and a node per entry would dominate loading.
+class FingerprintIndex {
+public:
+    // Id of the fingerprint, the next id if it is new (added is then true)
+    int Insert(uint64_t fingerprint, bool& added) {
+        if ((static_cast<size_t>(Count) + 1) * 4 > Slots.size() * 3) Grow();
+        const size_t mask = Slots.size() - 1;
+        for (size_t slot = Home(fingerprint);; slot = (slot + 1) & mask) {
+            if (Slots[slot].Id < 0) {
+                Slots[slot] = {fingerprint, Count};
+                added = true;
+                return Count++;
+            }
+            if (Slots[slot].Fingerprint == fingerprint) {
+                added = false;
+                return Slots[slot].Id;
+            }
+        }
+    }
+
+    size_t size() const { return static_cast<size_t>(Count); }
+    size_t ApproxBytes() const { return Slots.capacity() * sizeof(Slot); }
+    void Clear() {
+        std::vector<Slot>().swap(Slots);
+        Count = 0;
+        Bits = 0;
+    }
+
+private:
+    struct Slot {
+        uint64_t Fingerprint = 0;
+        int Id = -1;
+    };
+    std::vector<Slot> Slots;
+    int Count = 0;
+    int Bits = 0; // Slots.size() == 1 << Bits
+
+    // Fibonacci hashing: the top bits of the product mix all the bits of the fingerprint
+    size_t Home(uint64_t fingerprint) const { return static_cast<size_t>((fingerprint * 0x9E3779B97F4A7C15ull) >> (64 - Bits)); }
+
+    void Grow() {
+        std::vector<Slot> old = std::move(Slots);
+        Bits = std::max(Bits + 1, 10);
+        Slots.assign(size_t(1) << Bits, Slot{});
+        const size_t mask = Slots.size() - 1;
+        for (const Slot& entry : old) {
+            if (entry.Id < 0) continue;
+            size_t slot = Home(entry.Fingerprint);
+            while (Slots[slot].Id >= 0) slot = (slot + 1) & mask;
+            Slots[slot] = entry;
+        }
+    }
+};
+
+// Consecutive repeats of a message (same fingerprint), as AllLogs lines. A message is its
+// header and its continuation lines. Only runs of 2 messages or more are recorded.
+struct MessageRun {
+    int First = 0;   // Header of the first message
+    int Second = 0;  // Header of the second message, the collapsible part starts there
+    int End = 0;     // One past the last line of the last message
+    int Repeats = 0; // Messages in the run
+};
+
+// A run as seen through the filtered view. Its rows [HiddenBegin, HiddenEnd) of FilteredIndices
+// fold into the row of the first message (Head) while runs are collapsed.
+struct RunView {
+    int Run = 0;          // Index in LogViewerState::Runs
+    int Head = 0;
+    int HiddenBegin = 0;
+    int HiddenEnd = 0;
+    int Hidden = 0;       // Rows folded, 0 when the run is expanded
+    int HiddenBefore = 0; // Rows folded by the previous runs
+};
+
+struct LogViewerState {
+    SegmentedStore<LogEntry> AllLogs;
+    std::vector<int> FilteredIndices; // Indices of logs that match current filters
+
+    std::map<LogLevel, int> LevelsCount; // Number of logs of each LogLevel
+
+    std::set<int> SelectedIndices; // Stores indices of the *filtered* list
+    int LastClickedIndex = -1;     // Used for Shift+Click ranges
+
+    // Filters
+    bool ShowErrors = true;
+    bool ShowWarnings = true;
+    bool ShowDisplay = true;
+    char SearchBuffer[128] = "";
+    std::set<std::string> SelectedCategories; // Empty = every category
+    int SelectedSource = -1;
+    std::vector<std::string> CategoryNames; // Interned categories, indexed by LogEntry::CategoryId
+    std::unordered_map<std::string, int> CategoryIds;
+    std::vector<int> CategoryCounts;        // Lines of each category since the load, by CategoryId
+    std::vector<int> SortedCategories;      // CategoryIds in name order (category picker)
+
+    bool ShowDuplicates = true;
+
+    // Rare messages: fingerprints seen at most RareMaxCount times, in the baseline log when one is set
+    bool RareOnly = false;
+    int RareMaxCount = 1;
+    std::shared_ptr<const FingerprintCounts> Baseline;
+    std::string BaselineName;
+
+    // Structured field filter ("Player=123 LatencyMs>200")
+    char FieldFilterBuffer[128] = "";
+    bool FieldFilterValid = true;
+    FieldStore Fields;
+
+    std::string FilePath;   // Currently loaded file
+    bool Compressed = false; // FilePath is a .gz (read through GzipIndex, can't be followed)
+    std::vector<std::string> SourceNames = {"file"}; // Indexed by LogEntry::SourceId
+    int LoadGeneration = 0; // Incremented by every load, lets panels refresh derived data
+    std::set<uint64_t> NewFingerprints; // Warning/Error fingerprints never seen in the trend database
+
+    LogLineParser Parser; // Parsing state carried from line to line
+
+    // Follow mode
+    bool Follow = false;
+    uint64_t FollowOffset = 0;        // Bytes of FilePath already parsed
+    std::string PartialLine;          // Unterminated last line (follow and stream modes)
+    FilterScan LiveFilterScan;        // Lets appended lines be filtered incrementally
+
+    // Retention: the oldest segments are dropped once a limit is exceeded. Derived data is
+    // rebased per dropped segment (see RebaseDroppedLines), never rebuilt from the lines.
+    RetentionPolicy Retention;
+    std::deque<SegmentUsage> SegmentUsages;
+    size_t RetainedBytes = 0;
+    int64_t NextLogIndex = 0;
+    int64_t DroppedLines = 0;        // Total dropped since the last load
+    int64_t DroppedFilteredRows = 0; // Rows removed from the front of FilteredIndices by retention
+    uint64_t FilterGeneration = 0;   // Incremented when FilteredIndices is rebuilt rather than appended to
+    std::unordered_set<int64_t> ExpandedLines; // LogIndex of the very long lines shown in full
+    int64_t WidestLine = -1;         // LogIndex of the longest line, sizes the horizontal scrollbar
+    size_t WidestLineBytes = 0;
+    std::vector<BlockSynopsis> Blocks; // By FirstLine, see CloseBlocks
+    int BlockEnd = 0;                // Lines before it are covered by Blocks
+
+    // Collapsed repeats (uniq -c): the runs are found while loading, the filtered view only
+    // locates them, so collapsing is a mapping between displayed and filtered rows.
+    std::vector<MessageRun> Runs;
+    int LastHeaderLine = -1;           // Extends the last run
+    std::vector<RunView> FilteredRuns; // Runs with folded rows, by Head
+    size_t IndexedRuns = 0;            // Runs already located in FilteredRuns
+    int HiddenRunRows = 0;
+    std::unordered_set<int64_t> ExpandedRuns; // LogIndex of the first header of expanded runs
+    uint64_t CollapseGeneration = 0;   // Incremented when collapsed rows change other than by appending
+
+    // Message frequency table: one MessageId per distinct fingerprint, counted as lines are added
+    FingerprintIndex MessageIds;
+    std::vector<uint64_t> MessageFingerprints; // By MessageId
+    std::vector<int> MessageCounts;            // Occurrences among the retained lines, by MessageId
+    std::vector<int64_t> MessageFirstLines;    // LogIndex of the first occurrence, by MessageId
+    uint64_t MessageCountsGeneration = 0;      // Incremented when the messages are numbered again (reload)
+    std::vector<int> ChangedMessages;          // Counted since the rare filter cache last looked
+    std::vector<uint8_t> MessageChanged;       // By MessageId: in ChangedMessages
+
+    // "Rare" filter verdicts by MessageId, kept across passes for the same threshold and baseline.
+    // Shared by the filter passes of the UI and of the query server.
+    struct RareFilterCache {
+        std::mutex Mutex;
+        int MaxOccurrences = -1; // -1 = not computed
+        std::shared_ptr<const FingerprintCounts> Baseline;
+        uint64_t Generation = 0; // MessageCountsGeneration of Matches
+        std::vector<uint8_t> Matches;
+    } RareCache;
+
+    // Held exclusively while AllLogs is rebuilt, shared by readers on other threads (query server)
+    std::shared_mutex DataMutex;
+
+    static void ParseProperties(LogEntry& entry) {
+        // 1. Default values
+        entry.Level = LogLevel::Display;
+        entry.Category = "General";
+
+        // 2. Detect Level
+        // We look for "Error:" or "Critical:" anywhere in the text
+        if (entry.FullText.find("Error:") != std::string::npos ||
+            entry.FullText.find("Critical:") != std::string::npos ||
+            entry.FullText.find("Fatal:") != std::string::npos) {
+            entry.Level = LogLevel::Error;
+            }
+        else if (entry.FullText.find("Warning:") != std::string::npos) {
+            entry.Level = LogLevel::Warning;
+        }
+
+        // 3. Detect Category
+        // Tries to find the pattern "]LogX:" or "> LogX:"
+        size_t catStart = entry.FullText.find("Log");
+        if (catStart != std::string::npos) {
+            // Check if it is preceded by ']' or '> ' or ' '
+            if (catStart > 0 && (entry.FullText[catStart-1] == ']' || entry.FullText[catStart-1] == ' ' || entry.FullText[catStart-1] == ':')) {
+                size_t catEnd = entry.FullText.find(':', catStart);
+                if (catEnd != std::string::npos) {
+                    entry.Category = entry.FullText.substr(catStart, catEnd - catStart);
+                }
+            }
+        }
+    }
+
+   void LoadFile(const std::string& path, ReadBackend backend = ReadBackend::Auto) {
+        std::unique_lock dataLock(DataMutex);
+        Reset();
+
+        if (IsGzipFile(path)) {
+            // Uses the checkpoints of a previous pass to inflate on all cores, builds them otherwise
+            GzipIndex index;
+            auto append = [&](std::string_view data) {
+                AppendBytes(data);
+                return !Parser.ReachedSummary;
+            };
+            const bool indexed = index.Load(path);
+            if (indexed) {
+                if (index.HasSynopses && !LoadBlocks(index.Synopses, index.TotalLines)) index.HasSynopses = false;
+                index.ReadFrom(0, append);
+            }
+            const bool built = !indexed && index.Build(path, append);
+            if (!PartialLine.empty() && !Parser.ReachedSummary) AppendLine(std::move(PartialLine));
+            PartialLine.clear();
+            if ((indexed || built) && !index.HasSynopses) { // First full load of this file
+                CloseBlocks();
+                index.Synopses = SaveBlocks();
+                index.HasSynopses = true;
+                index.Save();
+            }
+            Compressed = true;
+        } else if (backend == ReadBackend::Stream) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file.is_open()) return;
+
+            std::string line;
+            while (!Parser.ReachedSummary && std::getline(file, line)) {
+                AppendLine(line);
+            }
+            file.clear();
+            FollowOffset = static_cast<uint64_t>(file.tellg());
+        } else {
+            // Blocks are parsed while the following ones are still being read
+            FileBlockReader reader;
+            if (!reader.Open(path, backend)) return;
+
+            std::string_view block;
+            while (!Parser.ReachedSummary && reader.Next(block)) {
+                FollowOffset += AppendBytes(block);
+            }
+            if (!PartialLine.empty() && !Parser.ReachedSummary) {
+                AppendLine(std::move(PartialLine)); // Last line without a newline
+            }
+            PartialLine.clear();
+        }
+
+        FilePath = path;
+        LoadGeneration++;
+        ApplyFilters();
+    }
+
+    void Reset() {
+        AllLogs.clear();
+        {
+            std::lock_guard lock(Fields.Mutex);
+            Fields.Clear();
+        }
+        LevelsCount.clear();
+        CategoryNames.clear();
+        CategoryIds.clear();
+        CategoryCounts.clear();
+        SortedCategories.clear();
+        Parser = {};
+        SourceNames = {"file"};
+        SelectedSource = -1;
+        Compressed = false;
+        FollowOffset = 0;
+        PartialLine.clear();
+        SegmentUsages.clear();
+        RetainedBytes = 0;
+        NextLogIndex = 0;
+        DroppedLines = 0;
+        DroppedFilteredRows = 0;
+        FilterGeneration++;
+        ExpandedLines.clear();
+        WidestLine = -1;
+        WidestLineBytes = 0;
+        Blocks.clear();
+        BlockEnd = 0;
+        Runs.clear();
+        LastHeaderLine = -1;
+        FilteredRuns.clear();
+        IndexedRuns = 0;
+        HiddenRunRows = 0;
+        ExpandedRuns.clear();
+        CollapseGeneration++;
+        MessageIds.Clear();
+        MessageFingerprints.clear();
+        MessageCounts.clear();
+        MessageFirstLines.clear();
+        MessageCountsGeneration++;
+        ChangedMessages.clear();
+        MessageChanged.clear();
+    }
+
+    // Memory of the lines and of what is derived from them, as counted by the memory budget
+    size_t ApproxMemoryBytes() {
+        size_t bytes = RetainedBytes + FilteredIndices.capacity() * sizeof(int) +
+                       LiveFilterScan.SeenHashes.size() * 48 + // Tree node + hash
+                       Runs.capacity() * sizeof(MessageRun) + FilteredRuns.capacity() * sizeof(RunView) +
+                       MessageIds.ApproxBytes() + MessageCounts.capacity() * (sizeof(uint64_t) + sizeof(int) + sizeof(int64_t)) +
+                       Blocks.capacity() * sizeof(BlockSynopsis);
+        std::lock_guard lock(Fields.Mutex);
+        return bytes + Fields.ApproxBytes();
+    }
+
+    // Parses one raw line at the end of AllLogs
+    void AppendLine(std::string line) {
+        LogEntry entry;
+        if (Parser.Parse(std::move(line), entry)) AddEntry(std::move(entry));
+    }
+
+    // Appends an already parsed entry (CategoryId and LogIndex are assigned here)
+    void AddEntry(LogEntry entry) {
+        entry.LogIndex = NextLogIndex++;
+        entry.CategoryId = InternCategory(entry.Category);
+        if (entry.FullText.size() > WidestLineBytes) {
+            WidestLineBytes = entry.FullText.size();
+            WidestLine = entry.LogIndex;
+        }
+        LevelsCount[entry.Level]++;
+        CategoryCounts[entry.CategoryId]++;
+        const int line = static_cast<int>(AllLogs.size());
+        if (entry.IsHeader) {
+            bool added;
+            entry.MessageId = MessageIds.Insert(entry.ContentHash, added);
+            if (added) {
+                MessageFingerprints.push_back(entry.ContentHash);
+                MessageCounts.push_back(0);
+                MessageFirstLines.push_back(entry.LogIndex);
+                MessageChanged.push_back(0);
+            }
+            CountMessage(entry.MessageId, 1);
+        } else if (LastHeaderLine >= 0) {
+            entry.MessageId = AllLogs[LastHeaderLine].MessageId;
+        }
+        if (entry.IsHeader) {
+            if (LastHeaderLine >= 0 && AllLogs[LastHeaderLine].ContentHash == entry.ContentHash) {
+                if (!Runs.empty() && Runs.back().End == line) {
+                    Runs.back().Repeats++;
+                    Runs.back().End = line + 1;
+                } else {
+                    Runs.push_back({LastHeaderLine, line, line + 1, 2});
+                }
+            }
+            LastHeaderLine = line;
+        } else if (!Runs.empty() && Runs.back().End == line) {
+            Runs.back().End = line + 1; // Continuation of the last repeat
+        }
+        if (AllLogs.size() % AllLogs.SEGMENT_SIZE == 0) SegmentUsages.emplace_back();
+        const size_t bytes = sizeof(LogEntry) + entry.FullText.size() + entry.Category.size();
+        SegmentUsages.back().Bytes += bytes;
+        RetainedBytes += bytes;
+        AllLogs.push_back(std::move(entry));
+    }
+
+    // Follow mode (tail -f): parses what was written to FilePath since the last call.
+    // Returns the index of the first new line; equal to AllLogs.size() when nothing arrived.
+    int PollFollowedFile() {
+        if (Compressed) return static_cast<int>(AllLogs.size());
+        std::error_code error;
+        const uint64_t size = std::filesystem::file_size(FilePath, error);
+        if (error || size == FollowOffset) return static_cast<int>(AllLogs.size());
+        if (size < FollowOffset) {
+            // Truncated or rotated: start over, everything loaded now is history
+            LoadFile(FilePath);
+            return static_cast<int>(AllLogs.size());
+        }
+
+        std::ifstream file(FilePath, std::ios::binary);
+        file.seekg(static_cast<std::streamoff>(FollowOffset));
+        std::string appended(size - FollowOffset, '\0');
+        file.read(appended.data(), static_cast<std::streamsize>(appended.size()));
+        appended.resize(static_cast<size_t>(file.gcount()));
+        FollowOffset += appended.size();
+
+        return AppendText(appended);
+    }
+
+    // Parses a block of raw bytes (any split, lines may straddle blocks) at the end of AllLogs,
+    // then applies the retention limit and filters the new lines.
+    // Returns the index of the first new line; equal to AllLogs.size() when no line was completed.
+    int AppendText(std::string_view bytes) {
+        std::unique_lock dataLock(DataMutex);
+        const int firstNewLine = static_cast<int>(AllLogs.size());
+        AppendBytes(bytes);
+        return FinishAppend(firstNewLine);
+    }
+
+    // End of a stream: appends its last line when it had no newline, same contract as AppendText
+    int FlushPartialLine() {
+        std::unique_lock dataLock(DataMutex);
+        const int firstNewLine = static_cast<int>(AllLogs.size());
+        if (!PartialLine.empty() && !Parser.ReachedSummary) AppendLine(std::move(PartialLine));
+        PartialLine.clear();
+        return FinishAppend(firstNewLine);
+    }
+
+    // Parses the complete lines of bytes, the unterminated end is kept in PartialLine.
+    // Stops after the summary line. Returns the number of bytes consumed.
+    size_t AppendBytes(std::string_view bytes) {
+        return SplitLines(PartialLine, bytes, [&](std::string&& line) {
+            AppendLine(std::move(line));
+            return !Parser.ReachedSummary;
+        });
+    }
+
+    // Appends entries parsed on other threads (network ingestion, progressive loading),
+    // same contract as AppendText. Loading a file doesn't apply the retention policy.
+    int AppendEntries(std::vector<LogEntry>& entries, bool applyRetention = true) {
+        std::unique_lock dataLock(DataMutex);
+        const int firstNewLine = static_cast<int>(AllLogs.size());
+        for (LogEntry& entry : entries) AddEntry(std::move(entry));
+        return FinishAppend(firstNewLine, applyRetention);
+    }
+
+    // Filters the lines appended from firstNewLine, then applies the retention policy.
+    // Returns the index of the first new line after retention. DataMutex must be held.
+    int FinishAppend(int firstNewLine, bool applyRetention = true) {
+        if (firstNewLine == (int)AllLogs.size()) return firstNewLine;
+
+        // Only the new lines go through the filters
+        CloseBlocks();
+        RunFilter(CurrentFilter(), FilteredIndices, firstNewLine, LiveFilterScan);
+        IndexFilteredRuns(false);
+
+        const int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        for (size_t n = firstNewLine / AllLogs.SEGMENT_SIZE; n < SegmentUsages.size(); ++n)
+            SegmentUsages[n].LastAppendMs = now;
+
+        const int dropped = applyRetention ? ApplyRetention(now) : 0;
+        return std::max(0, firstNewLine - dropped);
+    }
+
+    // An idle input gets no FinishAppend: its lines must still age out. Same contract as AppendText.
+    int ExpireOldLines() {
+        std::unique_lock dataLock(DataMutex);
+        if (Retention.MaxAgeMs > 0) {
+            ApplyRetention(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+        }
+        return static_cast<int>(AllLogs.size());
+    }
+
+    // Drops the oldest segments while the policy asks for it (the one being filled stays).
+    // Returns the number of lines dropped. DataMutex must be held.
+    int ApplyRetention(int64_t now) {
+        int dropped = 0;
+        while (Retention.IsSet() && AllLogs.SegmentCount() > 1 && ShouldDropFrontSegment(now)) {
+            dropped += static_cast<int>(AllLogs.FrontSegmentSize());
+            RetainedBytes -= SegmentUsages.front().Bytes;
+            SegmentUsages.pop_front();
+            for (size_t line = 0; line < AllLogs.FrontSegmentSize(); ++line) {
+                if (AllLogs[line].IsHeader) CountMessage(AllLogs[line].MessageId, -1);
+            }
+            AllLogs.DropFrontSegment();
+        }
+        if (dropped > 0) RebaseDroppedLines(dropped);
+        return dropped;
+    }
+
+    bool ShouldDropFrontSegment(int64_t now) const {
+        if (Retention.MaxLines > 0 && AllLogs.size() - AllLogs.FrontSegmentSize() >= Retention.MaxLines) return true;
+        if (Retention.MaxBytes > 0 && RetainedBytes > Retention.MaxBytes) return true;
+        if (Retention.MaxAgeMs > 0 && SegmentUsages.front().LastAppendMs < now - Retention.MaxAgeMs) return true;
+        return false;
+    }
+
+    // The first `dropped` lines (whole segments) are gone and every line index moved down by
+    // `dropped`. Field chunks are chunk-relative and just dropped; the filtered view loses its
+    // prefix and is shifted in one pass. The duplicate tracking (LiveFilterScan) is kept, so
+    // repeats of a dropped message stay hidden, as they were before the drop.
+    void RebaseDroppedLines(int dropped) {
+        static_assert(decltype(AllLogs)::SEGMENT_SIZE % LOG_CHUNK_LINES == 0, "Segments must hold whole field chunks");
+        DroppedLines += dropped;
+        {
+            std::lock_guard lock(Fields.Mutex);
+            const size_t chunks = std::min<size_t>(dropped / LOG_CHUNK_LINES, Fields.Chunks.size());
+            Fields.Chunks.erase(Fields.Chunks.begin(), Fields.Chunks.begin() + chunks);
+        }
+
+        const auto kept = std::ranges::lower_bound(FilteredIndices, dropped);
+        const int removedRows = static_cast<int>(kept - FilteredIndices.begin());
+        FilteredIndices.erase(FilteredIndices.begin(), kept);
+        for (int& index : FilteredIndices) index -= dropped;
+        DroppedFilteredRows += removedRows;
+
+        // The selection refers to rows of the filtered view
+        std::set<int> selected;
+        for (int row : SelectedIndices) {
+            if (row >= removedRows) selected.insert(selected.end(), row - removedRows);
+        }
+        SelectedIndices.swap(selected);
+        LastClickedIndex = (LastClickedIndex >= removedRows) ? LastClickedIndex - removedRows : -1;
+
+        // Runs in the dropped lines are forgotten, the repeats left of one cut by the drop still form a run
+        Runs.erase(Runs.begin(), std::ranges::find_if(Runs, [&](const MessageRun& run) { return run.End > dropped; }));
+        if (!Runs.empty() && Runs.front().First < dropped) {
+            MessageRun& run = Runs.front();
+            run.Repeats = 0;
+            for (int line = dropped; line < run.End; ++line) {
+                if (!AllLogs[line - dropped].IsHeader) continue;
+                if (run.Repeats == 0) run.First = line;
+                else if (run.Repeats == 1) run.Second = line;
+                run.Repeats++;
+            }
+            if (run.Repeats < 2) Runs.erase(Runs.begin());
+        }
+        for (MessageRun& run : Runs) {
+            run.First -= dropped;
+            run.Second -= dropped;
+            run.End -= dropped;
+        }
+        LastHeaderLine = (LastHeaderLine >= dropped) ? LastHeaderLine - dropped : -1;
+        IndexFilteredRuns(true);
+
+        // A block cut by the drop keeps its synopsis: it still covers every line left
+        Blocks.erase(Blocks.begin(), std::ranges::find_if(Blocks, [&](const BlockSynopsis& block) { return block.FirstLine + block.LineCount > dropped; }));
+        for (BlockSynopsis& block : Blocks) {
+            const int first = std::max(0, block.FirstLine - dropped);
+            block.LineCount -= first - (block.FirstLine - dropped);
+            block.FirstLine = first;
+        }
+        BlockEnd = std::max(0, BlockEnd - dropped);
+    }
+
+    // Closes the blocks completed by the lines added since the last call and computes their
+    // synopses on the pool. The open block stays below LOG_BLOCK_BYTES, summing it again is cheap.
+    void CloseBlocks() {
+        const size_t first = Blocks.size();
+        size_t bytes = 0;
+        for (int line = BlockEnd; line < (int)AllLogs.size(); ++line) {
+            bytes += AllLogs[line].FullText.size() + 1;
+            if (bytes < LOG_BLOCK_BYTES) continue;
+            BlockSynopsis& block = Blocks.emplace_back();
+            block.FirstLine = BlockEnd;
+            block.LineCount = line + 1 - BlockEnd;
+            BlockEnd = line + 1;
+            bytes = 0;
+        }
+        g_ThreadPool.ParallelFor(static_cast<int>(Blocks.size() - first), 1, [&](int begin, int end) {
+            for (int b = begin; b < end; ++b) {
+                BlockSynopsisBuilder builder;
+                builder.Block = Blocks[first + b];
+                for (int line = builder.Block.FirstLine; line < builder.Block.FirstLine + builder.Block.LineCount; ++line) {
+                    const LogEntry& log = AllLogs[line];
+                    builder.Add(log.Level, log.CategoryId, log.Timestamp, log.FullText, log.Ascii);
+                }
+                Blocks[first + b] = builder.Finish();
+            }
+        });
+    }
+
+    // Synopses for a GzipIndex sidecar
+    std::vector<unsigned char> SaveBlocks() const {
+        std::vector<unsigned char> bytes(Blocks.size() * sizeof(BlockSynopsis));
+        std::memcpy(bytes.data(), Blocks.data(), bytes.size());
+        return bytes;
+    }
+
+    // Takes the synopses of a sidecar before the lines are loaded, they are not computed again.
+    // Blocks must follow each other from line 0 and end by maxLines; otherwise nothing is taken.
+    bool LoadBlocks(const std::vector<unsigned char>& bytes, int64_t maxLines) {
+        if (bytes.size() % sizeof(BlockSynopsis) != 0) return false;
+        std::vector<BlockSynopsis> blocks(bytes.size() / sizeof(BlockSynopsis));
+        std::memcpy(blocks.data(), bytes.data(), bytes.size());
+        int64_t end = 0;
+        for (const BlockSynopsis& block : blocks) {
+            if (block.FirstLine != end || block.LineCount <= 0) return false;
+            end += block.LineCount;
+        }
+        if (end > maxLines) return false;
+        Blocks = std::move(blocks);
+        BlockEnd = static_cast<int>(end);
+        return true;
+    }
+
+    // Synopsis of the block holding line, nullptr when the line isn't in a closed block
+    const BlockSynopsis* FindBlock(int line) const {
+        const auto next = std::ranges::upper_bound(Blocks, line, {}, &BlockSynopsis::FirstLine);
+        if (next == Blocks.begin()) return nullptr;
+        const BlockSynopsis& block = *(next - 1);
+        return line < block.FirstLine + block.LineCount ? &block : nullptr;
+    }
+
+    // Locates the runs in FilteredIndices. Without rebuild, only the runs that appeared or grew
+    // since the last call (the last one) are located: rows were appended to FilteredIndices.
+    // A run is only collapsed when the row of its first message passes the filters.
+    void IndexFilteredRuns(bool rebuild) {
+        size_t first = 0;
+        if (rebuild) {
+            FilteredRuns.clear();
+            HiddenRunRows = 0;
+            CollapseGeneration++;
+        } else {
+            first = (IndexedRuns > 0) ? IndexedRuns - 1 : 0;
+            while (!FilteredRuns.empty() && FilteredRuns.back().Run >= (int)first) {
+                HiddenRunRows -= FilteredRuns.back().Hidden;
+                FilteredRuns.pop_back();
+            }
+        }
+        for (size_t r = first; r < Runs.size(); ++r) {
+            const MessageRun& run = Runs[r];
+            const auto head = std::lower_bound(FilteredIndices.begin(), FilteredIndices.end(), run.First);
+            if (head == FilteredIndices.end() || *head >= run.Second) continue;
+            const auto hiddenBegin = std::lower_bound(head, FilteredIndices.end(), run.Second);
+            const auto hiddenEnd = std::lower_bound(hiddenBegin, FilteredIndices.end(), run.End);
+            if (hiddenBegin == hiddenEnd) continue;
+
+            RunView view;
+            view.Run = static_cast<int>(r);
+            view.Head = static_cast<int>(head - FilteredIndices.begin());
+            view.HiddenBegin = static_cast<int>(hiddenBegin - FilteredIndices.begin());
+            view.HiddenEnd = static_cast<int>(hiddenEnd - FilteredIndices.begin());
+            view.Hidden = ExpandedRuns.contains(AllLogs[run.First].LogIndex) ? 0 : view.HiddenEnd - view.HiddenBegin;
+            view.HiddenBefore = HiddenRunRows;
+            HiddenRunRows += view.Hidden;
+            FilteredRuns.push_back(view);
+        }
+        IndexedRuns = Runs.size();
+    }
+
+    // Folds or unfolds one run (index in FilteredRuns)
+    void ToggleRunExpanded(int view) {
+        RunView& toggled = FilteredRuns[view];
+        const int64_t key = AllLogs[Runs[toggled.Run].First].LogIndex;
+        if (!ExpandedRuns.erase(key)) ExpandedRuns.insert(key);
+        const int hidden = ExpandedRuns.contains(key) ? 0 : toggled.HiddenEnd - toggled.HiddenBegin;
+        const int delta = hidden - toggled.Hidden;
+        toggled.Hidden = hidden;
+        for (size_t n = view + 1; n < FilteredRuns.size(); ++n) FilteredRuns[n].HiddenBefore += delta;
+        HiddenRunRows += delta;
+        CollapseGeneration++;
+    }
+
+    int CollapsedRowCount() const { return static_cast<int>(FilteredIndices.size()) - HiddenRunRows; }
+
+    // Row of FilteredIndices shown at a collapsed row
+    int CollapsedToFiltered(int row) const {
+        // Last run whose folded rows start at or before the row, in collapsed rows
+        const auto next = std::upper_bound(FilteredRuns.begin(), FilteredRuns.end(), row,
+            [](int r, const RunView& view) { return r < view.HiddenBegin - view.HiddenBefore; });
+        if (next == FilteredRuns.begin()) return row;
+        const RunView& view = *std::prev(next);
+        return row + view.HiddenBefore + view.Hidden;
+    }
+
+    // Collapsed row showing a row of FilteredIndices (the run's first message if it is folded)
+    int FilteredToCollapsed(int row) const {
+        const auto next = std::upper_bound(FilteredRuns.begin(), FilteredRuns.end(), row,
+            [](int r, const RunView& view) { return r < view.HiddenBegin; });
+        if (next == FilteredRuns.begin()) return row;
+        const RunView& view = *std::prev(next);
+        if (row < view.HiddenBegin + view.Hidden) return view.Head - view.HiddenBefore;
+        return row - view.HiddenBefore - view.Hidden;
+    }
+
+    // Index in FilteredRuns of the run headed by a filtered row, -1 if none
+    int FindRunView(int row) const {
+        const auto it = std::lower_bound(FilteredRuns.begin(), FilteredRuns.end(), row,
+            [](const RunView& view, int r) { return view.Head < r; });
+        return (it != FilteredRuns.end() && it->Head == row) ? static_cast<int>(it - FilteredRuns.begin()) : -1;
+    }
+
+    LogFilter CurrentFilter() const {
+        LogFilter filter;
+        filter.ShowErrors = ShowErrors;
+        filter.ShowWarnings = ShowWarnings;
+        filter.ShowDisplay = ShowDisplay;
+        filter.ShowDuplicates = ShowDuplicates;
+        filter.Categories.assign(SelectedCategories.begin(), SelectedCategories.end());
+        filter.SourceId = SelectedSource;
+        filter.Search = SearchBuffer;
+        filter.Fields = FieldFilterBuffer;
+        filter.MaxOccurrences = RareOnly ? RareMaxCount : -1;
+        filter.Baseline = Baseline;
+        return filter;
+    }
+
+    void ApplyFilters() {
+        FilteredIndices.clear();
+        FilterGeneration++;
+        SelectedIndices.clear();
+        LastClickedIndex = -1;
+        LiveFilterScan = {};
+        CloseBlocks();
+        FieldFilterValid = RunFilter(CurrentFilter(), FilteredIndices, 0, LiveFilterScan);
+        IndexFilteredRuns(true);
+    }
+
+    bool RunFilter(const LogFilter& filter, std::vector<int>& out) {
+        FilterScan scan;
+        return RunFilter(filter, out, 0, scan);
+    }
+
+    // Appends the indices of the lines from begin matching the filter to out.
+    // scan carries the duplicate tracking over, so new lines can be filtered without the old ones.
+    // Returns false if the field predicates are malformed (they are then ignored).
+    bool RunFilter(const LogFilter& filter, std::vector<int>& out, int begin, FilterScan& scan) {
+        const CaseInsensitiveSearch search(filter.Search);
+
+        std::set<uint64_t>& seenHashes = scan.SeenHashes;
+        bool& isSkippingDuplicates = scan.SkippingDuplicates;
+
+        std::vector<FieldPredicate> fieldPredicates;
+        bool fieldsValid;
+        {
+            std::lock_guard lock(Fields.Mutex);
+            fieldsValid = ParseFieldPredicates(filter.Fields, Fields, fieldPredicates);
+        }
+        if (!fieldsValid) fieldPredicates.clear();
+
+        // Per-chunk result of the field predicates, computed the first time a line of the chunk reaches it
+        std::vector<uint8_t> fieldMatches;
+        int fieldMatchesChunk = -1;
+
+        // Selected categories by CategoryId, empty = every category
+        std::vector<uint8_t> categoryMatches;
+        if (!filter.Categories.empty()) {
+            categoryMatches.assign(CategoryNames.size(), 0);
+            for (const std::string& category : filter.Categories) {
+                if (auto it = CategoryIds.find(category); it != CategoryIds.end()) categoryMatches[it->second] = 1;
+            }
+        }
+
+        // Rare messages by MessageId. Counts are taken when the pass runs: lines already shown stay
+        // when their message becomes more frequent, until the filter is applied again.
+        std::unique_lock rareLock(RareCache.Mutex, std::defer_lock);
+        const std::vector<uint8_t>* rareMatches = nullptr;
+        if (filter.MaxOccurrences >= 0) {
+            rareLock.lock();
+            rareMatches = &UpdateRareCache(filter);
+        }
+
+        // Blocks whose synopsis proves that no line passes are skipped. Their headers still go
+        // through the duplicate tracking when duplicates are hidden.
+        BlockProbe probe;
+        probe.Levels = (filter.ShowDisplay ? 1u << static_cast<int>(LogLevel::Display) : 0) |
+                       (filter.ShowWarnings ? 1u << static_cast<int>(LogLevel::Warning) : 0) |
+                       (filter.ShowErrors ? 1u << static_cast<int>(LogLevel::Error) : 0);
+        if (!filter.Categories.empty()) {
+            probe.Categories = 0;
+            for (size_t id = 0; id < categoryMatches.size(); ++id)
+                if (categoryMatches[id]) probe.Categories |= 1ull << (id & 63);
+        }
+        probe.FromTime = filter.FromTime;
+        probe.ToTime = filter.ToTime;
+        probe.SetSearch(search.Folded());
+        const bool timeRange = filter.FromTime != 0 || filter.ToTime != 0;
+        const BlockSynopsis* firstBlock = FindBlock(begin);
+        size_t block = firstBlock ? firstBlock - Blocks.data() : Blocks.size();
+        int blockEnd = begin; // First line after the current block
+        bool skipBlock = false;
+
+        for (int i = begin; i < AllLogs.size(); ++i) {
+            if (i == blockEnd) { // Blocks cover the lines from 0 without gaps
+                while (block < Blocks.size() && Blocks[block].FirstLine + Blocks[block].LineCount <= i) block++;
+                const bool closed = block < Blocks.size();
+                skipBlock = closed && !Blocks[block].MayMatch(probe);
+                blockEnd = closed ? Blocks[block].FirstLine + Blocks[block].LineCount : INT_MAX;
+            }
+            if (skipBlock && filter.ShowDuplicates) {
+                i = std::min(blockEnd, static_cast<int>(AllLogs.size())) - 1;
+                continue;
+            }
+            const auto& log = AllLogs[i];
+
+            // --- DUPLICATE HANDLING ---
+            // Only tracked when duplicates are hidden: toggling the option re-runs the whole filter
+            if (log.IsHeader && !filter.ShowDuplicates) {
+                // If this is a header, check if we've seen it before
+                if (seenHashes.contains(log.ContentHash)) {
+                    isSkippingDuplicates = true; // Start skipping this entire block
+                } else {
+                    isSkippingDuplicates = false; // Valid unique entry, stop skipping
+                    seenHashes.insert(log.ContentHash);
+                }
+            }
+
+            // If we are currently inside a duplicate block (Header + its children), skip
+            if (isSkippingDuplicates || skipBlock) continue;
+
+
+            // --- STANDARD FILTERS ---
+            if (log.Level == LogLevel::Error && !filter.ShowErrors) continue;
+            if (log.Level == LogLevel::Warning && !filter.ShowWarnings) continue;
+            if (log.Level == LogLevel::Display && !filter.ShowDisplay) continue;
+            if (!filter.Categories.empty() && (log.CategoryId >= (int)categoryMatches.size() || !categoryMatches[log.CategoryId])) continue;
+            if (filter.SourceId >= 0 && log.SourceId != filter.SourceId) continue;
+            if (rareMatches && (log.MessageId < 0 || !(*rareMatches)[log.MessageId])) continue;
+            if (timeRange && (log.Timestamp == 0 || log.Timestamp < filter.FromTime || (filter.ToTime != 0 && log.Timestamp >= filter.ToTime))) continue;
+
+            if (!search.Empty() && !search.Matches(log.FullText, log.Ascii)) continue;
+
+            if (!fieldPredicates.empty()) {
+                const int chunkIndex = i / LOG_CHUNK_LINES;
+                if (chunkIndex != fieldMatchesChunk) {
+                    ComputeFieldMatches(chunkIndex, fieldPredicates, fieldMatches);
+                    fieldMatchesChunk = chunkIndex;
+                }
+                if (!fieldMatches[i - chunkIndex * LOG_CHUNK_LINES]) continue;
+            }
+
+            out.push_back(i);
+        }
+        return fieldsValid;
+    }
+
+    // Brings RareCache to the threshold and baseline of filter. Only the messages counted since
+    // the last call are looked at again, unless the key changed. RareCache.Mutex must be held.
+    const std::vector<uint8_t>& UpdateRareCache(const LogFilter& filter) {
+        RareFilterCache& cache = RareCache;
+        auto matches = [&](int message) -> uint8_t { return MessageOccurrences(message, filter.Baseline.get()) <= filter.MaxOccurrences; };
+        if (cache.MaxOccurrences != filter.MaxOccurrences || cache.Baseline != filter.Baseline || cache.Generation != MessageCountsGeneration) {
+            cache.MaxOccurrences = filter.MaxOccurrences;
+            cache.Baseline = filter.Baseline;
+            cache.Generation = MessageCountsGeneration;
+            cache.Matches.resize(MessageCounts.size());
+            for (size_t message = 0; message < cache.Matches.size(); ++message) cache.Matches[message] = matches(static_cast<int>(message));
+        } else {
+            cache.Matches.resize(MessageCounts.size()); // New messages are in ChangedMessages
+            for (int message : ChangedMessages) cache.Matches[message] = matches(message);
+        }
+        for (int message : ChangedMessages) MessageChanged[message] = 0;
+        ChangedMessages.clear();
+        return cache.Matches;
+    }
+
+    void CountMessage(int message, int delta) {
+        MessageCounts[message] += delta;
+        if (!MessageChanged[message]) {
+            MessageChanged[message] = 1;
+            ChangedMessages.push_back(message);
+        }
+    }
+
+    // Occurrences of a message, in the baseline log when there is one
+    int MessageOccurrences(int message, const FingerprintCounts* baseline) const {
+        if (!baseline) return MessageCounts[message];
+        const auto it = baseline->find(MessageFingerprints[message]);
+        return it != baseline->end() ? static_cast<int>(it->second) : 0;
+    }
+
+    int InternCategory(const std::string& category) {
+        auto it = CategoryIds.find(category);
+        if (it != CategoryIds.end()) return it->second;
+        const int id = static_cast<int>(CategoryNames.size());
+        CategoryNames.push_back(category);
+        CategoryIds.emplace(category, id);
+        CategoryCounts.push_back(0);
+        SortedCategories.insert(std::ranges::upper_bound(SortedCategories, category, {}, [&](int other) -> const std::string& { return CategoryNames[other]; }), id);
+        return id;
+    }
+
+    // Evaluates all predicates against the typed columns of one chunk (1 = line matches)
+    void ComputeFieldMatches(int chunkIndex, const std::vector<FieldPredicate>& predicates, std::vector<uint8_t>& matches) {
+        std::lock_guard lock(Fields.Mutex);
+        const FieldChunk& chunk = Fields.EnsureChunk(chunkIndex, AllLogs);
+        const int start = chunkIndex * LOG_CHUNK_LINES;
+        const int count = std::min(LOG_CHUNK_LINES, static_cast<int>(AllLogs.size()) - start);
+
+        std::vector<uint8_t> termMatches(count);
+        matches.assign(count, 1);
+        for (const auto& pred : predicates) {
+            std::ranges::fill(termMatches, 0);
+            if (pred.FieldId < (int)chunk.Columns.size()) {
+                const FieldColumn& column = chunk.Columns[pred.FieldId];
+                for (size_t n = 0; n < column.Rows.size(); ++n) {
+                    if (EvalFieldPredicate(pred, column.Numbers[n], column.Texts[n]))
+                        termMatches[column.Rows[n]] = 1;
+                }
+            }
+            for (int n = 0; n < count; ++n) matches[n] &= termMatches[n];
+        }
+    }
+};
+
+// =========================================================
+// --- AGGREGATION QUERIES ---
+// Small query language for the "Query" panel:
+//   count by category, hour where level = Error
+//   count by fingerprint where category = LogCook
+// Group keys: level, category, fingerprint, day, hour, minute.
+// Conditions: level/category/fingerprint with = or !=, joined by "and".
+// Execution is batch-at-a-time (LOG_CHUNK_LINES rows): each batch first builds a
+// selection vector from the conditions, then a key vector, then updates a
+// thread-local hash table. The per-thread tables are merged at the end.
+enum class QueryKey { Level, Category, Fingerprint, Day, Hour, Minute };
+
+struct QueryCondition {
+    QueryKey Key = QueryKey::Level;
+    bool Negate = false;
+    int64_t Value = 0; // Level, category id or fingerprint
+};
+
+struct AggregationQuery {
+    std::vector<QueryKey> GroupBy;
+    std::vector<QueryCondition> Where;
+};
+
+struct QueryGroupKey {
+    uint64_t Fingerprint = 0;
+    uint64_t Packed = 0; // level (2 bits) | category (20 bits) | time bucket (42 bits)
+
+    bool operator==(const QueryGroupKey&) const = default;
+};
+
+struct QueryGroupKeyHash {
+    size_t operator()(const QueryGroupKey& key) const {
+        return std::hash<uint64_t>{}(key.Fingerprint * 0x9E3779B97F4A7C15ull ^ key.Packed);
+    }
+};
+
+struct QueryGroup {
+    int64_t Count = 0;
+    int FirstLine = 0; // Sample line, used to display level/category/fingerprint/time
+};
+
+struct QueryResultRow {
+    std::vector<std::string> Cells; // One per group key
+    int64_t Count = 0;
+    int64_t FirstLogIndex = 0; // Sample line, resolved through DroppedLines when displayed
+};
+
+struct QueryResult {
+    std::vector<std::string> Columns;
+    std::vector<QueryResultRow> Rows;
+    std::string Error;
+    double ElapsedMs = 0.0;
+};
+
+static std::vector<std::string> TokenizeQuery(const std::string& text) {
+    std::vector<std::string> tokens;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        const char c = text[pos];
+        if (std::isspace(static_cast<unsigned char>(c))) { pos++; continue; }
+        if (c == ',' || c == '=') { tokens.emplace_back(1, c); pos++; continue; }
+        if (c == '!' && pos + 1 < text.size() && text[pos + 1] == '=') { tokens.emplace_back("!="); pos += 2; continue; }
+        if (c == '"') {
+            const size_t close = text.find('"', pos + 1);
+            const size_t end = (close == std::string::npos) ? text.size() : close;
+            tokens.push_back(text.substr(pos + 1, end - pos - 1));
+            pos = end + 1;
+            continue;
+        }
+        const size_t start = pos;
+        while (pos < text.size() && !std::isspace(static_cast<unsigned char>(text[pos])) &&
+               text[pos] != ',' && text[pos] != '=' && text[pos] != '!') pos++;
+        tokens.push_back(text.substr(start, pos - start));
+    }
+    return tokens;
+}
+
+static std::string ToLowerCopy(std::string text) {
+    std::ranges::transform(text, text.begin(), AsciiLower);
+    return text;
+}
+
+static bool ParseQueryKey(const std::string& token, QueryKey& key) {
+    const std::string name = ToLowerCopy(token);
+    if (name == "level") key = QueryKey::Level;
+    else if (name == "category") key = QueryKey::Category;
+    else if (name == "fingerprint") key = QueryKey::Fingerprint;
+    else if (name == "day") key = QueryKey::Day;
+    else if (name == "hour") key = QueryKey::Hour;
+    else if (name == "minute") key = QueryKey::Minute;
+    else return false;
+    return true;
+}
+
+static const char* QueryKeyName(QueryKey key) {
+    switch (key) {
+        case QueryKey::Level:       return "Level";
+        case QueryKey::Category:    return "Category";
+        case QueryKey::Fingerprint: return "Fingerprint";
+        case QueryKey::Day:         return "Day";
+        case QueryKey::Hour:        return "Hour";
+        case QueryKey::Minute:      return "Minute";
+    }
+    return "";
+}
+
+static int64_t TimeBucketMs(QueryKey key) {
+    switch (key) {
+        case QueryKey::Day:    return 24LL * 3600 * 1000;
+        case QueryKey::Hour:   return 3600LL * 1000;
+        case QueryKey::Minute: return 60LL * 1000;
+        default:               return 0;
+    }
+}
+
+bool ParseAggregationQuery(const std::string& text, const LogViewerState& state, AggregationQuery& query, std::string& error) {
+    query = {};
+    const std::vector<std::string> tokens = TokenizeQuery(text);
+    size_t pos = 0;
+    auto peek = [&](const char* word) { return pos < tokens.size() && ToLowerCopy(tokens[pos]) == word; };
+
+    if (!peek("count")) { error = "Query must start with 'count'"; return false; }
+    pos++;
+
+    if (peek("by")) {
+        pos++;
+        do {
+            QueryKey key;
+            if (pos >= tokens.size() || !ParseQueryKey(tokens[pos], key)) {
+                error = "Unknown group key '" + (pos < tokens.size() ? tokens[pos] : std::string()) + "'";
+                return false;
+            }
+            if (TimeBucketMs(key) != 0 && std::ranges::any_of(query.GroupBy, [](QueryKey k) { return TimeBucketMs(k) != 0; })) {
+                error = "Only one of day/hour/minute can be grouped on";
+                return false;
+            }
+            query.GroupBy.push_back(key);
+            pos++;
+        } while (pos < tokens.size() && tokens[pos] == "," && ++pos);
+    }
+
+    if (peek("where")) {
+        pos++;
+        do {
+            if (pos + 3 > tokens.size()) { error = "Incomplete condition"; return false; }
+            QueryCondition cond;
+            if (!ParseQueryKey(tokens[pos], cond.Key) || TimeBucketMs(cond.Key) != 0) {
+                error = "Cannot filter on '" + tokens[pos] + "'";
+                return false;
+            }
+            if (tokens[pos + 1] != "=" && tokens[pos + 1] != "!=") { error = "Expected = or !="; return false; }
+            cond.Negate = tokens[pos + 1] == "!=";
+            const std::string& value = tokens[pos + 2];
+            if (cond.Key == QueryKey::Level) {
+                const std::string level = ToLowerCopy(value);
+                if (level == "error") cond.Value = static_cast<int64_t>(LogLevel::Error);
+                else if (level == "warning") cond.Value = static_cast<int64_t>(LogLevel::Warning);
+                else if (level == "display") cond.Value = static_cast<int64_t>(LogLevel::Display);
+                else { error = "Unknown level '" + value + "'"; return false; }
+            } else if (cond.Key == QueryKey::Category) {
+                auto it = state.CategoryIds.find(value);
+                cond.Value = (it != state.CategoryIds.end()) ? it->second : -1;
+            } else {
+                cond.Value = static_cast<int64_t>(std::strtoull(value.c_str(), nullptr, 16));
+            }
+            query.Where.push_back(cond);
+            pos += 3;
+        } while (peek("and") && ++pos);
+    }
+
+    if (pos != tokens.size()) { error = "Unexpected '" + tokens[pos] + "'"; return false; }
+    return true;
+}
+
+QueryResult RunAggregationQuery(const AggregationQuery& query, const LogViewerState& state) {
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto& logs = state.AllLogs;
+    const int lineCount = static_cast<int>(logs.size());
+    const int batchCount = (lineCount + LOG_CHUNK_LINES - 1) / LOG_CHUNK_LINES;
+
+    bool byLevel = false, byCategory = false, byFingerprint = false;
+    int64_t bucketMs = 0;
+    for (QueryKey key : query.GroupBy) {
+        byLevel |= key == QueryKey::Level;
+        byCategory |= key == QueryKey::Category;
+        byFingerprint |= key == QueryKey::Fingerprint;
+        if (TimeBucketMs(key) != 0) bucketMs = TimeBucketMs(key);
+    }
+
+    using GroupTable = std::unordered_map<QueryGroupKey, QueryGroup, QueryGroupKeyHash>;
+    std::vector<GroupTable> partials(batchCount);
+
+    g_ThreadPool.ParallelFor(batchCount, 1, [&](int batchBegin, int batchEnd) {
+        std::vector<int> selection;
+        std::vector<QueryGroupKey> keys;
+        for (int batch = batchBegin; batch < batchEnd; ++batch) {
+            const int start = batch * LOG_CHUNK_LINES;
+            const int end = std::min(lineCount, start + LOG_CHUNK_LINES);
+
+            // 1. Selection vector
+            // Continuation lines have no fingerprint of their own, they only count for the other keys
+            selection.clear();
+            for (int i = start; i < end; ++i) {
+                if (!byFingerprint || logs[i].IsHeader) selection.push_back(i);
+            }
+            for (const QueryCondition& cond : query.Where) {
+                std::erase_if(selection, [&](int i) {
+                    const LogEntry& log = logs[i];
+                    int64_t value = 0;
+                    if (cond.Key == QueryKey::Level) value = static_cast<int64_t>(log.Level);
+                    else if (cond.Key == QueryKey::Category) value = log.CategoryId;
+                    else value = static_cast<int64_t>(log.ContentHash);
+                    return (value == cond.Value) == cond.Negate;
+                });
+            }
+
+            // 2. Key vector
+            keys.resize(selection.size());
+            for (size_t n = 0; n < selection.size(); ++n) {
+                const LogEntry& log = logs[selection[n]];
+                QueryGroupKey& key = keys[n];
+                key.Fingerprint = byFingerprint ? log.ContentHash : 0;
+                const uint64_t level = byLevel ? static_cast<uint64_t>(log.Level) : 0;
+                const uint64_t category = byCategory ? static_cast<uint64_t>(log.CategoryId) & 0xFFFFF : 0;
+                const uint64_t bucket = bucketMs ? static_cast<uint64_t>(log.Timestamp / bucketMs) & 0x3FFFFFFFFFFull : 0;
+                key.Packed = level | (category << 2) | (bucket << 22);
+            }
+
+            // 3. Hash aggregation into the batch table
+            GroupTable& table = partials[batch];
+            for (size_t n = 0; n < keys.size(); ++n) {
+                auto [it, inserted] = table.try_emplace(keys[n]);
+                if (inserted) it->second.FirstLine = selection[n];
+                it->second.Count++;
+            }
+        }
+    });
+
+    GroupTable merged;
+    for (GroupTable& table : partials) {
+        for (const auto& [key, group] : table) {
+            auto [it, inserted] = merged.try_emplace(key, group);
+            if (!inserted) it->second.Count += group.Count;
+        }
+    }
+
+    QueryResult result;
+    for (QueryKey key : query.GroupBy) result.Columns.push_back(QueryKeyName(key));
+    result.Rows.reserve(merged.size());
+    for (const auto& [key, group] : merged) {
+        QueryResultRow row;
+        row.Count = group.Count;
+        const LogEntry& sample = logs[group.FirstLine];
+        row.FirstLogIndex = sample.LogIndex;
+        for (QueryKey column : query.GroupBy) {
+            char buffer[64];
+            switch (column) {
+                case QueryKey::Level:
+                    row.Cells.push_back(LogLevelName(sample.Level));
+                    break;
+                case QueryKey::Category:
+                    row.Cells.push_back(state.CategoryNames[sample.CategoryId]);
+                    break;
+                case QueryKey::Fingerprint:
+                    snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(sample.ContentHash));
+                    row.Cells.push_back(buffer);
+                    break;
+                default: {
+                    if (sample.Timestamp == 0) { row.Cells.push_back("-"); break; }
+                    // "YYYY.MM.DD" for days, "YYYY.MM.DD-HH.MM" for hours and minutes
+                    const std::string text = FormatLogTimestamp(sample.Timestamp / bucketMs * bucketMs);
+                    row.Cells.push_back(text.substr(0, column == QueryKey::Day ? 10 : 16));
+                    break;
+                }
+            }
+        }
+        result.Rows.push_back(std::move(row));
+    }
+    std::ranges::sort(result.Rows, [](const QueryResultRow& a, const QueryResultRow& b) { return a.Count > b.Count; });
+
+    result.ElapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    return result;
+}
+
+// =========================================================
+// --- LOCAL QUERY SERVER ---
+// Optional HTTP server bound to 127.0.0.1 so scripts can query the log that is
+// already loaded in the viewer. Every endpoint streams NDJSON (one JSON object per line):
+//   GET /count?errors=1&warnings=0&category=LogNet&search=timeout&fields=LatencyMs>200&rare=3
+//   GET /filter?<same parameters>&offset=0&limit=1000
+//   GET /lines?from=100&to=200
+//   GET /query?q=count by category where level = Error
+// Filtering runs through LogViewerState::RunFilter, the same engine as ApplyFilters.
+// e.g.: curl "http://127.0.0.1:8765/count?display=0"
+// Bytes that are not valid UTF-8 become U+FFFD, JSON parsers reject them
+static void AppendJsonString(std::string& out, std::string_view text) {
+    out += '"';
+    for (size_t i = 0; i < text.size(); ++i) {
+        const char c = text[i];
+        if (static_cast<unsigned char>(c) >= 0x80) {
+            char32_t decoded;
+            const size_t length = DecodeUtf8(text.substr(i), decoded);
+            if (length == 0) {
+                out += "\xEF\xBF\xBD";
+            } else {
+                out.append(text.substr(i, length));
+                i += length - 1;
+            }
+            continue;
+        }
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+static std::string UrlDecode(std::string_view text) {
+    std::string out;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '+') {
+            out += ' ';
+        } else if (text[i] == '%' && i + 2 < text.size() && std::isxdigit(static_cast<unsigned char>(text[i + 1])) &&
+                   std::isxdigit(static_cast<unsigned char>(text[i + 2]))) {
+            out += static_cast<char>(std::stoi(std::string(text.substr(i + 1, 2)), nullptr, 16));
+            i += 2;
+        } else {
+            out += text[i];
+        }
+    }
+    return out;
+}
+
+struct HttpRequest {
+    std::string Path;
+    std::map<std::string, std::string> Params;
+
+    std::string Get(const std::string& name, const std::string& fallback = "") const {
+        auto it = Params.find(name);
+        return it != Params.end() ? it->second : fallback;
+    }
+    long long GetInt(const std::string& name, long long fallback) const {
+        auto it = Params.find(name);
+        return it != Params.end() ? std::atoll(it->second.c_str()) : fallback;
+    }
+};
+
+// Parses "GET /path?a=1&b=2 HTTP/1.1". Only GET is supported.
+static bool ParseHttpRequestLine(const std::string& head, HttpRequest& request) {
+    if (head.rfind("GET ", 0) != 0) return false;
+    const size_t targetEnd = head.find(' ', 4);
+    if (targetEnd == std::string::npos) return false;
+    const std::string_view target = std::string_view(head).substr(4, targetEnd - 4);
+    const size_t question = target.find('?');
+    request.Path = UrlDecode(target.substr(0, question));
+    if (question == std::string_view::npos) return true;
+
+    std::string_view query = target.substr(question + 1);
+    while (!query.empty()) {
+        const size_t amp = query.find('&');
+        const std::string_view pair = query.substr(0, amp);
+        const size_t eq = pair.find('=');
+        request.Params[UrlDecode(pair.substr(0, eq))] = (eq == std::string_view::npos) ? "" : UrlDecode(pair.substr(eq + 1));
+        if (amp == std::string_view::npos) break;
+        query.remove_prefix(amp + 1);
+    }
+    return true;
+}
+
+class QueryServer {
+public:
+    ~QueryServer() { Stop(); }
+
+    bool IsRunning() const { return Running; }
+    int Port() const { return BoundPort; }
+    const std::string& LastError() const { return Error; }
+    bool Serves(const LogViewerState& state) const { return Running && State == &state; }
+    const LogViewerState* Served() const { return Running ? State : nullptr; }
+
+    bool Start(LogViewerState& state, int port) {
+        Stop();
+        State = &state;
+#ifdef _WIN32
+        WSADATA wsaData;
+        WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+        ListenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (ListenSocket == INVALID_SOCKET_HANDLE) { Error = "socket() failed"; return false; }
+
+        const int reuse = 1;
+        setsockopt(ListenSocket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // Never exposed outside of this machine
+        if (bind(ListenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(ListenSocket, 16) != 0) {
+            Error = "Cannot listen on 127.0.0.1:" + std::to_string(port);
+            CloseSocket(ListenSocket);
+            ListenSocket = INVALID_SOCKET_HANDLE;
+            return false;
+        }
+        socklen_t addressSize = sizeof(address);
+        getsockname(ListenSocket, reinterpret_cast<sockaddr*>(&address), &addressSize); // Port 0 picks a free one
+
+        Error.clear();
+        BoundPort = ntohs(address.sin_port);
+        Running = true;
+        Workers = std::make_unique<ThreadPool>(4);
+        AcceptThread = std::thread([this] { AcceptLoop(); });
+        return true;
+    }
+
+    void Stop() {
+        if (!Running) return;
+        Running = false;
+        AcceptThread.join();
+        Workers.reset(); // Waits for the requests in flight
+        CloseSocket(ListenSocket);
+        ListenSocket = INVALID_SOCKET_HANDLE;
+    }
+
+private:
+    void AcceptLoop() {
+        while (Running) {
+            // Poll with a timeout so Stop() doesn't depend on accept() being interrupted
+            PollFd fd = {};
+            fd.fd = ListenSocket;
+            fd.events = POLLIN;
+            if (PollSockets(&fd, 1, 200) <= 0) continue;
+
+            const SocketHandle client = accept(ListenSocket, nullptr, nullptr);
+            if (client == INVALID_SOCKET_HANDLE) continue;
+            Workers->Submit([this, client] {
+                HandleClient(client);
+                CloseSocket(client);
+            });
+        }
+    }
+
+    static bool SendAll(SocketHandle client, std::string_view data) {
+        while (!data.empty()) {
+            const int sent = send(client, data.data(), static_cast<int>(std::min<size_t>(data.size(), 1 << 20)), 0);
+            if (sent <= 0) return false;
+            data.remove_prefix(sent);
+        }
+        return true;
+    }
+
+    // Buffers NDJSON lines and flushes them in large writes
+    struct NdjsonStream {
+        explicit NdjsonStream(SocketHandle client) : Client(client) {}
+
+        SocketHandle Client;
+        std::string Buffer;
+        bool Ok = true;
+
+        void Line(const std::string& json) {
+            Buffer += json;
+            Buffer += '\n';
+            if (Buffer.size() >= 64 * 1024) Flush();
+        }
+        void Flush() {
+            if (Ok && !Buffer.empty()) Ok = SendAll(Client, Buffer);
+            Buffer.clear();
+        }
+    };
+
+    void HandleClient(SocketHandle client) {
+        std::string head;
+        char buffer[4096];
+        while (head.find("\r\n\r\n") == std::string::npos && head.size() < 64 * 1024) {
+            const int received = recv(client, buffer, sizeof(buffer), 0);
+            if (received <= 0) return;
+            head.append(buffer, received);
+        }
+
+        HttpRequest request;
+        if (!ParseHttpRequestLine(head, request)) {
+            SendError(client, "400 Bad Request", "malformed request, only GET is supported");
+            return;
+        }
+        if (request.Path != "/count" && request.Path != "/filter" && request.Path != "/lines" && request.Path != "/query") {
+            SendError(client, "404 Not Found", "unknown endpoint, use /count /filter /lines /query");
+            return;
+        }
+
+        // Invalid parameters are reported before the 200 header goes out
+        std::shared_lock lock(State->DataMutex);
+        std::vector<int> indices;
+        AggregationQuery query;
+        std::string error;
+        if (request.Path == "/count" || request.Path == "/filter") {
+            if (!State->RunFilter(FilterFromRequest(request), indices)) error = "invalid fields filter";
+        } else if (request.Path == "/query") {
+            ParseAggregationQuery(request.Get("q"), *State, query, error);
+        }
+        if (!error.empty()) {
+            SendError(client, "400 Bad Request", error);
+            return;
+        }
+
+        SendAll(client, "HTTP/1.1 200 OK\r\nContent-Type: application/x-ndjson\r\nConnection: close\r\n\r\n");
+        NdjsonStream stream(client);
+        if (request.Path == "/count") {
+            stream.Line("{\"count\":" + std::to_string(indices.size()) + ",\"total\":" + std::to_string(State->AllLogs.size()) + "}");
+        } else if (request.Path == "/filter") {
+            const size_t offset = std::min<size_t>(std::max(0LL, request.GetInt("offset", 0)), indices.size());
+            const size_t limit = static_cast<size_t>(std::max(0LL, request.GetInt("limit", static_cast<long long>(indices.size()))));
+            for (size_t n = offset; n < indices.size() && n - offset < limit && stream.Ok; ++n)
+                stream.Line(LineJson(indices[n]));
+        } else if (request.Path == "/lines") {
+            const long long total = static_cast<long long>(State->AllLogs.size());
+            const long long from = std::clamp(request.GetInt("from", 0), 0LL, total);
+            const long long to = std::clamp(request.GetInt("to", total), from, total);
+            for (long long i = from; i < to && stream.Ok; ++i)
+                stream.Line(LineJson(static_cast<int>(i)));
+        } else {
+            const QueryResult result = RunAggregationQuery(query, *State);
+            for (const QueryResultRow& row : result.Rows) {
+                std::string json = "{";
+                for (size_t c = 0; c < row.Cells.size(); ++c) {
+                    AppendJsonString(json, ToLowerCopy(result.Columns[c]));
+                    json += ':';
+                    AppendJsonString(json, row.Cells[c]);
+                    json += ',';
+                }
+                json += "\"count\":" + std::to_string(row.Count) + "}";
+                stream.Line(json);
+            }
+        }
+        stream.Flush();
+    }
+
+    // Error responses carry a single {"error": ...} line
+    static void SendError(SocketHandle client, const char* status, std::string_view message) {
+        std::string json = "{\"error\":";
+        AppendJsonString(json, message);
+        json += "}\n";
+        SendAll(client, std::string("HTTP/1.1 ") + status + "\r\nContent-Type: application/x-ndjson\r\nConnection: close\r\nContent-Length: " +
+                            std::to_string(json.size()) + "\r\n\r\n" + json);
+    }
+
+    static LogFilter FilterFromRequest(const HttpRequest& request) {
+        LogFilter filter;
+        filter.ShowErrors = request.Get("errors", "1") != "0";
+        filter.ShowWarnings = request.Get("warnings", "1") != "0";
+        filter.ShowDisplay = request.Get("display", "1") != "0";
+        filter.ShowDuplicates = request.Get("duplicates", "1") != "0";
+        std::stringstream categories(request.Get("category", "All"));
+        for (std::string category; std::getline(categories, category, ',');) {
+            if (!category.empty() && category != "All") filter.Categories.push_back(category);
+        }
+        filter.Search = request.Get("search");
+        filter.Fields = request.Get("fields");
+        filter.SourceId = static_cast<int>(request.GetInt("source", -1));
+        filter.MaxOccurrences = static_cast<int>(request.GetInt("rare", -1));
+        filter.FromTime = request.GetInt("since", 0);
+        filter.ToTime = request.GetInt("until", 0);
+        return filter;
+    }
+
+    std::string LineJson(int index) const {
+        const LogEntry& log = State->AllLogs[index];
+        std::string json = "{\"line\":" + std::to_string(index) + ",\"level\":";
+        AppendJsonString(json, LogLevelName(log.Level));
+        json += ",\"category\":";
+        AppendJsonString(json, log.Category);
+        json += ",\"text\":";
+        AppendJsonString(json, log.FullText);
+        json += '}';
+        return json;
+    }
+
+    LogViewerState* State = nullptr;
+    SocketHandle ListenSocket = INVALID_SOCKET_HANDLE;
+    std::atomic<bool> Running = false;
+    int BoundPort = 0;
+    std::string Error;
+    std::thread AcceptThread;
+    std::unique_ptr<ThreadPool> Workers;
+};
+
+// =========================================================
+// --- CORPUS INDEX ---
+// Persistent index over a directory of archived logs (e.g. thousands of CI cook logs),
+// stored in <dir>/.ulr-corpus.idx. For every file it keeps metadata, the sorted set of
+// fingerprints and the sorted set of case-folded alphanumeric trigrams. Trigram
+// postings (trigram -> file ids) are rebuilt in memory on load. A text query intersects
+// the postings to get candidate files, then scans only those in parallel.
+// Updating only re-indexes files whose size or modification time changed.
+constexpr int CORPUS_TRIGRAM_ALPHABET = 37; // '\0' separator, a-z, 0-9
+constexpr int CORPUS_TRIGRAM_COUNT = CORPUS_TRIGRAM_ALPHABET * CORPUS_TRIGRAM_ALPHABET * CORPUS_TRIGRAM_ALPHABET;
+constexpr uint32_t CORPUS_INDEX_VERSION = 1;
+constexpr const char* CORPUS_INDEX_NAME = ".ulr-corpus.idx";
+
+static int TrigramSymbol(char c) {
+    if (c >= 'a' && c <= 'z') return c - 'a' + 1;
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 1;
+    if (c >= '0' && c <= '9') return c - '0' + 27;
+    return 0;
+}
+
+// Calls fn(trigram) for every trigram made of three alphanumeric characters
+template <typename Fn>
+static void ForEachTrigram(std::string_view text, Fn&& fn) {
+    int a = 0, b = 0;
+    for (const char c : text) {
+        const int symbol = TrigramSymbol(c);
+        if (a != 0 && b != 0 && symbol != 0)
+            fn(static_cast<uint16_t>((a * CORPUS_TRIGRAM_ALPHABET + b) * CORPUS_TRIGRAM_ALPHABET + symbol));
+        a = b;
+        b = symbol;
+    }
+}
+
+struct CorpusFile {
+    std::string Path;          // Relative to the corpus root
+    uint64_t Size = 0;
+    int64_t ModifiedTime = 0;
+    uint32_t LineCount = 0;
+    uint32_t ErrorCount = 0;
+    uint32_t WarningCount = 0;
+    int64_t FirstTimestamp = 0; // First log timestamp, or 0
+    std::vector<uint64_t> Fingerprints; // Sorted, unique
+    std::vector<uint16_t> Trigrams;     // Sorted, unique
+};
+
+struct CorpusHit {
+    int FileId = 0;
+    int LineIndex = 0; // Same numbering as LogEntry::LogIndex
+    std::string Text;
+};
+
+bool IsLogFileName(const std::filesystem::path& path) {
+    const std::string extension = path.extension().string();
+    if (extension == ".gz") return IsLogFileName(path.stem()); // Game.log.gz
+    return extension == ".log" || extension == ".txt";
+}
+
+// Reads a log with the same line rules as LoadFile (empty lines skipped, stops at the summary)
+template <typename Fn>
+static void ForEachLogFileLine(const std::filesystem::path& path, Fn&& fn) {
+    std::string partial;
+    int index = -1;
+    bool summary = false;
+    auto emit = [&](std::string&& line) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        summary = line.find("Warning/Error Summary") != std::string::npos;
+        if (!summary && !line.empty()) fn(++index, line);
+        return !summary;
+    };
+    auto append = [&](std::string_view data) {
+        SplitLines(partial, data, emit);
+        return !summary;
+    };
+
+    if (path.extension() == ".gz") {
+        GzipIndex gzip;
+        gzip.ReadAll(path, append);
+    } else {
+        FileBlockReader reader;
+        if (!reader.Open(path)) return;
+        std::string_view block;
+        while (!summary && reader.Next(block)) append(block);
+    }
+    if (!summary && !partial.empty()) emit(std::move(partial));
+}
+
+class CorpusIndex {
+public:
+    ~CorpusIndex() { Wait(); }
+
+    std::filesystem::path Root;
+    std::vector<CorpusFile> Files;
+
+    // Progress of the background job
+    std::atomic<bool> Busy = false;
+    std::atomic<int> Done = 0;
+    std::atomic<int> Total = 0;
+
+    // Results of the last query (read after Busy goes back to false)
+    std::vector<CorpusHit> Hits;
+    std::vector<int> FingerprintFiles; // Files containing the fingerprint, oldest first
+    bool HitsTruncated = false;
+
+    // Opens the directory and updates its index in the background
+    void OpenAndUpdate(const std::filesystem::path& root) {
+        if (Busy) return;
+        Root = root;
+        RunInBackground([this] {
+            if (!Load()) Files.clear();
+            Update();
+        });
+    }
+
+    void Search(const std::string& text, int maxHits) {
+        RunInBackground([this, text, maxHits] { RunSearch(text, maxHits); });
+    }
+
+    void FindFingerprint(uint64_t fingerprint, int maxHits) {
+        RunInBackground([this, fingerprint, maxHits] { RunFindFingerprint(fingerprint, maxHits); });
+    }
+
+    void Wait() {
+        if (Job.joinable()) Job.join();
+    }
+
+    std::string GetStatus() {
+        std::lock_guard lock(StatusMutex);
+        return Status;
+    }
+
+private:
+    void SetStatus(std::string status) {
+        std::lock_guard lock(StatusMutex);
+        Status = std::move(status);
+    }
+
+    void RunInBackground(std::function<void()> task) {
+        if (Busy) return;
+        Wait();
+        Busy = true;
+        Job = std::thread([this, task = std::move(task)] {
+            task();
+            Busy = false;
+        });
+    }
+
+    std::filesystem::path IndexPath() const { return Root / CORPUS_INDEX_NAME; }
+
+    bool Load() {
+        BinaryReader reader(IndexPath());
+        if (!reader.Ok() || reader.Read<uint32_t>() != CORPUS_INDEX_VERSION) return false;
+        constexpr uint64_t minFileBytes = 4 + 8 + 8 + 3 * 4 + 8 + 8 + 8; // Empty path, fingerprints and trigrams
+        const uint32_t count = reader.Read<uint32_t>();
+        if (!reader.CanRead(count, minFileBytes)) return false;
+        Files.resize(count);
+        for (CorpusFile& file : Files) {
+            if (!reader.Ok()) return false;
+            file.Path = reader.ReadString();
+            file.Size = reader.Read<uint64_t>();
+            file.ModifiedTime = reader.Read<int64_t>();
+            file.LineCount = reader.Read<uint32_t>();
+            file.ErrorCount = reader.Read<uint32_t>();
+            file.WarningCount = reader.Read<uint32_t>();
+            file.FirstTimestamp = reader.Read<int64_t>();
+            file.Fingerprints = reader.ReadVector<uint64_t>();
+            file.Trigrams = reader.ReadVector<uint16_t>();
+        }
+        return reader.Ok();
+    }
+
+    // Written aside and renamed over the index, like GzipIndex::Save: an interrupted save keeps the old one
+    bool Save() const {
+        std::filesystem::path tempPath = IndexPath();
+        tempPath += ".tmp";
+        std::error_code error;
+        if (WriteIndex(tempPath)) {
+            std::filesystem::rename(tempPath, IndexPath(), error);
+            if (!error) return true;
+        }
+        std::filesystem::remove(tempPath, error);
+        return false; // Read-only share: the index only lives in memory
+    }
+
+    bool WriteIndex(const std::filesystem::path& path) const {
+        BinaryWriter writer(path);
+        if (!writer.File) return false;
+        writer.Write(CORPUS_INDEX_VERSION);
+        writer.Write(static_cast<uint32_t>(Files.size()));
+        for (const CorpusFile& file : Files) {
+            writer.WriteString(file.Path);
+            writer.Write(file.Size);
+            writer.Write(file.ModifiedTime);
+            writer.Write(file.LineCount);
+            writer.Write(file.ErrorCount);
+            writer.Write(file.WarningCount);
+            writer.Write(file.FirstTimestamp);
+            writer.WriteVector(file.Fingerprints);
+            writer.WriteVector(file.Trigrams);
+        }
+        writer.File.flush();
+        return static_cast<bool>(writer.File);
+    }
+
+    void Update() {
+        SetStatus("Scanning directory...");
+        std::map<std::string, CorpusFile> previous;
+        for (CorpusFile& file : Files) previous.emplace(file.Path, std::move(file));
+        Files.clear();
+
+        std::vector<int> toIndex;
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(Root, error);
+             it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+            if (error) break;
+            if (!it->is_regular_file() || !IsLogFileName(it->path())) continue;
+
+            CorpusFile file;
+            file.Path = std::filesystem::relative(it->path(), Root).generic_string();
+            file.Size = it->file_size();
+            file.ModifiedTime = FileModifiedTime(it->path());
+
+            auto old = previous.find(file.Path);
+            if (old != previous.end() && old->second.Size == file.Size && old->second.ModifiedTime == file.ModifiedTime) {
+                Files.push_back(std::move(old->second));
+            } else {
+                toIndex.push_back(static_cast<int>(Files.size()));
+                Files.push_back(std::move(file));
+            }
+        }
+
+        Done = 0;
+        Total = static_cast<int>(toIndex.size());
+        SetStatus("Indexing " + std::to_string(toIndex.size()) + " new or changed files...");
+        g_ThreadPool.ParallelFor(static_cast<int>(toIndex.size()), 1, [&](int begin, int end) {
+            for (int n = begin; n < end; ++n) {
+                IndexFile(Files[toIndex[n]]);
+                Done++;
+            }
+        });
+
+        if (!toIndex.empty() || previous.size() != Files.size()) Save();
+        BuildPostings();
+        SetStatus(std::to_string(Files.size()) + " files indexed (" + std::to_string(toIndex.size()) + " updated)");
+    }
+
+    void IndexFile(CorpusFile& file) const {
+        std::vector<bool> trigrams(CORPUS_TRIGRAM_COUNT);
+        std::vector<uint64_t> fingerprints;
+        LogEntry entry;
+        ForEachLogFileLine(Root / file.Path, [&](int, const std::string& line) {
+            file.LineCount++;
+            ForEachTrigram(line, [&](uint16_t trigram) { trigrams[trigram] = true; });
+            if (line[0] != '[') return;
+
+            ParseHeaderLine(line, entry);
+            fingerprints.push_back(entry.ContentHash);
+            if (entry.Level == LogLevel::Error) file.ErrorCount++;
+            else if (entry.Level == LogLevel::Warning) file.WarningCount++;
+            if (file.FirstTimestamp == 0) file.FirstTimestamp = entry.Timestamp;
+        });
+
+        std::ranges::sort(fingerprints);
+        fingerprints.erase(std::unique(fingerprints.begin(), fingerprints.end()), fingerprints.end());
+        file.Fingerprints = std::move(fingerprints);
+        file.Trigrams.clear();
+        for (int t = 0; t < CORPUS_TRIGRAM_COUNT; ++t) {
+            if (trigrams[t]) file.Trigrams.push_back(static_cast<uint16_t>(t));
+        }
+    }
+
+    void BuildPostings() {
+        Postings.assign(CORPUS_TRIGRAM_COUNT, {});
+        for (int fileId = 0; fileId < (int)Files.size(); ++fileId) {
+            for (const uint16_t trigram : Files[fileId].Trigrams)
+                Postings[trigram].push_back(fileId);
+        }
+    }
+
+    // Files (sorted by id) that contain every trigram of the query; all files if it has none
+    std::vector<int> CandidateFiles(const std::string& text) const {
+        std::vector<uint16_t> trigrams;
+        ForEachTrigram(text, [&](uint16_t trigram) { trigrams.push_back(trigram); });
+        std::ranges::sort(trigrams);
+        trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+        std::vector<int> candidates;
+        if (trigrams.empty()) {
+            for (int fileId = 0; fileId < (int)Files.size(); ++fileId) candidates.push_back(fileId);
+            return candidates;
+        }
+
+        // Start from the rarest trigram to keep the intersections small
+        std::ranges::sort(trigrams, [&](uint16_t a, uint16_t b) { return Postings[a].size() < Postings[b].size(); });
+        candidates = Postings[trigrams[0]];
+        std::vector<int> next;
+        for (size_t t = 1; t < trigrams.size() && !candidates.empty(); ++t) {
+            next.clear();
+            std::ranges::set_intersection(candidates, Postings[trigrams[t]], std::back_inserter(next));
+            candidates.swap(next);
+        }
+        return candidates;
+    }
+
+    // Scans the given files in parallel and collects at most maxHits matching lines, oldest file first
+    template <typename Predicate>
+    void ScanFiles(std::vector<int> fileIds, int maxHits, Predicate&& matches) {
+        std::ranges::sort(fileIds, [&](int a, int b) { return OlderThan(Files[a], Files[b]); });
+        std::vector<std::vector<CorpusHit>> perFile(fileIds.size());
+        Done = 0;
+        Total = static_cast<int>(fileIds.size());
+        g_ThreadPool.ParallelFor(static_cast<int>(fileIds.size()), 1, [&](int begin, int end) {
+            for (int n = begin; n < end; ++n) {
+                ForEachLogFileLine(Root / Files[fileIds[n]].Path, [&](int index, const std::string& line) {
+                    if ((int)perFile[n].size() < maxHits && matches(line))
+                        perFile[n].push_back({fileIds[n], index, line});
+                });
+                Done++;
+            }
+        });
+
+        Hits.clear();
+        HitsTruncated = false;
+        for (auto& fileHits : perFile) {
+            for (auto& hit : fileHits) {
+                if ((int)Hits.size() >= maxHits) { HitsTruncated = true; break; }
+                Hits.push_back(std::move(hit));
+            }
+        }
+    }
+
+    static bool OlderThan(const CorpusFile& a, const CorpusFile& b) {
+        const int64_t timeA = a.FirstTimestamp ? a.FirstTimestamp : INT64_MAX;
+        const int64_t timeB = b.FirstTimestamp ? b.FirstTimestamp : INT64_MAX;
+        return timeA != timeB ? timeA < timeB : a.ModifiedTime < b.ModifiedTime;
+    }
+
+    void RunSearch(const std::string& text, int maxHits) {
+        const auto start = std::chrono::steady_clock::now();
+        const CaseInsensitiveSearch search(text);
+        const std::vector<int> candidates = CandidateFiles(text);
+        FingerprintFiles.clear();
+        ScanFiles(candidates, maxHits, [&](const std::string& line) { return search.Matches(line); });
+        SetStatus(std::to_string(Hits.size()) + " hits in " + std::to_string(candidates.size()) + "/" +
+                 std::to_string(Files.size()) + " candidate files (" +
+                 std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()) + " ms)");
+    }
+
+    void RunFindFingerprint(uint64_t fingerprint, int maxHits) {
+        FingerprintFiles.clear();
+        for (int fileId = 0; fileId < (int)Files.size(); ++fileId) {
+            if (std::ranges::binary_search(Files[fileId].Fingerprints, fingerprint))
+                FingerprintFiles.push_back(fileId);
+        }
+        std::ranges::sort(FingerprintFiles, [&](int a, int b) { return OlderThan(Files[a], Files[b]); });
+
+        ScanFiles(FingerprintFiles, maxHits, [&](const std::string& line) {
+            if (line[0] != '[') return false;
+            LogEntry entry;
+            ParseHeaderLine(line, entry);
+            return entry.ContentHash == fingerprint;
+        });
+        SetStatus("Fingerprint found in " + std::to_string(FingerprintFiles.size()) + " files");
+    }
+
+    std::vector<std::vector<int>> Postings; // Trigram -> sorted file ids
+    std::thread Job;
+    std::string Status;
+    std::mutex StatusMutex;
+};
+
+// =========================================================
+// --- ARROW EXPORT ---
+// Writes a view of the log as an Arrow IPC file (Feather v2), readable by pandas / polars /
+// pyarrow (pd.read_feather, pl.read_ipc) with its types:
+//   line int64, timestamp timestamp[ms] (null when the line has none), frame int32 (null),
+//   level dictionary<int8, utf8>, category dictionary<int32, utf8>,
+//   fingerprint uint64 (null on continuation lines), message utf8 (text after "Category: Level: ")
+// Dictionaries are LogViewerState::CategoryNames and the LogLevel names as they are, and the
+// indices are LogEntry::CategoryId / Level. Batches of ARROW_BATCH_ROWS rows, fewer when their
+// lines exceed ARROW_BATCH_BYTES (utf8 offsets are int32), are encoded in parallel, straight
+// from the entries into the batch body, and written in order. Text that isn't valid UTF-8 is
+// written with U+FFFD in place of the bad bytes, readers reject it otherwise.
+// Only the metadata needs FlatBuffers, written by the minimal FlatWriter below.
+constexpr int ARROW_BATCH_ROWS = 65536;
+constexpr size_t ARROW_BATCH_BYTES = 256 << 20; // Of FullText: messages are shorter, repaired ones at most 3x
+
+// Minimal FlatBuffers serializer. Objects are laid out front to back with every child after
+// its parent, so each uoffset points forward as the format requires, and scalars are
+// naturally aligned (the Arrow reader verifies alignment).
+class FlatWriter {
+public:
+    struct Node;
+    using NodePtr = std::shared_ptr<Node>;
+
+    struct Node {
+        enum class Kind { Table, String, TableVector, StructVector } Type = Kind::Table;
+        struct Field {
+            int Size = 0;        // Scalar bytes, 0 for a child object
+            uint64_t Value = 0;
+            NodePtr Child;
+        };
+        std::vector<std::pair<int, Field>> Fields; // Table: (slot, field)
+        std::string Bytes;                         // String, or StructVector elements
+        size_t Count = 0;                          // StructVector
+        std::vector<NodePtr> Children;             // TableVector
+
+        Node& Scalar(int slot, uint64_t value, int size) { Fields.push_back({slot, {size, value, nullptr}}); return *this; }
+        Node& Child(int slot, NodePtr child) { Fields.push_back({slot, {0, 0, std::move(child)}}); return *this; }
+    };
+
+    static NodePtr Table() { return std::make_shared<Node>(); }
+    static NodePtr String(std::string_view text) {
+        auto node = std::make_shared<Node>();
+        node->Type = Node::Kind::String;
+        node->Bytes = text;
+        return node;
+    }
+    static NodePtr Tables(std::vector<NodePtr> children) {
+        auto node = std::make_shared<Node>();
+        node->Type = Node::Kind::TableVector;
+        node->Children = std::move(children);
+        return node;
+    }
+    static NodePtr Structs(std::string bytes, size_t count) { // Elements of 8-byte aligned structs
+        auto node = std::make_shared<Node>();
+        node->Type = Node::Kind::StructVector;
+        node->Bytes = std::move(bytes);
+        node->Count = count;
+        return node;
+    }
+
+    // Root offset, then the objects. The size is a multiple of 8.
+    static std::string Finish(const NodePtr& root) {
+        FlatWriter writer;
+        writer.Put<uint32_t>(0);
+        writer.Patch<uint32_t>(0, static_cast<uint32_t>(writer.Write(*root)));
+        writer.Align(8);
+        return std::move(writer.Buffer);
+    }
+
+private:
+    std::string Buffer;
+
+    template <typename T>
+    void Put(T value) { Buffer.append(reinterpret_cast<const char*>(&value), sizeof(T)); }
+    template <typename T>
+    void Patch(size_t at, T value) { std::memcpy(Buffer.data() + at, &value, sizeof(T)); }
+    void Align(size_t alignment, size_t offset = 0) {
+        while ((Buffer.size() + offset) % alignment != 0) Buffer.push_back('\0');
+    }
+
+    // Returns the position of the object
+    size_t Write(const Node& node) {
+        switch (node.Type) {
+        case Node::Kind::String: {
+            Align(4);
+            const size_t at = Buffer.size();
+            Put<uint32_t>(static_cast<uint32_t>(node.Bytes.size()));
+            Buffer += node.Bytes;
+            Buffer.push_back('\0');
+            return at;
+        }
+        case Node::Kind::StructVector: {
+            Align(8, 4); // Elements start 8-byte aligned, after the length
+            const size_t at = Buffer.size();
+            Put<uint32_t>(static_cast<uint32_t>(node.Count));
+            Buffer += node.Bytes;
+            return at;
+        }
+        case Node::Kind::TableVector: {
+            Align(4);
+            const size_t at = Buffer.size();
+            Put<uint32_t>(static_cast<uint32_t>(node.Children.size()));
+            Buffer.append(node.Children.size() * 4, '\0');
+            for (size_t n = 0; n < node.Children.size(); ++n) {
+                const size_t slot = at + 4 + n * 4;
+                Patch<uint32_t>(slot, static_cast<uint32_t>(Write(*node.Children[n]) - slot));
+            }
+            return at;
+        }
+        case Node::Kind::Table:
+            break;
+        }
+
+        // vtable: its size, the table size, then the offset of every slot in the table (0 = absent)
+        int slots = 0;
+        for (const auto& [slot, field] : node.Fields) slots = std::max(slots, slot + 1);
+        Align(2);
+        const size_t vtable = Buffer.size();
+        Put<uint16_t>(static_cast<uint16_t>(4 + 2 * slots));
+        Buffer.append(2 + 2 * slots, '\0');
+
+        Align(8);
+        const size_t table = Buffer.size();
+        Put<int32_t>(static_cast<int32_t>(table - vtable));
+        std::vector<std::pair<int, Node::Field>> fields = node.Fields;
+        std::ranges::stable_sort(fields, std::greater<>(), [](const auto& entry) { return entry.second.Child ? 4 : entry.second.Size; });
+        std::vector<std::pair<size_t, const NodePtr*>> children;
+        for (const auto& [slot, field] : fields) {
+            const int size = field.Child ? 4 : field.Size;
+            Align(size);
+            Patch<uint16_t>(vtable + 4 + 2 * slot, static_cast<uint16_t>(Buffer.size() - table));
+            if (field.Child) children.push_back({Buffer.size(), &field.Child});
+            Buffer.append(reinterpret_cast<const char*>(&field.Value), size); // Little endian
+        }
+        Patch<uint16_t>(vtable + 2, static_cast<uint16_t>(Buffer.size() - table));
+
+        for (auto& [at, child] : children) {
+            const size_t position = Write(**child);
+            Patch<uint32_t>(at, static_cast<uint32_t>(position - at));
+        }
+        return table;
+    }
+};
+
+// Arrow schema enums (Schema.fbs / Message.fbs)
+enum ArrowType : uint8_t { ARROW_INT = 2, ARROW_UTF8 = 5, ARROW_TIMESTAMP = 10 };
+enum ArrowMessage : uint8_t { ARROW_SCHEMA = 1, ARROW_DICTIONARY_BATCH = 2, ARROW_RECORD_BATCH = 3 };
+constexpr uint16_t ARROW_METADATA_V5 = 4;
+constexpr uint8_t ARROW_MILLISECOND = 1;
+
+class ArrowWriter {
+public:
+    // LogEntry::LogIndex of rows (AllLogs indices), what Write takes
+    static std::vector<int64_t> Lines(const LogViewerState& state, const std::vector<int>& rows) {
+        std::vector<int64_t> lines(rows.size());
+        for (size_t n = 0; n < rows.size(); ++n) lines[n] = state.AllLogs[rows[n]].LogIndex;
+        return lines;
+    }
+
+    // Shared with a background export
+    struct Progress {
+        std::atomic<int64_t> Done = 0;    // Lines handled
+        std::atomic<int64_t> Skipped = 0; // Dropped by retention before they were written
+        std::atomic<bool> Cancel = false;
+    };
+
+    // Writes the lines of state (ascending LogEntry::LogIndex) to path. They are read under a
+    // shared DataMutex, released between windows of batches so a live log keeps appending; lines
+    // dropped by retention in the meantime are skipped. Returns false on I/O errors, when
+    // cancelled, or when the log is reloaded.
+    static bool Write(LogViewerState& state, const std::vector<int64_t>& lines, const std::string& path, std::string& error,
+                      Progress* progress = nullptr) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            error = "Cannot write " + path;
+            return false;
+        }
+        ArrowWriter writer(file);
+        file.write("ARROW1\0\0", 8);
+        writer.Offset = 8;
+        writer.WriteMessage(Schema(), ARROW_SCHEMA, {});
+
+        // Lines appended later aren't exported, so no category is added past this dictionary
+        const std::vector<std::string> levels = {LogLevelName(LogLevel::Display), LogLevelName(LogLevel::Warning), LogLevelName(LogLevel::Error)};
+        int generation;
+        {
+            std::shared_lock dataLock(state.DataMutex);
+            generation = state.LoadGeneration;
+            writer.Dictionaries.push_back(writer.WriteDictionary(0, levels));
+            writer.Dictionaries.push_back(writer.WriteDictionary(1, state.CategoryNames));
+        }
+
+        // A window of batches is encoded on the pool while nothing is written, then written in order
+        const int window = std::max(1, 2 * static_cast<int>(std::thread::hardware_concurrency()));
+        std::vector<int> rows;
+        std::vector<size_t> cuts;
+        size_t next = 0;
+        while (next < lines.size() && file) {
+            std::vector<EncodedBatch> batches;
+            {
+                std::shared_lock dataLock(state.DataMutex);
+                const bool cancelled = progress && progress->Cancel;
+                if (cancelled || state.LoadGeneration != generation) {
+                    error = cancelled ? "Export cancelled" : "The log was reloaded during the export";
+                    file.close();
+                    std::filesystem::remove(path);
+                    return false;
+                }
+                // Rows of the window that are still retained, cut into batches
+                rows.clear();
+                cuts.assign(1, 0);
+                size_t batchBytes = 0;
+                for (; next < lines.size(); ++next) {
+                    if (lines[next] < state.DroppedLines) {
+                        if (progress) progress->Skipped++;
+                        continue;
+                    }
+                    const int row = static_cast<int>(lines[next] - state.DroppedLines);
+                    const size_t bytes = state.AllLogs[row].FullText.size();
+                    if (rows.size() > cuts.back() && (rows.size() - cuts.back() == ARROW_BATCH_ROWS || batchBytes + bytes > ARROW_BATCH_BYTES)) {
+                        if (static_cast<int>(cuts.size()) == window) break;
+                        cuts.push_back(rows.size());
+                        batchBytes = 0;
+                    }
+                    rows.push_back(row);
+                    batchBytes += bytes;
+                }
+                if (rows.size() > cuts.back()) cuts.push_back(rows.size());
+
+                batches.resize(cuts.size() - 1);
+                g_ThreadPool.ParallelFor(static_cast<int>(batches.size()), 1, [&](int begin, int end) {
+                    for (int n = begin; n < end; ++n)
+                        batches[n] = EncodeBatch(state, std::span(rows).subspan(cuts[n], cuts[n + 1] - cuts[n]));
+                });
+            }
+            for (EncodedBatch& batch : batches)
+                writer.RecordBatches.push_back(writer.WriteMessage(batch.Header, ARROW_RECORD_BATCH, batch.Body));
+            if (progress) progress->Done = static_cast<int64_t>(next);
+        }
+
+        // End of stream marker, then the footer that indexes the messages
+        const uint32_t endOfStream[2] = {0xFFFFFFFF, 0};
+        file.write(reinterpret_cast<const char*>(endOfStream), sizeof(endOfStream));
+        auto footer = FlatWriter::Table();
+        footer->Scalar(0, ARROW_METADATA_V5, 2)
+            .Child(1, Schema())
+            .Child(2, Blocks(writer.Dictionaries))
+            .Child(3, Blocks(writer.RecordBatches));
+        const std::string footerBytes = FlatWriter::Finish(footer);
+        const int32_t footerSize = static_cast<int32_t>(footerBytes.size());
+        file.write(footerBytes.data(), footerBytes.size());
+        file.write(reinterpret_cast<const char*>(&footerSize), sizeof(footerSize));
+        file.write("ARROW1", 6);
+        if (!file) error = "Write error on " + path;
+        return static_cast<bool>(file);
+    }
+
+private:
+    struct Block {
+        int64_t Offset;
+        int32_t MetadataLength;
+        int64_t BodyLength;
+    };
+
+    struct EncodedBatch {
+        FlatWriter::NodePtr Header;
+        std::string Body;
+    };
+
+    // Body of a record batch: buffers padded to 8 bytes, with their FieldNode / Buffer descriptions
+    struct BodyBuilder {
+        std::string Body;
+        std::string Nodes;   // FieldNode structs: length, null count
+        std::string Buffers; // Buffer structs: offset, length
+        size_t NodeCount = 0;
+        size_t BufferCount = 0;
+
+        void AddNode(int64_t length, int64_t nullCount) {
+            Nodes.append(reinterpret_cast<const char*>(&length), 8).append(reinterpret_cast<const char*>(&nullCount), 8);
+            NodeCount++;
+        }
+        // Reserves a buffer of size bytes and returns its data
+        char* AddBuffer(size_t size) {
+            const int64_t offset = static_cast<int64_t>(Body.size());
+            const int64_t length = static_cast<int64_t>(size);
+            Buffers.append(reinterpret_cast<const char*>(&offset), 8).append(reinterpret_cast<const char*>(&length), 8);
+            BufferCount++;
+            Body.resize(Body.size() + ((size + 7) & ~size_t(7)), '\0');
+            return Body.data() + offset;
+        }
+        // Validity bitmap, omitted (length 0) when every value is set
+        void AddValidity(const std::vector<uint8_t>& valid) {
+            if (std::ranges::all_of(valid, [](uint8_t v) { return v != 0; })) {
+                AddBuffer(0);
+                return;
+            }
+            char* bits = AddBuffer((valid.size() + 7) / 8);
+            for (size_t n = 0; n < valid.size(); ++n) {
+                if (valid[n]) bits[n / 8] |= static_cast<char>(1 << (n % 8));
+            }
+        }
+        template <typename T>
+        void AddValues(const std::vector<T>& values) {
+            if (!values.empty()) std::memcpy(AddBuffer(values.size() * sizeof(T)), values.data(), values.size() * sizeof(T));
+            else AddBuffer(0);
+        }
+        // Utf8 column without nulls: validity, int32 offsets, characters (malformed UTF-8 repaired)
+        template <typename Fn>
+        void AddStrings(size_t count, Fn&& text) {
+            AddNode(static_cast<int64_t>(count), 0);
+            AddBuffer(0);
+            std::vector<std::string_view> values(count);
+            std::deque<std::string> repaired; // Stable addresses for values
+            std::vector<int32_t> offsets(count + 1);
+            for (size_t n = 0; n < count; ++n) {
+                values[n] = text(n);
+                if (!IsValidUtf8(values[n])) {
+                    AppendValidUtf8(repaired.emplace_back(), values[n]);
+                    values[n] = repaired.back();
+                }
+                offsets[n + 1] = offsets[n] + static_cast<int32_t>(values[n].size());
+            }
+            AddValues(offsets);
+            char* data = AddBuffer(offsets[count]);
+            for (size_t n = 0; n < count; ++n) std::memcpy(data + offsets[n], values[n].data(), values[n].size());
+        }
+
+        FlatWriter::NodePtr Header(int64_t length) const {
+            auto batch = FlatWriter::Table();
+            batch->Scalar(0, static_cast<uint64_t>(length), 8)
+                .Child(1, FlatWriter::Structs(Nodes, NodeCount))
+                .Child(2, FlatWriter::Structs(Buffers, BufferCount));
+            return batch;
+        }
+    };
+
+    std::ofstream& File;
+    int64_t Offset = 0;
+    std::vector<Block> Dictionaries;
+    std::vector<Block> RecordBatches;
+
+    explicit ArrowWriter(std::ofstream& file) : File(file) {}
+
+    // Encapsulated message: continuation marker, metadata size, Message flatbuffer, body
+    Block WriteMessage(const FlatWriter::NodePtr& header, uint8_t type, const std::string& body) {
+        auto message = FlatWriter::Table();
+        message->Scalar(0, ARROW_METADATA_V5, 2)
+            .Scalar(1, type, 1)
+            .Child(2, header)
+            .Scalar(3, body.size(), 8);
+        const std::string metadata = FlatWriter::Finish(message); // Multiple of 8, so the body stays aligned
+        const uint32_t prefix[2] = {0xFFFFFFFF, static_cast<uint32_t>(metadata.size())};
+        File.write(reinterpret_cast<const char*>(prefix), sizeof(prefix));
+        File.write(metadata.data(), metadata.size());
+        File.write(body.data(), body.size());
+
+        const Block block = {Offset, static_cast<int32_t>(8 + metadata.size()), static_cast<int64_t>(body.size())};
+        Offset += block.MetadataLength + block.BodyLength;
+        return block;
+    }
+
+    Block WriteDictionary(int64_t id, const std::vector<std::string>& values) {
+        BodyBuilder body;
+        body.AddStrings(values.size(), [&](size_t n) { return std::string_view(values[n]); });
+        auto dictionary = FlatWriter::Table();
+        dictionary->Scalar(0, static_cast<uint64_t>(id), 8).Child(1, body.Header(static_cast<int64_t>(values.size())));
+        return WriteMessage(dictionary, ARROW_DICTIONARY_BATCH, body.Body);
+    }
+
+    static FlatWriter::NodePtr Blocks(const std::vector<Block>& blocks) {
+        std::string bytes;
+        for (const Block& block : blocks) {
+            const int32_t padding = 0;
+            bytes.append(reinterpret_cast<const char*>(&block.Offset), 8);
+            bytes.append(reinterpret_cast<const char*>(&block.MetadataLength), 4);
+            bytes.append(reinterpret_cast<const char*>(&padding), 4);
+            bytes.append(reinterpret_cast<const char*>(&block.BodyLength), 8);
+        }
+        return FlatWriter::Structs(std::move(bytes), blocks.size());
+    }
+
+    static FlatWriter::NodePtr IntType(int bits, bool isSigned) {
+        auto type = FlatWriter::Table();
+        type->Scalar(0, bits, 4).Scalar(1, isSigned, 1);
+        return type;
+    }
+
+    static FlatWriter::NodePtr Field(const char* name, bool nullable, uint8_t typeId, FlatWriter::NodePtr type,
+                                     FlatWriter::NodePtr dictionary = nullptr) {
+        auto field = FlatWriter::Table();
+        field->Child(0, FlatWriter::String(name))
+            .Scalar(1, nullable, 1)
+            .Scalar(2, typeId, 1)
+            .Child(3, std::move(type))
+            .Child(5, FlatWriter::Tables({})); // No children, but readers require the vector
+        if (dictionary) field->Child(4, std::move(dictionary));
+        return field;
+    }
+
+    static FlatWriter::NodePtr DictionaryEncoding(int64_t id, int indexBits) {
+        auto encoding = FlatWriter::Table();
+        encoding->Scalar(0, static_cast<uint64_t>(id), 8).Child(1, IntType(indexBits, true));
+        return encoding;
+    }
+
+    static FlatWriter::NodePtr Schema() {
+        auto timestamp = FlatWriter::Table();
+        timestamp->Scalar(0, ARROW_MILLISECOND, 2);
+        auto schema = FlatWriter::Table();
+        schema->Child(1, FlatWriter::Tables({
+            Field("line", false, ARROW_INT, IntType(64, true)),
+            Field("timestamp", true, ARROW_TIMESTAMP, timestamp),
+            Field("frame", true, ARROW_INT, IntType(32, true)),
+            Field("level", false, ARROW_UTF8, FlatWriter::Table(), DictionaryEncoding(0, 8)),
+            Field("category", false, ARROW_UTF8, FlatWriter::Table(), DictionaryEncoding(1, 32)),
+            Field("fingerprint", true, ARROW_INT, IntType(64, false)),
+            Field("message", false, ARROW_UTF8, FlatWriter::Table()),
+        }));
+        return schema;
+    }
+
+    // "[2024.01.01-14.22.33:123][ 42]LogX: ..." -> 42, -1 without a frame counter
+    static int ParseFrame(std::string_view text) {
+        if (text.size() < 28 || text[0] != '[' || text[25] != '[') return -1;
+        int frame = 0;
+        bool digits = false;
+        for (size_t n = 26; n < text.size() && text[n] != ']'; ++n) {
+            if (text[n] >= '0' && text[n] <= '9') {
+                frame = frame * 10 + (text[n] - '0');
+                digits = true;
+            } else if (text[n] != ' ') {
+                return -1;
+            }
+        }
+        return digits ? frame : -1;
+    }
+
+    // Text after the "[timestamp][frame]Category: Level: " prefix; continuation lines without their indent
+    static std::string_view Message(const LogEntry& log) {
+        std::string_view text = log.FullText;
+        if (!log.IsHeader) return text.substr(std::min<size_t>(6, text.size()));
+        const size_t category = text.find(log.Category + ":");
+        if (category == std::string_view::npos) return text;
+        text.remove_prefix(category + log.Category.size() + 1);
+        if (!text.empty() && text[0] == ' ') text.remove_prefix(1);
+        for (const char* level : {"Error: ", "Warning: ", "Display: ", "Log: ", "Verbose: ", "VeryVerbose: ", "Fatal: ", "Critical: "}) {
+            if (text.starts_with(level)) {
+                text.remove_prefix(std::strlen(level));
+                break;
+            }
+        }
+        return text;
+    }
+
+    static EncodedBatch EncodeBatch(const LogViewerState& state, std::span<const int> rows) {
+        const size_t count = rows.size();
+        std::vector<int64_t> lines(count), timestamps(count);
+        std::vector<int32_t> frames(count), categories(count);
+        std::vector<int8_t> levels(count);
+        std::vector<uint64_t> fingerprints(count);
+        std::vector<uint8_t> hasTimestamp(count), hasFrame(count), hasFingerprint(count);
+        for (size_t n = 0; n < count; ++n) {
+            const LogEntry& log = state.AllLogs[rows[n]];
+            lines[n] = log.LogIndex;
+            timestamps[n] = log.Timestamp;
+            hasTimestamp[n] = log.Timestamp != 0;
+            const int frame = log.IsHeader ? ParseFrame(log.FullText) : -1;
+            frames[n] = std::max(0, frame);
+            hasFrame[n] = frame >= 0;
+            levels[n] = static_cast<int8_t>(log.Level);
+            categories[n] = log.CategoryId;
+            fingerprints[n] = log.ContentHash;
+            hasFingerprint[n] = log.IsHeader;
+        }
+        auto nulls = [](const std::vector<uint8_t>& valid) { return static_cast<int64_t>(std::ranges::count(valid, 0)); };
+
+        BodyBuilder body;
+        body.AddNode(count, 0);
+        body.AddBuffer(0);
+        body.AddValues(lines);
+        body.AddNode(count, nulls(hasTimestamp));
+        body.AddValidity(hasTimestamp);
+        body.AddValues(timestamps);
+        body.AddNode(count, nulls(hasFrame));
+        body.AddValidity(hasFrame);
+        body.AddValues(frames);
+        body.AddNode(count, 0);
+        body.AddBuffer(0);
+        body.AddValues(levels);
+        body.AddNode(count, 0);
+        body.AddBuffer(0);
+        body.AddValues(categories);
+        body.AddNode(count, nulls(hasFingerprint));
+        body.AddValidity(hasFingerprint);
+        body.AddValues(fingerprints);
+        body.AddStrings(count, [&](size_t n) { return Message(state.AllLogs[rows[n]]); });
+        return {body.Header(static_cast<int64_t>(count)), std::move(body.Body)};
+    }
+};
+
+// "Export Arrow" of a document, on its own thread so the UI keeps drawing
+class ArrowExportJob {
+public:
+    ~ArrowExportJob() {
+        Progress.Cancel = true;
+        Wait();
+    }
+
+    std::atomic<bool> Busy = false;
+    ArrowWriter::Progress Progress;
+    int64_t Total = 0; // Lines to export, set before Busy
+
+    // Exports the filtered lines of state. Call on the thread that appends to the log.
+    void Start(LogViewerState& state, const std::string& path) {
+        if (Busy) return;
+        Wait();
+        std::vector<int64_t> lines = ArrowWriter::Lines(state, state.FilteredIndices);
+        Total = static_cast<int64_t>(lines.size());
+        Progress.Done = 0;
+        Progress.Skipped = 0;
+        Progress.Cancel = false;
+        Busy = true;
+        Job = std::thread([this, &state, path, lines = std::move(lines)] {
+            std::string status;
+            const auto start = std::chrono::steady_clock::now();
+            if (ArrowWriter::Write(state, lines, path, status, &Progress)) {
+                const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+                char text[128];
+                snprintf(text, sizeof(text), "Exported %lld rows in %lld ms", static_cast<long long>(Total - Progress.Skipped),
+                         static_cast<long long>(ms));
+                status = text;
+                if (Progress.Skipped > 0) status += " (" + std::to_string(Progress.Skipped.load()) + " dropped by retention first)";
+            }
+            SetStatus(std::move(status));
+            Busy = false;
+        });
+    }
+
+    void Wait() {
+        if (Job.joinable()) Job.join();
+    }
+
+    std::string GetStatus() {
+        std::lock_guard lock(StatusMutex);
+        return Status;
+    }
+
+private:
+    void SetStatus(std::string status) {
+        std::lock_guard lock(StatusMutex);
+        Status = std::move(status);
+    }
+
+    std::thread Job;
+    std::mutex StatusMutex;
+    std::string Status; // Result of the last export
+};
+
+// =========================================================
+// --- ERROR TRENDS ---
+// History of Warning/Error fingerprint counts across runs, stored next to imgui.ini
+// in ulr-trends.db. The file is append-only: recording a run writes one record with
+// its id, timestamp and two columns (fingerprints, counts), so ingestion is
+// O(unique fingerprints). Each record starts with its length and CRC-32: a torn append
+// ends the file on open and is cut off before the next record. On open, the records
+// are indexed by fingerprint so a series lookup doesn't depend on the number of runs.
+constexpr uint32_t TRENDS_DB_MAGIC = 0x324E5254;        // "TRN2"
+constexpr uint32_t TRENDS_DB_LEGACY_MAGIC = 0x444E5254; // "TRND", records without framing
+constexpr const char* TRENDS_DB_NAME = "ulr-trends.db";
+
+struct TrendRun {
+    std::string Id;
+    int64_t Timestamp = 0;
+};
+
+struct TrendPoint {
+    uint32_t Run = 0; // Index in TrendDatabase::Runs
+    uint32_t Count = 0;
+};
+
+class TrendDatabase {
+public:
+    std::vector<TrendRun> Runs; // In recording order
+    std::unordered_map<uint64_t, std::vector<TrendPoint>> Series;
+
+    void Open(const std::filesystem::path& path) {
+        Path = path;
+        Runs.clear();
+        Chronological.clear();
+        Series.clear();
+        ValidBytes = 0;
+        BinaryReader reader(Path);
+        const uint32_t magic = reader.Read<uint32_t>();
+        if (!reader.Ok()) return;
+        if (magic == TRENDS_DB_LEGACY_MAGIC) {
+            OpenLegacy(reader);
+            return;
+        }
+        if (magic != TRENDS_DB_MAGIC) return;
+        ValidBytes = sizeof(magic);
+        for (;;) {
+            const uint32_t length = reader.Read<uint32_t>();
+            const uint32_t checksum = reader.Read<uint32_t>();
+            if (!reader.CanRead(length)) break;
+            TrendRun run;
+            run.Id = reader.ReadString();
+            run.Timestamp = reader.Read<int64_t>();
+            const std::vector<uint64_t> fingerprints = reader.ReadVector<uint64_t>();
+            const std::vector<uint32_t> counts = reader.ReadVector<uint32_t>();
+            if (!reader.Ok() || fingerprints.size() != counts.size() || RecordBytes(run, fingerprints, counts) != length ||
+                RecordChecksum(run, fingerprints, counts) != checksum)
+                break;
+            ValidBytes += 2 * sizeof(uint32_t) + length;
+            AddRun(std::move(run), fingerprints, counts);
+        }
+    }
+
+    bool HasRun(const std::string& id) const {
+        return std::ranges::any_of(Runs, [&](const TrendRun& run) { return run.Id == id; });
+    }
+
+    // Appends one run to the file and to the in-memory index
+    bool Record(TrendRun run, const std::vector<uint64_t>& fingerprints, const std::vector<uint32_t>& counts) {
+        if (HasRun(run.Id)) return false;
+        // Whatever follows the last valid record (a torn append, an unknown file) is cut off
+        std::error_code error;
+        if (std::filesystem::exists(Path, error) && std::filesystem::file_size(Path, error) != ValidBytes) {
+            std::filesystem::resize_file(Path, ValidBytes, error);
+            if (error) return false;
+        }
+        const uint32_t length = RecordBytes(run, fingerprints, counts);
+        {
+            BinaryWriter writer(Path, std::ios::app);
+            if (ValidBytes == 0) writer.Write(TRENDS_DB_MAGIC);
+            WriteRecord(writer, run, fingerprints, counts);
+            writer.File.flush();
+            if (!writer.File) return false;
+        }
+        ValidBytes += (ValidBytes == 0 ? sizeof(uint32_t) : 0) + 2 * sizeof(uint32_t) + length;
+        AddRun(std::move(run), fingerprints, counts);
+        return true;
+    }
+
+    // Count of the fingerprint in every run, in chronological order (0 where absent)
+    std::vector<float> History(uint64_t fingerprint) const {
+        std::vector<float> counts(Runs.size(), 0.0f);
+        if (auto it = Series.find(fingerprint); it != Series.end()) {
+            for (const TrendPoint& point : it->second) counts[point.Run] = static_cast<float>(point.Count);
+        }
+        std::vector<float> ordered;
+        ordered.reserve(counts.size());
+        for (uint32_t run : Chronological) ordered.push_back(counts[run]);
+        return ordered;
+    }
+
+    // The oldest run (by timestamp) where the fingerprint appears, or -1
+    int FirstRun(uint64_t fingerprint) const {
+        auto it = Series.find(fingerprint);
+        if (it == Series.end()) return -1;
+        int first = -1;
+        for (const TrendPoint& point : it->second) {
+            if (first == -1 || Runs[point.Run].Timestamp < Runs[first].Timestamp) first = static_cast<int>(point.Run);
+        }
+        return first;
+    }
+
+private:
+    void AddRun(TrendRun run, const std::vector<uint64_t>& fingerprints, const std::vector<uint32_t>& counts) {
+        const uint32_t runIndex = static_cast<uint32_t>(Runs.size());
+        // After the runs with the same timestamp, so they stay in recording order
+        const auto position = std::ranges::upper_bound(Chronological, run.Timestamp, {}, [&](uint32_t r) { return Runs[r].Timestamp; });
+        Chronological.insert(position, runIndex);
+        Runs.push_back(std::move(run));
+        for (size_t n = 0; n < fingerprints.size(); ++n)
+            Series[fingerprints[n]].push_back({runIndex, counts[n]});
+    }
+
+    // Payload of a record, as written by WriteRecord after the length and checksum
+    static uint32_t RecordBytes(const TrendRun& run, const std::vector<uint64_t>& fingerprints, const std::vector<uint32_t>& counts) {
+        return static_cast<uint32_t>(sizeof(uint32_t) + run.Id.size() + sizeof(int64_t) + sizeof(uint64_t) + fingerprints.size() * sizeof(uint64_t) +
+                                     sizeof(uint64_t) + counts.size() * sizeof(uint32_t));
+    }
+
+    static uint32_t RecordChecksum(const TrendRun& run, const std::vector<uint64_t>& fingerprints, const std::vector<uint32_t>& counts) {
+        uLong crc = crc32(0, nullptr, 0);
+        auto add = [&](const void* data, size_t bytes) { crc = crc32_z(crc, static_cast<const Bytef*>(data), bytes); };
+        add(run.Id.data(), run.Id.size());
+        add(&run.Timestamp, sizeof(run.Timestamp));
+        add(fingerprints.data(), fingerprints.size() * sizeof(uint64_t));
+        add(counts.data(), counts.size() * sizeof(uint32_t));
+        return static_cast<uint32_t>(crc);
+    }
+
+    static void WriteRecord(BinaryWriter& writer, const TrendRun& run, const std::vector<uint64_t>& fingerprints, const std::vector<uint32_t>& counts) {
+        writer.Write(RecordBytes(run, fingerprints, counts));
+        writer.Write(RecordChecksum(run, fingerprints, counts));
+        writer.WriteString(run.Id);
+        writer.Write(run.Timestamp);
+        writer.WriteVector(fingerprints);
+        writer.WriteVector(counts);
+    }
+
+    // Reads a database written before records were framed, then rewrites it framed
+    void OpenLegacy(BinaryReader& reader) {
+        std::vector<std::pair<std::vector<uint64_t>, std::vector<uint32_t>>> columns;
+        for (;;) {
+            TrendRun run;
+            run.Id = reader.ReadString();
+            run.Timestamp = reader.Read<int64_t>();
+            std::vector<uint64_t> fingerprints = reader.ReadVector<uint64_t>();
+            std::vector<uint32_t> counts = reader.ReadVector<uint32_t>();
+            if (!reader.Ok() || fingerprints.size() != counts.size()) break;
+            AddRun(std::move(run), fingerprints, counts);
+            columns.emplace_back(std::move(fingerprints), std::move(counts));
+        }
+        std::filesystem::path tempPath = Path;
+        tempPath += ".tmp";
+        {
+            BinaryWriter writer(tempPath);
+            writer.Write(TRENDS_DB_MAGIC);
+            for (size_t r = 0; r < Runs.size(); ++r) WriteRecord(writer, Runs[r], columns[r].first, columns[r].second);
+            writer.File.flush();
+            if (!writer.File) return; // Stays read-only: ValidBytes = 0 would overwrite it
+        }
+        std::error_code error;
+        std::filesystem::rename(tempPath, Path, error);
+        if (!error) ValidBytes = std::filesystem::file_size(Path, error);
+    }
+
+    std::filesystem::path Path;
+    std::vector<uint32_t> Chronological; // Indices in Runs by timestamp
+    uint64_t ValidBytes = 0;             // End of the last valid record, 0 = no valid header
+};
+
+// Counts the Warning/Error fingerprints of a loaded log (sorted by fingerprint)
+void CountRunFingerprints(const LogViewerState& state, std::vector<uint64_t>& fingerprints, std::vector<uint32_t>& counts) {
+    std::map<uint64_t, uint32_t> histogram;
+    for (const LogEntry& log : state.AllLogs) {
+        if (log.IsHeader && log.Level != LogLevel::Display) histogram[log.ContentHash]++;
+    }
+    fingerprints.clear();
+    counts.clear();
+    for (const auto& [fingerprint, count] : histogram) {
+        fingerprints.push_back(fingerprint);
+        counts.push_back(count);
+    }
+}
+
+// =========================================================
+// --- RARE MESSAGES ---
+// The novel error of a 10M-line log is a fingerprint seen once or twice among millions of
+// routine messages. Every message gets a MessageId and an occurrence count while lines are
+// added (LogViewerState::MessageCounts), so ranking by rarity is a sort of the distinct
+// messages, and the "Rare" filter is a bitmap by MessageId. With a baseline log, occurrences
+// are counted in the baseline instead: 0 means never seen in the baseline.
+
+// Counts the message fingerprints of a log file (.gz too) without keeping its lines
+bool CountLogFileFingerprints(const std::string& path, FingerprintCounts& counts) {
+    LogLineParser parser;
+    std::string partial;
+    auto addLine = [&](std::string line) {
+        LogEntry entry;
+        if (parser.Parse(std::move(line), entry) && entry.IsHeader) counts[entry.ContentHash]++;
+    };
+    auto append = [&](std::string_view data) {
+        SplitLines(partial, data, [&](std::string&& line) {
+            addLine(std::move(line));
+            return !parser.ReachedSummary;
+        });
+        return !parser.ReachedSummary;
+    };
+
+    if (IsGzipFile(path)) {
+        GzipIndex index;
+        if (!index.ReadAll(path, append)) return false;
+    } else {
+        FileBlockReader reader;
+        if (!reader.Open(path)) return false;
+        std::string_view block;
+        while (!parser.ReachedSummary && reader.Next(block)) append(block);
+    }
+    if (!partial.empty()) addLine(std::move(partial));
+    return true;
+}
+
+// MessageIds from the rarest: fewest occurrences (in the baseline when there is one), then
+// fewest in this log, then first seen. Messages whose lines were all dropped are left out.
+std::vector<int> RankRareMessages(const LogViewerState& state, const FingerprintCounts* baseline) {
+    // Sorted as (occurrences, count) packed in one key, then id: ids are in order of first occurrence
+    std::vector<std::pair<uint64_t, int>> keys;
+    keys.reserve(state.MessageCounts.size());
+    for (int message = 0; message < (int)state.MessageCounts.size(); ++message) {
+        if (state.MessageCounts[message] == 0) continue;
+        const uint64_t occurrences = static_cast<uint32_t>(state.MessageOccurrences(message, baseline));
+        keys.push_back({occurrences << 32 | static_cast<uint32_t>(state.MessageCounts[message]), message});
+    }
+    std::ranges::sort(keys);
+    std::vector<int> ranking(keys.size());
+    for (size_t n = 0; n < keys.size(); ++n) ranking[n] = keys[n].second;
+    return ranking;
+}
+
+// =========================================================
+// --- SIMILAR MESSAGES ---
+// "Find Similar" looks for messages worded alike even when their fingerprints differ
+// (rephrased messages, other paths or ids). Every distinct message (MessageId) is cut into
+// shingles (its words and pairs of consecutive words) and summarized by a MinHash signature
+// of MINHASH_BANDS x MINHASH_ROWS values; messages sharing all the values of one band land in
+// the same LSH bucket. Buckets are sorted arrays of (band key, MessageId), built per document
+// in a background pass over the messages and extended when new ones appear. A lookup takes
+// the messages sharing a bucket with the query and verifies them with the exact Jaccard
+// similarity of their shingles, on the same background thread and the pool.
+constexpr int MINHASH_BANDS = 16;
+constexpr int MINHASH_ROWS = 3; // Jaccard 0.4: candidate 65% of the time, 0.5: 88%, 0.7: 99.8%
+constexpr int MINHASH_SIZE = MINHASH_BANDS * MINHASH_ROWS;
+constexpr size_t SIMILAR_MAX_BYTES = 1024;      // Only the beginning of very long messages is compared
+constexpr int SIMILAR_BATCH = 65536;            // Messages indexed per hold of DataMutex
+constexpr size_t SIMILAR_MAX_CANDIDATES = 20000;
+constexpr double SIMILAR_MIN_JACCARD = 0.4;
+constexpr size_t SIMILAR_MAX_RESULTS = 500;
+
+// Message of a header line, without its "[timestamp][frame]" prefix
+std::string_view MessageBody(std::string_view line) {
+    while (!line.empty() && line[0] == '[') {
+        const size_t end = line.find(']');
+        if (end == std::string_view::npos) break;
+        line.remove_prefix(end + 1);
+    }
+    while (!line.empty() && (line[0] == ' ' || line[0] == '>')) line.remove_prefix(1);
+    return line.substr(0, SIMILAR_MAX_BYTES);
+}
+
+// Shingles of a message: hashes of its words (runs of letters, digits and '_', case folded)
+// and of every pair of consecutive words, sorted and unique. Numbers are all the same word,
+// so "Took 12 ms" and "took 7 ms" have the same shingles, and paths split on their separators.
+void MessageShingles(std::string_view line, std::vector<uint64_t>& shingles) {
+    shingles.clear();
+    const std::string_view body = MessageBody(line);
+    uint64_t previous = 0;
+    for (size_t i = 0; i < body.size();) {
+        const auto isWord = [&](size_t at) { return std::isalnum(static_cast<unsigned char>(body[at])) || body[at] == '_'; };
+        if (!isWord(i)) {
+            i++;
+            continue;
+        }
+        uint64_t word = 0xcbf29ce484222325ull;
+        bool number = true;
+        for (; i < body.size() && isWord(i); ++i) {
+            number &= std::isdigit(static_cast<unsigned char>(body[i])) != 0;
+            word = (word ^ static_cast<unsigned char>(AsciiLower(body[i]))) * 0x100000001b3ull;
+        }
+        if (number) word = 0x4E554D424552ull; // "NUMBER"
+        shingles.push_back(word);
+        if (previous) shingles.push_back((previous ^ (word >> 1)) * 0x9E3779B97F4A7C15ull);
+        previous = word;
+    }
+    std::ranges::sort(shingles);
+    shingles.erase(std::unique(shingles.begin(), shingles.end()), shingles.end());
+}
+
+// Keys of the LSH buckets of a shingle set, one per band. The MinHash functions are
+// h(x) = a * mix(x) + b (mod 2^32) with odd a: 32-bit lanes, so the loop over them vectorizes.
+void MinHashBandKeys(const std::vector<uint64_t>& shingles, uint32_t* keys) {
+    struct Seeds {
+        uint32_t A[MINHASH_SIZE];
+        uint32_t B[MINHASH_SIZE];
+        Seeds() {
+            std::mt19937 random(0x5EED);
+            for (int i = 0; i < MINHASH_SIZE; ++i) {
+                A[i] = random() | 1;
+                B[i] = random();
+            }
+        }
+    };
+    static const Seeds seeds;
+
+    uint32_t signature[MINHASH_SIZE];
+    std::fill(std::begin(signature), std::end(signature), UINT32_MAX);
+    for (uint64_t shingle : shingles) {
+        shingle = (shingle ^ (shingle >> 31)) * 0xBF58476D1CE4E5B9ull;
+        const uint32_t mixed = static_cast<uint32_t>(shingle >> 32);
+        for (int i = 0; i < MINHASH_SIZE; ++i)
+            signature[i] = std::min(signature[i], seeds.A[i] * mixed + seeds.B[i]);
+    }
+    for (int band = 0; band < MINHASH_BANDS; ++band) {
+        uint64_t key = 0xcbf29ce484222325ull ^ band;
+        for (int row = 0; row < MINHASH_ROWS; ++row) key = (key ^ signature[band * MINHASH_ROWS + row]) * 0x100000001b3ull;
+        keys[band] = static_cast<uint32_t>(key >> 32);
+    }
+}
+
+// Jaccard similarity of two sorted shingle sets
+double ShingleSimilarity(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b) {
+    if (a.empty() || b.empty()) return 0.0;
+    size_t common = 0;
+    for (size_t i = 0, j = 0; i < a.size() && j < b.size();) {
+        if (a[i] < b[j]) i++;
+        else if (b[j] < a[i]) j++;
+        else { common++; i++; j++; }
+    }
+    return static_cast<double>(common) / static_cast<double>(a.size() + b.size() - common);
+}
+
+// Text of the first occurrence of a message, empty if retention dropped it
+std::string_view MessageFirstText(const LogViewerState& state, int message) {
+    const int64_t line = state.MessageFirstLines[message] - state.DroppedLines;
+    if (line < 0 || line >= (int64_t)state.AllLogs.size()) return {};
+    return state.AllLogs[line].FullText;
+}
+
+struct SimilarMessage {
+    int Message = 0; // MessageId
+    float Similarity = 0.0f;
+};
+
+class SimilarityIndex {
+public:
+    ~SimilarityIndex() { Clear(); }
+
+    // Progress of the background pass (indexing, or a lookup when Searching)
+    std::atomic<bool> Busy = false;
+    std::atomic<bool> Searching = false;
+    std::atomic<int> Done = 0;
+    std::atomic<int> Total = 0;
+
+    // Last lookup, run once the index covers the message (see RenderSimilarPanel). UI thread only.
+    int Query = -1;           // MessageId
+    int QueryGeneration = -1; // LogViewerState::LoadGeneration of Query
+    bool QueryPending = false;
+    std::vector<SimilarMessage> Results;
+
+    bool IsCurrent(const LogViewerState& state) const {
+        return !Busy && Generation == state.LoadGeneration && Indexed == state.MessageCounts.size();
+    }
+
+    bool Covers(const LogViewerState& state, int message) const {
+        return !Busy && Generation == state.LoadGeneration && message < (int)Indexed;
+    }
+
+    // Indexes the messages that appeared since the last pass, in the background
+    void Update(LogViewerState& state) {
+        if (Busy) return;
+        Wait();
+        if (Generation != state.LoadGeneration) {
+            for (auto& band : Bands) std::vector<uint64_t>().swap(band);
+            Indexed = 0;
+            Generation = state.LoadGeneration;
+        }
+        Busy = true;
+        Cancel = false;
+        Job = std::thread([this, &state] {
+            Build(state);
+            Busy = false;
+        });
+    }
+
+    // Looks up Query in the background. Collect() hands the results over once it is done.
+    void Search(LogViewerState& state) {
+        if (Busy) return;
+        Wait();
+        Busy = true;
+        Searching = true;
+        Cancel = false;
+        Job = std::thread([this, &state, message = Query] {
+            std::vector<SimilarMessage> found;
+            {
+                std::shared_lock dataLock(state.DataMutex);
+                if (!Cancel && state.LoadGeneration == Generation) found = Find(state, message);
+            }
+            Found = std::move(found);
+            FoundQuery = message;
+            Searching = false;
+            Busy = false;
+        });
+    }
+
+    // Moves the results of a finished lookup of Query into Results. UI thread.
+    bool Collect() {
+        if (Busy || FoundQuery < 0) return false;
+        const bool current = FoundQuery == Query;
+        if (current) Results = std::move(Found);
+        Found.clear();
+        FoundQuery = -1;
+        return current;
+    }
+
+    // Messages whose shingles are at least SIMILAR_MIN_JACCARD alike, the most similar first.
+    // Under a shared DataMutex, on the thread of the background pass (it modifies Bands).
+    std::vector<SimilarMessage> Find(const LogViewerState& state, int message) const {
+        std::vector<SimilarMessage> results;
+        std::vector<uint64_t> query;
+        MessageShingles(MessageFirstText(state, message), query);
+        if (query.empty() || Generation != state.LoadGeneration) return results;
+        uint32_t keys[MINHASH_BANDS];
+        MinHashBandKeys(query, keys);
+
+        std::vector<int> candidates;
+        for (int band = 0; band < MINHASH_BANDS && candidates.size() < SIMILAR_MAX_CANDIDATES; ++band) {
+            const uint64_t key = static_cast<uint64_t>(keys[band]) << 32;
+            for (auto it = std::ranges::lower_bound(Bands[band], key); it != Bands[band].end() && (*it >> 32) == keys[band]; ++it) {
+                candidates.push_back(static_cast<int>(*it & 0xFFFFFFFF));
+                if (candidates.size() >= SIMILAR_MAX_CANDIDATES) break;
+            }
+        }
+        std::ranges::sort(candidates);
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        std::vector<float> similarities(candidates.size(), 0.0f);
+        g_ThreadPool.ParallelFor(static_cast<int>(candidates.size()), 256, [&](int first, int last) {
+            std::vector<uint64_t> shingles;
+            for (int n = first; n < last; ++n) {
+                if (candidates[n] == message) continue;
+                MessageShingles(MessageFirstText(state, candidates[n]), shingles);
+                similarities[n] = static_cast<float>(ShingleSimilarity(query, shingles));
+            }
+        });
+        for (size_t n = 0; n < candidates.size(); ++n) {
+            if (similarities[n] >= SIMILAR_MIN_JACCARD) results.push_back({candidates[n], similarities[n]});
+        }
+        std::ranges::sort(results, [&](const SimilarMessage& a, const SimilarMessage& b) {
+            if (a.Similarity != b.Similarity) return a.Similarity > b.Similarity;
+            return state.MessageCounts[a.Message] > state.MessageCounts[b.Message];
+        });
+        if (results.size() > SIMILAR_MAX_RESULTS) results.resize(SIMILAR_MAX_RESULTS);
+        return results;
+    }
+
+    void Wait() {
+        if (Job.joinable()) Job.join();
+    }
+
+    void Clear() {
+        Cancel = true;
+        Wait();
+        for (auto& band : Bands) std::vector<uint64_t>().swap(band);
+        Indexed = 0;
+        Generation = -1;
+        Query = -1;
+        QueryGeneration = -1;
+        QueryPending = false;
+        Results.clear();
+        Found.clear();
+        FoundQuery = -1;
+    }
+
+private:
+    std::vector<SimilarMessage> Found; // Results of the last lookup, until Collect()
+    int FoundQuery = -1;               // MessageId of Found, -1 = none
+    std::vector<uint64_t> Bands[MINHASH_BANDS]; // (band key << 32 | MessageId), sorted
+    size_t Indexed = 0;  // Messages [0, Indexed) are in Bands
+    int Generation = -1; // LogViewerState::LoadGeneration of the messages
+    std::atomic<bool> Cancel = false;
+    std::thread Job;
+
+    // The lines are only read under a shared DataMutex, released between batches so appends go on
+    void Build(LogViewerState& state) {
+        std::vector<uint64_t> added[MINHASH_BANDS];
+        std::vector<uint32_t> keys;
+        for (;;) {
+            std::shared_lock dataLock(state.DataMutex);
+            if (Cancel || state.LoadGeneration != Generation) break; // Stale: the next Update starts over
+            const size_t begin = Indexed;
+            const size_t end = std::min(state.MessageCounts.size(), begin + SIMILAR_BATCH);
+            Total = static_cast<int>(state.MessageCounts.size());
+            if (begin == end) break;
+
+            keys.assign((end - begin) * MINHASH_BANDS, 0);
+            std::vector<uint8_t> indexed(end - begin, 0);
+            g_ThreadPool.ParallelFor(static_cast<int>(end - begin), 1024, [&](int first, int last) {
+                std::vector<uint64_t> shingles;
+                for (int n = first; n < last; ++n) {
+                    MessageShingles(MessageFirstText(state, static_cast<int>(begin + n)), shingles);
+                    if (shingles.empty()) continue; // Dropped by retention or blank
+                    MinHashBandKeys(shingles, &keys[static_cast<size_t>(n) * MINHASH_BANDS]);
+                    indexed[n] = 1;
+                }
+            });
+            dataLock.unlock();
+
+            for (size_t n = 0; n < end - begin; ++n) {
+                if (!indexed[n]) continue;
+                for (int band = 0; band < MINHASH_BANDS; ++band)
+                    added[band].push_back(static_cast<uint64_t>(keys[n * MINHASH_BANDS + band]) << 32 | (begin + n));
+            }
+            Indexed = end;
+            Done = static_cast<int>(end);
+        }
+
+        g_ThreadPool.ParallelFor(MINHASH_BANDS, 1, [&](int first, int last) {
+            for (int band = first; band < last; ++band) {
+                std::ranges::sort(added[band]);
+                const size_t middle = Bands[band].size();
+                Bands[band].insert(Bands[band].end(), added[band].begin(), added[band].end());
+                std::inplace_merge(Bands[band].begin(), Bands[band].begin() + middle, Bands[band].end());
+            }
+        });
+    }
+};
+
+// =========================================================
+// --- ALERT RULES ---
+// Rules are evaluated on lines as they arrive in follow mode, e.g.:
+//   category=LogNet level=Error count>10 window=30s   (more than 10 LogNet errors in 30s)
+//   text="Fatal:"                                      (any fatal error)
+// Terms: level=Error|Warning|Display, category=Name, text=substring (case-insensitive),
+// count>N (default 0: every match fires), window=N[ms|s|m|h] (default: unlimited).
+// A message counts once, however many of its continuation lines (e.g. a callstack) match.
+// Each rule is compiled once into a matcher; evaluation only looks at the newly appended
+// lines and keeps the match times of the window in a deque, so history is never rescanned.
+struct AlertRule {
+    std::string Source;
+    int LevelMask = 0b111; // Bit per LogLevel
+    std::string Category;  // Empty = any
+    CaseInsensitiveSearch Text; // Empty = any
+    int Threshold = 0;     // Fires when more than Threshold lines match within the window
+    int64_t WindowMs = 0;  // 0 = no window
+    std::deque<int64_t> MatchTimes;
+    const LogViewerState* LastMessageLog = nullptr; // Last counted message: its log and header LogIndex
+    int LastMessage = -1;
+    // The first match picks the clock of the window: log time, or arrival time for logs without timestamps
+    bool ClockChosen = false;
+    bool WallClock = false;
+    int64_t LastLogTime = 0;
+};
+
+struct AlertEvent {
+    std::string Rule;
+    std::string Text;
+    int64_t LogIndex = 0; // Of the line, stays valid when retention drops lines (see DroppedLines)
+    int LoadGeneration = 0;
+    int64_t Time = 0;
+    int Document = 0;     // LogDocument::Id of the line
+};
+
+// "30s", "5m", "250ms", "2h"; a plain number is seconds. False on anything else ("5min", "10x").
+static bool ParseDurationMs(const std::string& text, int64_t& ms) {
+    char* end = nullptr;
+    const double value = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || value < 0) return false;
+    const std::string unit = end;
+    if (unit == "ms") ms = static_cast<int64_t>(value);
+    else if (unit == "s" || unit.empty()) ms = static_cast<int64_t>(value * 1000);
+    else if (unit == "m") ms = static_cast<int64_t>(value * 60000);
+    else if (unit == "h") ms = static_cast<int64_t>(value * 3600000);
+    else return false;
+    return true;
+}
+
+bool CompileAlertRule(const std::string& source, AlertRule& rule, std::string& error) {
+    rule = {};
+    rule.Source = source;
+    const std::vector<std::string> tokens = TokenizeQuery(source);
+    if (tokens.empty()) {
+        error = "Empty rule";
+        return false;
+    }
+    for (size_t pos = 0; pos < tokens.size(); ++pos) {
+        const std::string key = ToLowerCopy(tokens[pos]);
+        if (key.rfind("count>", 0) == 0) {
+            rule.Threshold = std::atoi(key.c_str() + 6);
+            continue;
+        }
+        if (pos + 2 >= tokens.size() || tokens[pos + 1] != "=") {
+            error = "Expected key=value near '" + tokens[pos] + "'";
+            return false;
+        }
+        const std::string& value = tokens[pos + 2];
+        pos += 2;
+        if (key == "level") {
+            const std::string level = ToLowerCopy(value);
+            if (level == "error") rule.LevelMask = 1 << static_cast<int>(LogLevel::Error);
+            else if (level == "warning") rule.LevelMask = 1 << static_cast<int>(LogLevel::Warning);
+            else if (level == "display") rule.LevelMask = 1 << static_cast<int>(LogLevel::Display);
+            else { error = "Unknown level '" + value + "'"; return false; }
+        } else if (key == "category") {
+            rule.Category = value;
+        } else if (key == "text") {
+            rule.Text = CaseInsensitiveSearch(value);
+        } else if (key == "window") {
+            if (!ParseDurationMs(value, rule.WindowMs)) {
+                error = "Invalid window '" + value + "', use ms, s, m or h";
+                return false;
+            }
+        } else {
+            error = "Unknown rule term '" + tokens[pos - 2] + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+class AlertEngine {
+public:
+    std::vector<AlertRule> Rules;
+    std::vector<AlertEvent> Events; // Fired alerts, oldest first
+
+    // Evaluates the rules on lines [begin, AllLogs.size()). Returns the number of alerts fired.
+    // Every open log goes through the same rules, so match windows count across all of them.
+    int Evaluate(const LogViewerState& state, int begin) {
+        const int firedBefore = static_cast<int>(Events.size());
+        const int64_t wallClock = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        int firstHeader = begin; // Message of the continuation lines at begin
+        while (firstHeader > 0 && firstHeader < (int)state.AllLogs.size() && !state.AllLogs[firstHeader].IsHeader) firstHeader--;
+
+        for (AlertRule& rule : Rules) {
+            int categoryId = -1; // Category ids are interned per log
+            if (!rule.Category.empty()) {
+                auto it = state.CategoryIds.find(rule.Category);
+                if (it == state.CategoryIds.end()) continue; // Category not seen yet, nothing can match
+                categoryId = it->second;
+            }
+
+            int message = firstHeader < (int)state.AllLogs.size() ? state.AllLogs[firstHeader].LogIndex : -1;
+            for (int i = begin; i < (int)state.AllLogs.size(); ++i) {
+                const LogEntry& log = state.AllLogs[i];
+                if (log.IsHeader) message = log.LogIndex;
+                if (message == rule.LastMessage && &state == rule.LastMessageLog) continue;
+                if (!(rule.LevelMask & (1 << static_cast<int>(log.Level)))) continue;
+                if (categoryId >= 0 && log.CategoryId != categoryId) continue;
+                if (!rule.Text.Empty() && !rule.Text.Matches(log.FullText, log.Ascii)) continue;
+                rule.LastMessageLog = &state;
+                rule.LastMessage = message;
+
+                if (!rule.ClockChosen) {
+                    rule.ClockChosen = true;
+                    rule.WallClock = log.Timestamp == 0;
+                }
+                if (!rule.WallClock && log.Timestamp != 0) rule.LastLogTime = log.Timestamp;
+                const int64_t time = rule.WallClock ? wallClock : rule.LastLogTime;
+                rule.MatchTimes.push_back(time);
+                while (rule.WindowMs > 0 && rule.MatchTimes.front() < time - rule.WindowMs)
+                    rule.MatchTimes.pop_front();
+
+                if ((int)rule.MatchTimes.size() > rule.Threshold) {
+                    Events.push_back({rule.Source, log.FullText, log.LogIndex, state.LoadGeneration, time});
+                    rule.MatchTimes.clear(); // Start counting again for the next alert
+                }
+            }
+        }
+        return static_cast<int>(Events.size()) - firedBefore;
+    }
+
+    // Forget the window state, used when the log is reloaded from scratch
+    void ResetWindows() {
+        for (AlertRule& rule : Rules) {
+            rule.MatchTimes.clear();
+            rule.LastMessageLog = nullptr;
+            rule.ClockChosen = false;
+        }
+    }
+};
+
+// =========================================================
+// --- STREAM INPUT ---
+// Reads stdin ("-") or a named pipe on a background thread, e.g.
+//   ssh buildbox tail -f Saved/Logs/Game.log | UnrealLogsReader -
+// Blocks are handed to the UI thread and parsed by LogViewerState::AppendText like a
+// followed file. The reader waits while too many bytes are pending (back-pressure).
+constexpr size_t STREAM_MAX_PENDING_BYTES = 64 * 1024 * 1024;
+
+class StreamReader {
+public:
+    bool Start(const std::string& path) {
+        FILE* input = (path == "-") ? stdin : fopen(path.c_str(), "rb");
+        if (input == nullptr) return false;
+#ifdef _WIN32
+        _setmode(_fileno(input), _O_BINARY);
+#endif
+        // The thread may stay blocked in read() forever, so it only owns shared state
+        Shared = std::make_shared<SharedState>();
+        std::thread([shared = Shared, input] {
+            std::vector<char> block(1 << 16);
+            for (;;) {
+                // read() returns what is available, fread() would wait for a full block
+#ifdef _WIN32
+                const int received = _read(_fileno(input), block.data(), static_cast<unsigned>(block.size()));
+#else
+                const ssize_t received = read(fileno(input), block.data(), block.size());
+#endif
+                if (received <= 0) break;
+                std::unique_lock lock(shared->Mutex);
+                shared->Space.wait(lock, [&] { return shared->Detached || shared->Pending.size() < STREAM_MAX_PENDING_BYTES; });
+                if (shared->Detached) break;
+                shared->Pending.append(block.data(), static_cast<size_t>(received));
+            }
+            if (input != stdin) fclose(input);
+            std::lock_guard lock(shared->Mutex);
+            shared->Finished = true;
+        }).detach();
+        return true;
+    }
+
+    // Stops consuming; the reader thread exits on its next block
+    void Detach() {
+        if (!Shared) return;
+        {
+            std::lock_guard lock(Shared->Mutex);
+            Shared->Detached = true;
+        }
+        Shared->Space.notify_all();
+        Shared.reset();
+    }
+
+    bool IsActive() const { return Shared != nullptr; }
+
+    bool IsFinished() const {
+        if (!Shared) return true;
+        std::lock_guard lock(Shared->Mutex);
+        return Shared->Finished && Shared->Pending.empty();
+    }
+
+    // Everything received since the last call
+    std::string Take() {
+        std::string bytes;
+        if (!Shared) return bytes;
+        {
+            std::lock_guard lock(Shared->Mutex);
+            bytes.swap(Shared->Pending);
+        }
+        Shared->Space.notify_all();
+        return bytes;
+    }
+
+private:
+    struct SharedState {
+        std::mutex Mutex;
+        std::condition_variable Space;
+        std::string Pending;
+        bool Finished = false;
+        bool Detached = false;
+    };
+    std::shared_ptr<SharedState> Shared;
+};
+
+// =========================================================
+// --- NETWORK INGESTION ---
+// Local game/server instances can stream their log to the viewer instead of writing files:
+//   TCP 127.0.0.1:<port>  one stream per connection, newline-separated lines
+//   UDP 127.0.0.1:<port>  one stream per sender, each datagram holds whole lines
+// Each stream gets its own source id and LogLineParser. TCP connections are received and
+// parsed on their own thread, so streams are parsed in parallel; parsed batches are queued
+// and appended by the UI thread. When the queue is full the readers stop reading, TCP flow
+// control then slows the senders down instead of lines being dropped.
+// Source ids are 16 bits (0 is a loaded file): once they run out, new senders are refused.
+// e.g.: tail -f Saved/Logs/Server.log | nc 127.0.0.1 8766
+constexpr size_t INGEST_MAX_PENDING_ENTRIES = 1 << 20;
+constexpr int INGEST_MAX_SOURCE_ID = UINT16_MAX;
+
+class IngestServer {
+public:
+    ~IngestServer() { Stop(); }
+
+    bool IsRunning() const { return Running; }
+    int Port() const { return BoundPort; }
+    const std::string& LastError() const { return Error; }
+    int RefusedSenders() const { return Refused; }
+    size_t ConnectionThreadCount() {
+        std::lock_guard lock(Mutex);
+        return ConnectionThreads.size();
+    }
+
+    bool Start(int port) {
+        Stop();
+#ifdef _WIN32
+        WSADATA wsaData;
+        WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        TcpSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        UdpSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        const int reuse = 1;
+        setsockopt(TcpSocket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+        const int receiveBuffer = 8 * 1024 * 1024; // Bursts of datagrams wait in the kernel, not dropped
+        setsockopt(UdpSocket, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&receiveBuffer), sizeof(receiveBuffer));
+        socklen_t addressSize = sizeof(address);
+        if (TcpSocket == INVALID_SOCKET_HANDLE || UdpSocket == INVALID_SOCKET_HANDLE ||
+            bind(TcpSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(TcpSocket, 64) != 0 ||
+            getsockname(TcpSocket, reinterpret_cast<sockaddr*>(&address), &addressSize) != 0 || // Port 0: UDP takes the one TCP got
+            bind(UdpSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            Error = "Cannot listen on 127.0.0.1:" + std::to_string(port);
+            CloseListeners();
+            return false;
+        }
+
+        Error.clear();
+        BoundPort = ntohs(address.sin_port);
+        NextSourceId = 1;
+        Refused = 0;
+        Running = true;
+        ListenThread = std::thread([this] { ListenLoop(); });
+        return true;
+    }
+
+    void Stop() {
+        if (!Running) return;
+        Running = false;
+        Space.notify_all();
+        ListenThread.join();
+        {
+            // Wake up the connection threads blocked in recv()
+            std::lock_guard lock(Mutex);
+            for (SocketHandle client : Clients) shutdown(client, 2);
+        }
+        for (std::thread& thread : ConnectionThreads) thread.join();
+        ConnectionThreads.clear();
+        FinishedConnections.clear();
+        CloseListeners();
+    }
+
+    // Moves out the entries parsed since the last call and the sources that appeared
+    void Take(std::vector<LogEntry>& entries, std::vector<std::pair<int, std::string>>& newSources) {
+        {
+            std::lock_guard lock(Mutex);
+            entries.swap(Pending);
+            Pending.clear();
+            newSources.swap(NewSources);
+            NewSources.clear();
+        }
+        Space.notify_all();
+    }
+
+private:
+    struct Stream {
+        int SourceId = 0;
+        LogLineParser Parser;
+        std::string PartialLine;
+    };
+
+    void CloseListeners() {
+        if (TcpSocket != INVALID_SOCKET_HANDLE) CloseSocket(TcpSocket);
+        if (UdpSocket != INVALID_SOCKET_HANDLE) CloseSocket(UdpSocket);
+        TcpSocket = UdpSocket = INVALID_SOCKET_HANDLE;
+    }
+
+    // -1 when every source id is taken
+    int RegisterSource(const std::string& name) {
+        std::lock_guard lock(Mutex);
+        if (NextSourceId > INGEST_MAX_SOURCE_ID) {
+            Refused++;
+            return -1;
+        }
+        const int id = NextSourceId++;
+        NewSources.emplace_back(id, name);
+        return id;
+    }
+
+    // Joins the connection threads that have returned, so they don't pile up until Stop()
+    void ReapConnections() {
+        std::vector<std::thread> finished;
+        {
+            std::lock_guard lock(Mutex);
+            for (std::thread::id id : FinishedConnections) {
+                auto it = std::ranges::find(ConnectionThreads, id, &std::thread::get_id);
+                finished.push_back(std::move(*it));
+                ConnectionThreads.erase(it);
+            }
+            FinishedConnections.clear();
+        }
+        for (std::thread& thread : finished) thread.join();
+    }
+
+    static std::string AddressName(const char* protocol, const sockaddr_in& address) {
+        char ip[INET_ADDRSTRLEN] = {};
+        inet_ntop(AF_INET, &address.sin_addr, ip, sizeof(ip));
+        return std::string(protocol) + " " + ip + ":" + std::to_string(ntohs(address.sin_port));
+    }
+
+    // Splits bytes into lines (the last one may be incomplete) and parses them
+    static void ParseBytes(Stream& stream, std::string_view bytes, bool endsLine, std::vector<LogEntry>& out) {
+        SplitLines(stream.PartialLine, bytes, [&](std::string&& line) {
+            LogEntry entry;
+            if (stream.Parser.Parse(std::move(line), entry)) {
+                entry.SourceId = static_cast<uint16_t>(stream.SourceId);
+                out.push_back(std::move(entry));
+            }
+            return true;
+        });
+        if (endsLine && !stream.PartialLine.empty()) ParseBytes(stream, "\n", false, out);
+    }
+
+    // Queues parsed entries, waiting while the UI thread is behind
+    void Push(std::vector<LogEntry>& entries) {
+        if (entries.empty()) return;
+        std::unique_lock lock(Mutex);
+        Space.wait(lock, [&] { return !Running || Pending.size() < INGEST_MAX_PENDING_ENTRIES; });
+        std::ranges::move(entries, std::back_inserter(Pending));
+        entries.clear();
+    }
+
+    void ListenLoop() {
+        std::map<std::string, Stream> udpStreams; // By sender address
+        std::vector<char> datagram(65536);
+        std::vector<LogEntry> parsed;
+        while (Running) {
+            PollFd fds[2] = {};
+            fds[0].fd = TcpSocket;
+            fds[0].events = POLLIN;
+            fds[1].fd = UdpSocket;
+            fds[1].events = POLLIN;
+            ReapConnections();
+            if (PollSockets(fds, 2, 200) <= 0) continue;
+
+            if (fds[0].revents & POLLIN) {
+                sockaddr_in peer = {};
+                socklen_t peerSize = sizeof(peer);
+                const SocketHandle client = accept(TcpSocket, reinterpret_cast<sockaddr*>(&peer), &peerSize);
+                const int sourceId = client != INVALID_SOCKET_HANDLE ? RegisterSource(AddressName("tcp", peer)) : -1;
+                if (client != INVALID_SOCKET_HANDLE && sourceId < 0) CloseSocket(client);
+                if (sourceId >= 0) {
+                    std::lock_guard lock(Mutex);
+                    Clients.push_back(client);
+                    ConnectionThreads.emplace_back([this, client, sourceId] { ReceiveLoop(client, sourceId); });
+                }
+            }
+
+            if (fds[1].revents & POLLIN) {
+                sockaddr_in sender = {};
+                socklen_t senderSize = sizeof(sender);
+                const int received = recvfrom(UdpSocket, datagram.data(), static_cast<int>(datagram.size()), 0,
+                                              reinterpret_cast<sockaddr*>(&sender), &senderSize);
+                if (received > 0) {
+                    const std::string name = AddressName("udp", sender);
+                    Stream& stream = udpStreams[name];
+                    if (stream.SourceId == 0) stream.SourceId = RegisterSource(name);
+                    if (stream.SourceId > 0) {
+                        ParseBytes(stream, std::string_view(datagram.data(), received), true, parsed);
+                        Push(parsed);
+                    }
+                }
+            }
+        }
+    }
+
+    void ReceiveLoop(SocketHandle client, int sourceId) {
+        Stream stream;
+        stream.SourceId = sourceId;
+        std::vector<char> buffer(256 * 1024);
+        std::vector<LogEntry> parsed;
+        while (Running) {
+            const int received = recv(client, buffer.data(), static_cast<int>(buffer.size()), 0);
+            if (received <= 0) break;
+            ParseBytes(stream, std::string_view(buffer.data(), received), false, parsed);
+            Push(parsed);
+        }
+        ParseBytes(stream, "", true, parsed); // Connection closed: flush the last line
+        Push(parsed);
+
+        std::lock_guard lock(Mutex);
+        std::erase(Clients, client);
+        CloseSocket(client);
+        FinishedConnections.push_back(std::this_thread::get_id());
+    }
+
+    SocketHandle TcpSocket = INVALID_SOCKET_HANDLE;
+    SocketHandle UdpSocket = INVALID_SOCKET_HANDLE;
+    std::atomic<bool> Running = false;
+    int BoundPort = 0;
+    std::string Error;
+    std::thread ListenThread;
+    std::atomic<int> Refused = 0;
+
+    std::mutex Mutex; // Guards everything below
+    std::condition_variable Space;
+    std::vector<std::thread> ConnectionThreads;
+    std::vector<std::thread::id> FinishedConnections; // Returned, not joined yet
+    std::vector<SocketHandle> Clients;
+    std::vector<LogEntry> Pending;
+    std::vector<std::pair<int, std::string>> NewSources;
+    int NextSourceId = 1;
+};
+
+// =========================================================
+// --- PROGRESSIVE LOADING ---
+// Loads a file without blocking the UI. The first PREVIEW_BYTES are parsed into the log right
+// away (first screen) and the last PREVIEW_BYTES into TailPreview (the end of a crash log),
+// then the rest is read in order on a background thread. A .gz gets its previews from its
+// GzipIndex; the first time it is opened there is no index yet and the background pass builds it. Each block read is cut at line
+// boundaries into slices parsed in parallel on the pool, every slice with its own
+// LogLineParser. Continuation lines at the start of a slice don't know their header yet:
+// they are fixed up when the slices are appended in file order by Update(), which is also
+// when their line numbers become known.
+constexpr size_t PREVIEW_BYTES = 256 << 10;
+constexpr size_t LOAD_SLICE_BYTES = 512 << 10;
+constexpr size_t LOAD_MAX_PENDING_ENTRIES = 1 << 20;
+
+class ProgressiveLoader {
+public:
+    ~ProgressiveLoader() { Cancel(); }
+
+    std::vector<LogEntry> TailPreview; // Last lines of the file, shown until the loading is done
+
+    bool IsActive() const { return Shared != nullptr; }
+    float Progress() const {
+        if (!Shared) return 1.0f;
+        const uint64_t done = Gzip && Gzip->Checkpoints.empty() ? Shared->InputBytes.load() : Shared->ParsedBytes.load();
+        return static_cast<float>(done) / std::max<uint64_t>(1, FileSize);
+    }
+
+    // Resets state and shows the head of path. Small files are loaded completely here.
+    bool Start(LogViewerState& state, const std::string& path) {
+        Cancel();
+        std::error_code error;
+        FileSize = std::filesystem::file_size(path, error);
+        if (error) return false;
+        Gzip.reset();
+        std::string head;
+        std::string tail;
+
+        if (IsGzipFile(path)) {
+            Gzip = std::make_shared<GzipIndex>();
+            if (Gzip->Load(path)) {
+                FileSize = Gzip->TotalOut;
+                Gzip->Inflate(0, std::min<uint64_t>(PREVIEW_BYTES, FileSize), [&](std::string_view data) { head.append(data); return true; });
+                Gzip->Inflate(FileSize - std::min<uint64_t>(PREVIEW_BYTES, FileSize), FileSize, [&](std::string_view data) { tail.append(data); return true; });
+            }
+        } else {
+            if (FileSize <= 4 * PREVIEW_BYTES) {
+                state.LoadFile(path);
+                return !state.FilePath.empty();
+            }
+            std::ifstream file(path, std::ios::binary);
+            if (!file.is_open()) return false;
+            head.resize(PREVIEW_BYTES);
+            file.read(head.data(), static_cast<std::streamsize>(head.size()));
+            tail.resize(PREVIEW_BYTES);
+            file.seekg(static_cast<std::streamoff>(FileSize - PREVIEW_BYTES));
+            file.read(tail.data(), static_cast<std::streamsize>(tail.size()));
+        }
+        head.resize(head.rfind('\n') + 1); // Whole lines only, the background thread continues from there
+        if (FileSize > 4 * PREVIEW_BYTES && !tail.empty()) {
+            LogLineParser tailParser;
+            ParseLines(std::string_view(tail).substr(tail.find('\n') + 1), tailParser, TailPreview);
+        }
+
+        {
+            std::unique_lock dataLock(state.DataMutex);
+            state.Reset();
+            if (Gzip && Gzip->HasSynopses && !state.LoadBlocks(Gzip->Synopses, Gzip->TotalLines)) Gzip->HasSynopses = false;
+            state.FollowOffset = state.AppendBytes(head);
+            state.FilePath = path;
+            state.Compressed = Gzip != nullptr;
+            state.LoadGeneration++;
+            state.ApplyFilters();
+        }
+        Generation = state.LoadGeneration;
+        if (state.Parser.ReachedSummary) {
+            TailPreview.clear();
+            return true;
+        }
+
+        Shared = std::make_shared<SharedState>();
+        Shared->ParsedBytes = head.size();
+        Thread = std::thread([shared = Shared, gzip = Gzip, path, start = static_cast<uint64_t>(head.size())] {
+            ReadLoop(*shared, path, start, gzip.get());
+        });
+        return true;
+    }
+
+    // UI thread: appends the slices parsed since the last call, for at most budgetMs
+    void Update(LogViewerState& state, double budgetMs = 8.0) {
+        if (!Shared) return;
+        if (state.LoadGeneration != Generation) {
+            Cancel(); // Another file or stream was opened meanwhile
+            return;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        bool finished = false;
+        while (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() < budgetMs) {
+            ParsedSlice slice;
+            {
+                std::lock_guard lock(Shared->Mutex);
+                if (Shared->Slices.empty()) {
+                    finished = Shared->Finished;
+                    break;
+                }
+                slice = std::move(Shared->Slices.front());
+                Shared->Slices.pop_front();
+                Shared->PendingEntries -= slice.Entries.size();
+            }
+            Shared->Space.notify_all();
+
+            // The header of the first lines was at the end of the previous slice
+            LogLineParser& parser = state.Parser;
+            for (size_t n = 0; n < slice.LeadingContinuations; ++n) {
+                slice.Entries[n].Level = parser.ContinuationLevel;
+                slice.Entries[n].Category = parser.ContinuationCategory;
+                slice.Entries[n].Timestamp = parser.ContinuationTimestamp;
+            }
+            if (slice.LeadingContinuations < slice.Entries.size()) {
+                parser.ContinuationLevel = slice.Parser.ContinuationLevel;
+                parser.ContinuationCategory = slice.Parser.ContinuationCategory;
+                parser.ContinuationTimestamp = slice.Parser.ContinuationTimestamp;
+            }
+            state.AppendEntries(slice.Entries, false);
+            state.FollowOffset += slice.Consumed;
+            if (slice.Parser.ReachedSummary) {
+                parser.ReachedSummary = true;
+                finished = true;
+                break;
+            }
+        }
+
+        if (finished) {
+            Cancel();
+            if (Gzip && !Gzip->Checkpoints.empty() && !Gzip->HasSynopses) { // First full load of this .gz
+                Gzip->Synopses = state.SaveBlocks();
+                Gzip->HasSynopses = true;
+                Gzip->Save();
+            }
+            state.LoadGeneration++; // Panels refresh what they derived from the partial log
+            Generation = state.LoadGeneration;
+        }
+    }
+
+    void Cancel() {
+        if (!Shared) return;
+        {
+            std::lock_guard lock(Shared->Mutex);
+            Shared->Cancelled = true;
+        }
+        Shared->Space.notify_all();
+        Thread.join();
+        Shared.reset();
+        TailPreview.clear();
+    }
+
+private:
+    struct ParsedSlice {
+        std::vector<LogEntry> Entries;
+        LogLineParser Parser;         // State at the end of the slice
+        size_t LeadingContinuations = 0;
+        size_t Consumed = 0;          // Bytes, stops after the summary line
+    };
+
+    struct SharedState {
+        std::mutex Mutex;
+        std::condition_variable Space;
+        std::deque<ParsedSlice> Slices;
+        size_t PendingEntries = 0;
+        bool Finished = false;
+        std::atomic<bool> Cancelled = false;
+        std::atomic<uint64_t> ParsedBytes = 0;
+        std::atomic<uint64_t> InputBytes = 0; // Compressed bytes, while a GzipIndex is built
+    };
+
+    // Parses the lines of text (the last one may lack its newline) until the summary line.
+    // Returns the number of bytes consumed.
+    static size_t ParseLines(std::string_view text, LogLineParser& parser, std::vector<LogEntry>& out) {
+        size_t lineStart = 0;
+        while (lineStart < text.size() && !parser.ReachedSummary) {
+            size_t lineEnd = text.find('\n', lineStart);
+            if (lineEnd == std::string_view::npos) lineEnd = text.size();
+            LogEntry entry;
+            if (parser.Parse(std::string(text.substr(lineStart, lineEnd - lineStart)), entry))
+                out.push_back(std::move(entry));
+            lineStart = std::min(lineEnd + 1, text.size());
+        }
+        return lineStart;
+    }
+
+    static void ReadLoop(SharedState& shared, const std::string& path, uint64_t start, GzipIndex* gzip) {
+        std::string text; // Data not parsed yet: the unterminated line of the previous block
+
+        // Parses the complete lines of text on the pool and queues them. False once done or cancelled.
+        auto process = [&](std::string_view block, bool last) {
+            text.append(block);
+            const size_t end = last ? text.size() : text.rfind('\n') + 1; // 0 when the block holds no newline
+            if (end == 0) return !last;
+
+            // Slices of about LOAD_SLICE_BYTES, cut after a newline
+            std::vector<size_t> cuts = {0};
+            while (cuts.back() < end) {
+                const size_t target = cuts.back() + LOAD_SLICE_BYTES;
+                const size_t newline = target < end ? text.find('\n', target) : std::string::npos;
+                cuts.push_back(newline == std::string::npos || newline >= end ? end : newline + 1);
+            }
+
+            std::vector<ParsedSlice> slices(cuts.size() - 1);
+            g_ThreadPool.ParallelFor(static_cast<int>(slices.size()), 1, [&](int begin, int endSlice) {
+                for (int n = begin; n < endSlice; ++n) {
+                    ParsedSlice& slice = slices[n];
+                    slice.Consumed = ParseLines(std::string_view(text).substr(cuts[n], cuts[n + 1] - cuts[n]), slice.Parser, slice.Entries);
+                    while (slice.LeadingContinuations < slice.Entries.size() && !slice.Entries[slice.LeadingContinuations].IsHeader)
+                        slice.LeadingContinuations++;
+                }
+            });
+            text.erase(0, end);
+
+            std::unique_lock lock(shared.Mutex);
+            for (ParsedSlice& slice : slices) {
+                shared.Space.wait(lock, [&] { return shared.Cancelled || shared.PendingEntries < LOAD_MAX_PENDING_ENTRIES; });
+                if (shared.Cancelled) return false;
+                shared.ParsedBytes += slice.Consumed;
+                shared.PendingEntries += slice.Entries.size();
+                const bool summary = slice.Parser.ReachedSummary;
+                shared.Slices.push_back(std::move(slice));
+                if (summary) return false;
+            }
+            return !last;
+        };
+
+        bool more = true;
+        if (gzip && !gzip->Checkpoints.empty()) {
+            more = gzip->ReadFrom(start, [&](std::string_view data) { return more = process(data, false); }) && more;
+        } else if (gzip) {
+            // First time this file is opened: this pass builds the index, saved for the next time
+            if (gzip->Build(path, [&](std::string_view data) { return more = process(data, false); }, &shared.InputBytes, &shared.Cancelled))
+                gzip->Save();
+        } else {
+            FileBlockReader reader;
+            std::string_view block;
+            if (reader.Open(path, ReadBackend::Auto, start)) {
+                while (more && reader.Next(block)) more = process(block, false);
+            }
+        }
+        if (more) process({}, true);
+
+        std::lock_guard lock(shared.Mutex);
+        shared.Finished = true;
+    }
+
+    std::shared_ptr<SharedState> Shared;
+    std::shared_ptr<GzipIndex> Gzip; // Set while loading a .gz
+    std::thread Thread;
+    uint64_t FileSize = 0;            // Uncompressed when known, compressed while a GzipIndex is built
+    int Generation = -1;
+};
+
+// =========================================================
+// --- REPEATED MESSAGES ---
+// "Collapse Repeats" shows a run of identical messages (see LogViewerState::Runs) as its first
+// message, the number of repeats and the time span of the run. The count unfolds the run.
+
+std::string RunBadgeLabel(const LogViewerState& state, const RunView& view) {
+    return "x" + std::to_string(state.Runs[view.Run].Repeats);
+}
+
+// "14.22.33:123 - 14.25.01:007" of a folded run, empty when expanded or without timestamps
+std::string RunTimeSpan(const LogViewerState& state, const RunView& view) {
+    if (view.Hidden == 0) return {};
+    const MessageRun& run = state.Runs[view.Run];
+    const int64_t first = state.AllLogs[run.First].Timestamp;
+    int64_t last = 0;
+    for (int line = run.End - 1; line >= run.Second && last == 0; --line) last = state.AllLogs[line].Timestamp;
+    if (first == 0 || last == 0) return {};
+    const std::string from = FormatLogTimestamp(first);
+    const std::string to = FormatLogTimestamp(last);
+    if (from.compare(0, 10, to, 0, 10) != 0) return from + " - " + to; // Not the same day
+    return from.substr(11) + " - " + to.substr(11);
+}
+
+// Width of the badge of a run at the start of its row
+float RunBadgeWidth(const LogViewerState& state, const RunView& view) {
+    const ImGuiStyle& style = ImGui::GetStyle();
+    float width = ImGui::CalcTextSize(RunBadgeLabel(state, view).c_str()).x + style.FramePadding.x * 2.0f + style.ItemSpacing.x;
+    const std::string span = RunTimeSpan(state, view);
+    if (!span.empty()) width += ImGui::CalcTextSize(span.c_str()).x + style.ItemSpacing.x;
+    return width;
+}
+
+// =========================================================
+// --- LONG LINES ---
+// Some lines are hundreds of KB (JSON dumps, serialized asset lists). Laying them out in full
+// every frame is what TextUnformatted does, so lines longer than LONG_LINE_BYTES are drawn
+// from a table of glyph advances taken every GLYPH_CHECKPOINT_BYTES: only the glyphs between
+// the checkpoints around the visible range are emitted. The tables of the GLYPH_CACHE_LINES
+// lines drawn last are kept. Lines longer than LONG_LINE_COLLAPSED_BYTES show their beginning
+// and an expander.
+constexpr size_t LONG_LINE_BYTES = 1024;
+constexpr size_t LONG_LINE_COLLAPSED_BYTES = 16 * 1024;
+constexpr size_t GLYPH_CHECKPOINT_BYTES = 64;
+constexpr size_t GLYPH_CACHE_LINES = 256;
+
+class GlyphAdvanceCache {
+public:
+    struct Line {
+        std::vector<uint32_t> Bytes; // Codepoint boundaries, one per checkpoint, the last one is the end
+        std::vector<float> X;        // Advance from the start of the line to each boundary
+        float Width() const { return X.back(); }
+    };
+
+    // Table of text for the current font. Lines are identified by their buffer, size and ends.
+    const Line& Get(std::string_view text) {
+        ImFont* font = ImGui::GetFont();
+        const float fontSize = ImGui::GetFontSize();
+        if (font != Font || fontSize != FontSize) {
+            Recent.clear();
+            Index.clear();
+            Font = font;
+            FontSize = fontSize;
+        }
+        const uint64_t key = reinterpret_cast<uintptr_t>(text.data()) ^ (text.size() * 0x9E3779B97F4A7C15ull) ^
+                             HashText(text.substr(0, 16)) ^ (HashText(text.substr(text.size() - std::min<size_t>(16, text.size()))) << 1);
+        if (const auto found = Index.find(key); found != Index.end()) {
+            Recent.splice(Recent.begin(), Recent, found->second);
+            return found->second->second;
+        }
+
+        Line line;
+        line.Bytes.push_back(0);
+        line.X.push_back(0.0f);
+        for (size_t begin = 0; begin < text.size(); ) {
+            size_t end = std::min(text.size(), begin + GLYPH_CHECKPOINT_BYTES);
+            while (end < text.size() && (static_cast<unsigned char>(text[end]) & 0xC0) == 0x80) end++; // Not inside a codepoint
+            const float width = font->CalcTextSizeA(fontSize, FLT_MAX, 0.0f, text.data() + begin, text.data() + end).x;
+            line.Bytes.push_back(static_cast<uint32_t>(end));
+            line.X.push_back(line.X.back() + width);
+            begin = end;
+        }
+        Recent.emplace_front(key, std::move(line));
+        Index[key] = Recent.begin();
+        if (Recent.size() > GLYPH_CACHE_LINES) {
+            Index.erase(Recent.back().first);
+            Recent.pop_back();
+        }
+        return Recent.front().second;
+    }
+
+private:
+    ImFont* Font = nullptr;
+    float FontSize = 0.0f;
+    std::list<std::pair<uint64_t, Line>> Recent; // Most recently drawn first
+    std::unordered_map<uint64_t, std::list<std::pair<uint64_t, Line>>::iterator> Index;
 };
 
-struct HighlightWidget {
-    char SearchBuffer[128] = {};
-    ImVec4 Color;
-    int NextOccurrence = 0;
+GlyphAdvanceCache g_GlyphAdvances;
+
+// Width of text on one line, from the glyph table when it is long
+float LogTextWidth(std::string_view text) {
+    if (text.size() <= LONG_LINE_BYTES) return ImGui::CalcTextSize(text.data(), text.data() + text.size()).x;
+    return g_GlyphAdvances.Get(text).Width();
+}
+
+// TextUnformatted for log lines. Without a text wrap position, long lines only emit their visible glyphs.
+void LogLineText(std::string_view text) {
+    if (text.size() <= LONG_LINE_BYTES || ImGui::GetCurrentWindow()->DC.TextWrapPos >= 0.0f) {
+        ImGui::TextUnformatted(text.data(), text.data() + text.size());
+        return;
+    }
+    const GlyphAdvanceCache::Line& line = g_GlyphAdvances.Get(text);
+    const ImVec2 pos = ImGui::GetCursorScreenPos();
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    const float left = drawList->GetClipRectMin().x - pos.x;
+    const float right = drawList->GetClipRectMax().x - pos.x;
+    const size_t first = std::max<ptrdiff_t>(0, std::ranges::upper_bound(line.X, left) - line.X.begin() - 1);
+    const size_t last = std::min<size_t>(std::ranges::lower_bound(line.X, right) - line.X.begin(), line.X.size() - 1);
+    if (first < last) {
+        drawList->AddText(ImGui::GetFont(), ImGui::GetFontSize(), ImVec2(pos.x + line.X[first], pos.y), ImGui::GetColorU32(ImGuiCol_Text),
+                          text.data() + line.Bytes[first], text.data() + line.Bytes[last]);
+    }
+    ImGui::Dummy(ImVec2(line.Width(), ImGui::GetTextLineHeight()));
+}
+
+// Text shown for a line of the log list: its beginning while a very long line is collapsed
+std::string_view ShownLogText(const LogViewerState& state, const LogEntry& log) {
+    std::string_view text = log.FullText;
+    if (text.size() <= LONG_LINE_COLLAPSED_BYTES || state.ExpandedLines.contains(log.LogIndex)) return text;
+    size_t end = LONG_LINE_COLLAPSED_BYTES;
+    while (end > 0 && (static_cast<unsigned char>(text[end]) & 0xC0) == 0x80) end--;
+    return text.substr(0, end);
+}
+
+// Label of the expander of a very long line, empty for other lines
+std::string LongLineLabel(const LogViewerState& state, const LogEntry& log) {
+    if (log.FullText.size() <= LONG_LINE_COLLAPSED_BYTES) return {};
+    if (state.ExpandedLines.contains(log.LogIndex)) return "Collapse";
+    char label[32];
+    snprintf(label, sizeof(label), "+%zu KB", (log.FullText.size() - LONG_LINE_COLLAPSED_BYTES + 1023) / 1024);
+    return label;
+}
+
+// Width of what precedes the text in a row of the log list (run badge, NEW badge, expander)
+float LogRowPrefixWidth(const LogViewerState& state, const LogEntry& log, const RunView* run = nullptr) {
+    const ImGuiStyle& style = ImGui::GetStyle();
+    float width = run ? RunBadgeWidth(state, *run) : 0.0f;
+    if (log.IsHeader && state.NewFingerprints.contains(log.ContentHash)) width += ImGui::CalcTextSize("NEW").x + style.ItemSpacing.x;
+    const std::string label = LongLineLabel(state, log);
+    if (!label.empty()) width += ImGui::CalcTextSize(label.c_str()).x + style.FramePadding.x * 2.0f + style.ItemSpacing.x;
+    return width;
+}
+
+// =========================================================
+// --- TOKEN COLORING ---
+// Asset paths, numbers, GUIDs and quoted names are drawn in their own colors. Lines are lexed
+// TOKEN_CHUNK_LINES at a time, the first time one of them is drawn, and the token spans of the
+// TOKEN_CACHE_CHUNKS chunks drawn last are kept per document, so drawing a row only looks its
+// spans up. Lines longer than LONG_LINE_BYTES, wrapped and highlighted lines keep a single color.
+constexpr int TOKEN_CHUNK_LINES = 64;
+constexpr size_t TOKEN_CACHE_CHUNKS = 64;
+constexpr size_t TOKEN_MAX_QUOTED_BYTES = 256;
+
+enum class TokenKind : uint8_t { Number, Path, Guid, Quoted };
+
+struct TokenSpan {
+    uint16_t Begin; // Lexed lines are at most LONG_LINE_BYTES long
+    uint16_t Length;
+    TokenKind Kind;
 };
 
-// UE Logs usually look like:
-// [2024.01.01-14.22.33:123] LogCook: Error: Missing Texture...
-// We want to extract "LogCook" (Category) and "Error" (Level)
-void ParseLogLine(const std::string& line, LogEntry& entry) {
-    entry.FullText = line;
-    entry.Level = LogLevel::Display;
-    entry.Category = "General";
+inline bool IsTokenDigit(char c) { return c >= '0' && c <= '9'; }
+inline bool IsTokenLetter(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+inline bool IsTokenHex(char c) { return IsTokenDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'); }
+inline bool IsTokenWord(char c) { return IsTokenDigit(c) || IsTokenLetter(c) || c == '_' || static_cast<unsigned char>(c) >= 0x80; }
 
-    // 1. Detect Level (Simple string check is fastest)
-    if (line.find("Error:") != std::string::npos || line.find("Critical:") != std::string::npos) {
-        entry.Level = LogLevel::Error;
-    } else if (line.find("Warning:") != std::string::npos) {
-        entry.Level = LogLevel::Warning;
+// 36 for 8-4-4-4-12 hex digits, 32 for 32 hex digits (FGuid::ToString), 0 otherwise
+static size_t GuidLength(std::string_view text, size_t at) {
+    size_t end = at;
+    while (end < text.size() && IsTokenHex(text[end])) end++;
+    if (end - at == 32) return (end == text.size() || !IsTokenWord(text[end])) ? 32 : 0;
+    if (end - at != 8 || text.size() - at < 36) return 0;
+    for (size_t n = 8; n < 36; ++n) {
+        const bool dash = n == 8 || n == 13 || n == 18 || n == 23;
+        if (dash ? text[at + n] != '-' : !IsTokenHex(text[at + n])) return 0;
     }
+    return (at + 36 == text.size() || !IsTokenWord(text[at + 36])) ? 36 : 0;
+}
 
-    // 2. Detect Category (Text before the first colon, or specifically LogX)
-    // Adjust this logic based on your specific log format needs
-    size_t catStart = line.find("]Log");
-    if (catStart != std::string::npos) {
-        // Found standard UE category format like [123]LogTemp:
-        catStart++; // Skip ']'
-        const size_t catEnd = line.find(':', catStart);
-        if (catEnd != std::string::npos) {
-            entry.Category = line.substr(catStart, catEnd - catStart);
+// Signed decimal, hex or exponent number, with a unit of up to 3 letters (12ms, 64KB). 0 if it
+// is part of an identifier (3DWidget).
+static size_t NumberLength(std::string_view text, size_t at) {
+    const size_t size = text.size();
+    size_t i = at;
+    if (text[i] == '-' || text[i] == '+') i++;
+    if (i >= size || !IsTokenDigit(text[i])) return 0;
+    if (text[i] == '0' && i + 2 < size && (text[i + 1] == 'x' || text[i + 1] == 'X') && IsTokenHex(text[i + 2])) {
+        i += 2;
+        while (i < size && IsTokenHex(text[i])) i++;
+    } else {
+        while (i < size && IsTokenDigit(text[i])) i++;
+        while (i + 1 < size && text[i] == '.' && IsTokenDigit(text[i + 1])) { // Versions too: 5.4.1
+            i++;
+            while (i < size && IsTokenDigit(text[i])) i++;
+        }
+        if (i + 1 < size && (text[i] == 'e' || text[i] == 'E')) {
+            size_t exponent = i + 1;
+            if (exponent + 1 < size && (text[exponent] == '-' || text[exponent] == '+')) exponent++;
+            if (IsTokenDigit(text[exponent])) {
+                i = exponent;
+                while (i < size && IsTokenDigit(text[i])) i++;
+            }
         }
     }
+    size_t unit = i;
+    while (unit < size && IsTokenLetter(text[unit])) unit++;
+    if (unit - i > 3 || (unit < size && IsTokenWord(text[unit]))) return 0;
+    return unit - at;
 }
 
-struct LogViewerState {
-    std::vector<LogEntry> AllLogs;
-    std::vector<int> FilteredIndices; // Indices of logs that match current filters
+// /Game/Maps/Level.Level:PersistentLevel, C:\Build\Saved or ../Content. 0 if text at isn't a path.
+static size_t PathLength(std::string_view text, size_t at) {
+    const size_t size = text.size();
+    const auto slash = [&](size_t i) { return i < size && (text[i] == '/' || text[i] == '\\'); };
+    size_t i = at;
+    if (text[i] == '/' && i + 1 < size && IsTokenWord(text[i + 1])) i++;
+    else if (IsTokenLetter(text[i]) && i + 1 < size && text[i + 1] == ':' && slash(i + 2)) i += 3;
+    else if (text[i] == '.' && ((i + 1 < size && text[i + 1] == '.' && slash(i + 2)) || slash(i + 1))) i += 2;
+    else return 0;
+    while (i < size) {
+        const char c = text[i];
+        if (c == ' ' || c == '\t' || c == '"' || c == '\'' || c == ',' || c == ';' || c == ')' || c == ']' || c == '}' || c == '>') break;
+        i++;
+    }
+    while (i > at + 1 && (text[i - 1] == '.' || text[i - 1] == ':')) i--; // End of a sentence
+    return i - at;
+}
 
-    std::map<LogLevel, int> LevelsCount; // Number of logs of each LogLevel
+// Appends the tokens of text in order. The "[timestamp][frame]" prefix of header lines is skipped.
+void LexLogTokens(std::string_view text, std::vector<TokenSpan>& out) {
+    size_t i = 0;
+    for (int group = 0; group < 2 && i < text.size() && text[i] == '['; ++group) {
+        const size_t close = text.find(']', i);
+        if (close == std::string_view::npos) break;
+        i = close + 1;
+    }
+    const auto push = [&](size_t begin, size_t length, TokenKind kind) {
+        out.push_back({static_cast<uint16_t>(begin), static_cast<uint16_t>(length), kind});
+    };
+    while (i < text.size()) {
+        const char c = text[i];
+        const char previous = i > 0 ? text[i - 1] : ' ';
+        if (IsTokenWord(previous) || previous == '/' || previous == ':') { // Inside a word, URL or path
+            i++;
+            continue;
+        }
+        size_t length = 0;
+        if (c == '"' || c == '\'') {
+            const size_t close = text.find(c, i + 1);
+            if (close != std::string_view::npos && close > i + 1 && close - i < TOKEN_MAX_QUOTED_BYTES) {
+                length = close + 1 - i;
+                push(i, length, PathLength(text.substr(0, close), i + 1) == length - 2 ? TokenKind::Path : TokenKind::Quoted);
+            }
+        } else if ((length = GuidLength(text, i)) != 0) {
+            push(i, length, TokenKind::Guid);
+        } else if ((length = PathLength(text, i)) != 0) {
+            push(i, length, TokenKind::Path);
+        } else if ((length = NumberLength(text, i)) != 0) {
+            push(i, length, TokenKind::Number);
+        }
+        i += std::max<size_t>(length, 1);
+    }
+}
 
-    std::set<int> SelectedIndices; // Stores indices of the *filtered* list
-    int LastClickedIndex = -1;     // Used for Shift+Click ranges
+class TokenCache {
+public:
+    // Token spans of AllLogs[line], lexing its chunk when it isn't cached
+    std::span<const TokenSpan> Get(const LogViewerState& state, int line) {
+        if (state.LoadGeneration != Generation) {
+            Clear();
+            Generation = state.LoadGeneration;
+        }
+        const int64_t logIndex = state.AllLogs[line].LogIndex;
+        const int64_t id = logIndex / TOKEN_CHUNK_LINES;
+        auto found = Index.find(id);
+        if (found != Index.end()) {
+            Recent.splice(Recent.begin(), Recent, found->second);
+        } else {
+            Recent.emplace_front().Id = id;
+            found = Index.emplace(id, Recent.begin()).first;
+            if (Recent.size() > TOKEN_CACHE_CHUNKS) {
+                Index.erase(Recent.back().Id);
+                Recent.pop_back();
+            }
+        }
 
-    // Filters
-    bool ShowErrors = true;
-    bool ShowWarnings = true;
-    bool ShowDisplay = true;
-    char SearchBuffer[128] = "";
-    std::string SelectedCategory = "All";
-    std::set<std::string> UniqueCategories; // To populate the dropdown
+        // Lines are contiguous by LogIndex: lex up to this one, the others may have been dropped or appended since
+        Chunk& chunk = *found->second;
+        const int offset = static_cast<int>(logIndex - id * TOKEN_CHUNK_LINES);
+        const int first = line - offset; // AllLogs index of the chunk's first line, negative when dropped
+        for (; chunk.Lexed <= offset; ++chunk.Lexed) {
+            if (first + chunk.Lexed >= 0) {
+                const std::string& text = state.AllLogs[first + chunk.Lexed].FullText;
+                if (text.size() <= LONG_LINE_BYTES) LexLogTokens(text, chunk.Spans);
+            }
+            chunk.Starts[chunk.Lexed + 1] = static_cast<uint32_t>(chunk.Spans.size());
+        }
+        return std::span<const TokenSpan>(chunk.Spans).subspan(chunk.Starts[offset], chunk.Starts[offset + 1] - chunk.Starts[offset]);
+    }
 
-    bool ShowDuplicates = true;
+    void Clear() {
+        Recent.clear();
+        Index.clear();
+    }
 
-    static void ParseProperties(LogEntry& entry) {
-        // 1. Default values
-        entry.Level = LogLevel::Display;
-        entry.Category = "General";
+private:
+    struct Chunk {
+        int64_t Id = 0;                                     // LogIndex / TOKEN_CHUNK_LINES
+        int Lexed = 0;                                      // Lines lexed from the start of the chunk
+        std::array<uint32_t, TOKEN_CHUNK_LINES + 1> Starts{}; // Spans of line n are [Starts[n], Starts[n + 1])
+        std::vector<TokenSpan> Spans;
+    };
+    int Generation = -1; // LogViewerState::LoadGeneration of the chunks, line numbers restart on a load
+    std::list<Chunk> Recent; // Most recently drawn first
+    std::unordered_map<int64_t, std::list<Chunk>::iterator> Index;
+};
 
-        // 2. Detect Level
-        // We look for "Error:" or "Critical:" anywhere in the text
-        if (entry.FullText.find("Error:") != std::string::npos ||
-            entry.FullText.find("Critical:") != std::string::npos ||
-            entry.FullText.find("Fatal:") != std::string::npos) {
-            entry.Level = LogLevel::Error;
+ImU32 TokenColor(TokenKind kind) {
+    switch (kind) {
+        case TokenKind::Number: return ImGui::GetColorU32(ImVec4(0.6f, 0.9f, 0.6f, 1.0f)); // Green
+        case TokenKind::Path:   return ImGui::GetColorU32(ImVec4(0.5f, 0.8f, 1.0f, 1.0f)); // Blue
+        case TokenKind::Guid:   return ImGui::GetColorU32(ImVec4(0.8f, 0.6f, 1.0f, 1.0f)); // Purple
+        case TokenKind::Quoted: return ImGui::GetColorU32(ImVec4(1.0f, 0.7f, 0.4f, 1.0f)); // Orange
+    }
+    return ImGui::GetColorU32(ImGuiCol_Text);
+}
+
+// LogLineText with the tokens in their colors, drawn in one pass over the line
+void TokenLineText(std::string_view text, std::span<const TokenSpan> tokens) {
+    ImGuiWindow* window = ImGui::GetCurrentWindow();
+    if (tokens.empty() || text.size() > LONG_LINE_BYTES || window->DC.TextWrapPos >= 0.0f) {
+        LogLineText(text);
+        return;
+    }
+    ImFont* font = ImGui::GetFont();
+    const float fontSize = ImGui::GetFontSize();
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    const ImU32 textColor = ImGui::GetColorU32(ImGuiCol_Text);
+    const ImVec2 pos(window->DC.CursorPos.x, window->DC.CursorPos.y + window->DC.CurrLineTextBaseOffset);
+    float x = pos.x;
+    size_t at = 0;
+    const auto draw = [&](size_t end, ImU32 color) {
+        end = std::min(end, text.size());
+        if (end <= at) return;
+        drawList->AddText(font, fontSize, ImVec2(x, pos.y), color, text.data() + at, text.data() + end);
+        x += font->CalcTextSizeA(fontSize, FLT_MAX, 0.0f, text.data() + at, text.data() + end).x;
+        at = end;
+    };
+    for (const TokenSpan& token : tokens) {
+        draw(token.Begin, textColor);
+        draw(token.Begin + token.Length, TokenColor(token.Kind));
+    }
+    draw(text.size(), textColor);
+
+    // Same layout as TextUnformatted
+    const ImVec2 size(x - pos.x, fontSize);
+    ImGui::ItemSize(size, 0.0f);
+    ImGui::ItemAdd(ImRect(pos, ImVec2(pos.x + size.x, pos.y + size.y)), 0);
+}
+
+// =========================================================
+// --- WORD WRAP ---
+// In wrap mode rows have different heights, which ImGuiListClipper can't handle. The height of
+// every filtered row is kept in a Fenwick tree of prefix sums, so the offset of a row and the
+// row at an offset are O(log n) at any row count. Rows are measured per chunk of
+// WRAP_CHUNK_ROWS the first time a chunk is shown; until then they count as the average of a
+// sample. Heights are only thrown away when the wrap width or the font changes, or when the
+// filter is run again; appended lines are added and retention drops shift the tree.
+constexpr int WRAP_CHUNK_ROWS = 256;
+constexpr int WRAP_ESTIMATE_SAMPLES = 256;
+
+// Prefix sums of row heights. Rows dropped from the front stay in the tree before First until
+// they are as many as the rows left, so DropFront costs O(1) per row amortized.
+class RowHeightTree {
+public:
+    size_t size() const { return Tree.empty() ? 0 : Tree.size() - 1 - First; }
+    double Total() const { return Offset(size()); }
+
+    // rows rows of the same height, O(n)
+    void Assign(size_t rows, double height) {
+        First = 0;
+        Tree.assign(rows + 1, 0.0);
+        for (size_t i = 1; i <= rows; ++i) Tree[i] = height * static_cast<double>(i & (~i + 1));
+    }
+
+    void Append(double height) {
+        if (Tree.empty()) Tree.push_back(0.0);
+        const size_t i = Tree.size();
+        Tree.push_back(height + Prefix(i - 1) - Prefix(i - (i & (~i + 1))));
+    }
+
+    void Add(size_t row, double delta) {
+        for (size_t i = First + row + 1; i < Tree.size(); i += i & (~i + 1)) Tree[i] += delta;
+    }
+
+    // Sum of the heights of the rows before row
+    double Offset(size_t row) const { return Prefix(First + row) - Prefix(First); }
+
+    double Height(size_t row) const { return Prefix(First + row + 1) - Prefix(First + row); }
+
+    // Row containing offset y (the last row when y is past the end)
+    size_t RowAt(double y) const {
+        y += Prefix(First);
+        size_t row = 0;
+        size_t step = std::bit_floor(std::max<size_t>(Tree.size(), 2) - 1);
+        for (; step > 0; step >>= 1) {
+            if (row + step < Tree.size() && Tree[row + step] <= y) {
+                row += step;
+                y -= Tree[row];
             }
-        else if (entry.FullText.find("Warning:") != std::string::npos) {
-            entry.Level = LogLevel::Warning;
         }
+        return std::min(row - std::min(row, First), std::max<size_t>(size(), 1) - 1);
+    }
 
-        // 3. Detect Category
-        // Tries to find the pattern "]LogX:" or "> LogX:"
-        size_t catStart = entry.FullText.find("Log");
-        if (catStart != std::string::npos) {
-            // Check if it is preceded by ']' or '> ' or ' '
-            if (catStart > 0 && (entry.FullText[catStart-1] == ']' || entry.FullText[catStart-1] == ' ' || entry.FullText[catStart-1] == ':')) {
-                size_t catEnd = entry.FullText.find(':', catStart);
-                if (catEnd != std::string::npos) {
-                    entry.Category = entry.FullText.substr(catStart, catEnd - catStart);
-                }
-            }
+    void DropFront(size_t rows) {
+        First += std::min(rows, size());
+        if (First > 0 && First >= size()) Compact();
+    }
+
+    void Clear() {
+        std::vector<double>().swap(Tree);
+        First = 0;
+    }
+
+private:
+    std::vector<double> Tree; // 1-based
+    size_t First = 0;         // Dropped rows still in Tree
+
+    double Prefix(size_t count) const {
+        double sum = 0.0;
+        for (size_t i = count; i > 0; i -= i & (~i + 1)) sum += Tree[i];
+        return sum;
+    }
+
+    // Rebuilds the tree without the dropped rows, O(n)
+    void Compact() {
+        for (size_t i = Tree.size() - 1; i > 0; --i) { // Back to plain heights
+            const size_t parent = i + (i & (~i + 1));
+            if (parent < Tree.size()) Tree[parent] -= Tree[i];
+        }
+        Tree.erase(Tree.begin() + 1, Tree.begin() + 1 + First);
+        First = 0;
+        for (size_t i = 1; i < Tree.size(); ++i) {
+            const size_t parent = i + (i & (~i + 1));
+            if (parent < Tree.size()) Tree[parent] += Tree[i];
         }
     }
+};
 
-   void LoadFile(const std::string& path) {
-        AllLogs.clear();
-        UniqueCategories.clear();
-        UniqueCategories.insert("All");
+// Layout of the filtered rows of a document in wrap mode, or of its collapsed rows when collapsed
+// (rows are then LogViewerState::CollapsedRowCount rows). Must be used inside the list child window.
+class WrappedRows {
+public:
+    // Brings the layout up to date with the filtered view and the wrap width, measures the rows
+    // that will be visible and returns the scroll position: the row at the top of the view stays
+    // in place when heights above it change, or scrollToRow is centered when >= 0.
+    double Update(const LogViewerState& state, bool collapsed, float wrapWidth, double scrollY, double viewHeight, int scrollToRow) {
+        const float fontSize = ImGui::GetFontSize();
+        const float spacing = ImGui::GetStyle().ItemSpacing.y;
+        const size_t rows = collapsed ? state.CollapsedRowCount() : state.FilteredIndices.size();
+
+        // Anchor: the row at the top of the view and how far into it the view starts
+        const bool sameRows = state.FilterGeneration == Generation && Heights.size() > 0 && collapsed == Collapsed &&
+                              (!collapsed || state.CollapseGeneration == CollapseGeneration);
+        int64_t anchorRow = -1;
+        double anchorDelta = 0.0;
+        if (sameRows) {
+            anchorRow = static_cast<int64_t>(Heights.RowAt(scrollY));
+            anchorDelta = scrollY - Heights.Offset(anchorRow);
+        }
+
+        const int64_t dropped = state.DroppedFilteredRows - DroppedRows;
+        if (!sameRows || wrapWidth != WrapWidth || fontSize != FontSize || spacing != Spacing || dropped < 0 ||
+            rows < Heights.size() - std::min<size_t>(Heights.size(), dropped)) {
+            Reset(state, collapsed, wrapWidth, fontSize, spacing);
+            anchorDelta = std::min(anchorDelta, RowEstimate);
+        } else if (dropped > 0) {
+            Heights.DropFront(static_cast<size_t>(dropped));
+            Measured.erase(Measured.begin(), Measured.begin() + std::min<size_t>(dropped, Measured.size()));
+            anchorRow -= dropped;
+            if (anchorRow < 0) anchorRow = anchorDelta = 0;
+        }
+        DroppedRows = state.DroppedFilteredRows;
+        while (Heights.size() < rows) { // Appended lines
+            Heights.Append(RowEstimate);
+            Measured.push_back(false);
+        }
+        if (rows == 0) return 0.0;
 
-        std::ifstream file(path);
-        if (!file.is_open()) return;
+        anchorRow = std::min<int64_t>(anchorRow, rows - 1);
+        auto scroll = [&] {
+            double y = scrollY;
+            if (scrollToRow >= 0 && scrollToRow < static_cast<int>(rows))
+                y = Heights.Offset(scrollToRow) + (Heights.Height(scrollToRow) - viewHeight) * 0.5;
+            else if (anchorRow >= 0)
+                y = Heights.Offset(anchorRow) + anchorDelta;
+            return std::clamp(y, 0.0, std::max(0.0, Heights.Total() - viewHeight));
+        };
+        if (scrollToRow >= 0 && scrollToRow < static_cast<int>(rows)) MeasureChunk(state, scrollToRow / WRAP_CHUNK_ROWS);
+        if (anchorRow >= 0) MeasureChunk(state, anchorRow / WRAP_CHUNK_ROWS);
 
-        std::string line;
+        // Measuring changes the heights: loop until every visible chunk is measured
+        for (;;) {
+            const double y = scroll();
+            size_t row = Heights.RowAt(y);
+            while (row < rows && Measured[row] && Heights.Offset(row) < y + viewHeight) row++;
+            if (row >= rows || Heights.Offset(row) >= y + viewHeight) return y;
+            MeasureChunk(state, row / WRAP_CHUNK_ROWS);
+        }
+    }
 
-        // Track state for continuation lines
-        LogLevel currentLevel = LogLevel::Display;
-        std::string currentCategory = "General";
+    // Height of the row as drawn, when it differs from the measure (e.g. its NEW badge appeared)
+    void Correct(size_t row, double height) {
+        const double delta = height - Heights.Height(row);
+        if (std::abs(delta) > 0.01) Heights.Add(row, delta);
+    }
 
-        int CurrentIndex = -1;
-        while (std::getline(file, line)) {
-            // Stop at summary
-            if (line.find("Warning/Error Summary") != std::string::npos) break;
-            if (line.empty()) continue;
+    double Offset(size_t row) const { return Heights.Offset(row); }
+    double Height(size_t row) const { return Heights.Height(row); }
+    size_t RowAt(double y) const { return Heights.RowAt(y); }
+    double Total() const { return Heights.Total(); }
 
-            CurrentIndex++;
+    void Clear() {
+        Heights.Clear();
+        std::deque<bool>().swap(Measured);
+        Generation = UINT64_MAX;
+    }
 
-            LogEntry entry;
-            entry.FullText = line;
-            entry.LogIndex = CurrentIndex;
-
-            // --- 1. IDENTIFY IF HEADER OR CONTINUATION ---
-            if (!line.empty() && line[0] == '[') {
-                entry.IsHeader = true;
-
-                // --- 2. PARSE PROPERTIES ---
-                entry.Level = LogLevel::Display;
-                entry.Category = "General";
-
-                if (line.find("Error:") != std::string::npos ||
-                    line.find("Critical:") != std::string::npos ||
-                    line.find("Fatal:") != std::string::npos) {
-                    entry.Level = LogLevel::Error;
-                }
-                else if (line.find("Warning:") != std::string::npos) {
-                    entry.Level = LogLevel::Warning;
-                }
-
-                // Extract Category
-                size_t catStart = line.find("Log");
-                if (catStart != std::string::npos) {
-                     // Safety check to ensure it's the category tag
-                    if (catStart > 0 && (line[catStart-1] == ']' || line[catStart-1] == ' ' || line[catStart-1] == ':')) {
-                        size_t catEnd = line.find(':', catStart);
-                        if (catEnd != std::string::npos) {
-                            entry.Category = line.substr(catStart, catEnd - catStart);
-                        }
-                    }
-                }
+private:
+    RowHeightTree Heights;
+    std::deque<bool> Measured;        // Dropping rows erases its front
+    uint64_t Generation = UINT64_MAX; // LogViewerState::FilterGeneration of the rows
+    bool Collapsed = false;
+    uint64_t CollapseGeneration = 0;  // LogViewerState::CollapseGeneration of the rows when collapsed
+    int64_t DroppedRows = 0;          // LogViewerState::DroppedFilteredRows already removed
+    float WrapWidth = 0.0f;
+    float FontSize = 0.0f;
+    float Spacing = 0.0f;
+    double RowEstimate = 0.0;         // Height of the rows not measured yet
+
+    double MeasureRow(const LogViewerState& state, size_t row) const {
+        const int filtered = Collapsed ? state.CollapsedToFiltered(static_cast<int>(row)) : static_cast<int>(row);
+        const LogEntry& log = state.AllLogs[state.FilteredIndices[filtered]];
+        const int run = Collapsed ? state.FindRunView(filtered) : -1;
+        const float width = WrapWidth - LogRowPrefixWidth(state, log, run >= 0 ? &state.FilteredRuns[run] : nullptr);
+        const std::string_view shown = ShownLogText(state, log);
+        const float text = ImGui::CalcTextSize(shown.data(), shown.data() + shown.size(), false, std::max(width, 1.0f)).y;
+        return std::max(text, FontSize) + Spacing;
+    }
+
+    void MeasureChunk(const LogViewerState& state, size_t chunk) {
+        const size_t end = std::min(Measured.size(), (chunk + 1) * WRAP_CHUNK_ROWS);
+        for (size_t row = chunk * WRAP_CHUNK_ROWS; row < end; ++row) {
+            if (Measured[row]) continue;
+            Correct(row, MeasureRow(state, row));
+            Measured[row] = true;
+        }
+    }
+
+    void Reset(const LogViewerState& state, bool collapsed, float wrapWidth, float fontSize, float spacing) {
+        Generation = state.FilterGeneration;
+        Collapsed = collapsed;
+        CollapseGeneration = state.CollapseGeneration;
+        DroppedRows = state.DroppedFilteredRows;
+        WrapWidth = wrapWidth;
+        FontSize = fontSize;
+        Spacing = spacing;
+
+        // Unmeasured rows count as the average of rows sampled across the view, so the scrollbar is about right
+        const size_t rows = collapsed ? state.CollapsedRowCount() : state.FilteredIndices.size();
+        const size_t samples = std::min<size_t>(rows, WRAP_ESTIMATE_SAMPLES);
+        RowEstimate = FontSize + Spacing;
+        if (samples > 0) {
+            double sum = 0.0;
+            for (size_t n = 0; n < samples; ++n) sum += MeasureRow(state, n * rows / samples);
+            RowEstimate = sum / samples;
+        }
+        Heights.Assign(rows, RowEstimate);
+        Measured.assign(rows, false);
+    }
+};
+
+// =========================================================
+// --- CATEGORY PICKER ---
+// Projects with many plugins have thousands of Log* categories. The picker lists the matches of
+// its search box with a clipper, so it costs the same to open whatever the category count. The
+// matches are only recomputed when the search changes or new categories appear, and a search
+// that extends the previous one only looks at the previous matches.
+constexpr int CATEGORY_PICKER_ROWS = 16;
+
+// 0 = prefix of the name (or of the name without its "Log"), 1 = substring, 2 = its letters
+// in order (fuzzy), -1 = no match. lowerQuery is lowercase.
+int CategoryMatchRank(std::string_view name, std::string_view lowerQuery) {
+    if (lowerQuery.empty()) return 0;
+    char lower[256];
+    const size_t size = std::min(name.size(), sizeof(lower));
+    for (size_t n = 0; n < size; ++n) lower[n] = AsciiLower(name[n]);
+    const std::string_view text(lower, size);
+    if (text.starts_with(lowerQuery) || (text.starts_with("log") && text.substr(3).starts_with(lowerQuery))) return 0;
+    if (text.find(lowerQuery) != std::string_view::npos) return 1;
+    size_t at = 0;
+    for (const char c : lowerQuery) {
+        at = text.find(c, at);
+        if (at == std::string_view::npos) return -1;
+        at++;
+    }
+    return 2;
+}
+
+struct CategoryPicker {
+    char Query[128] = "";
+    std::string MatchedQuery;    // Lowercase query of Matches
+    size_t MatchedCategories = 0; // CategoryNames.size() when Matches was computed
+    std::vector<int> Matches;    // CategoryIds, best rank first, then by name
 
-                // --- 3. COMPUTE HASH (Unique ID) ---
-                // We want to hash ONLY the message, skipping the timestamp "[2024...][123]"
-                // If we find "Log", start hashing from there. Otherwise hash the whole line.
-                std::string textToHash = (catStart != std::string::npos) ? line.substr(catStart) : line;
-                entry.ContentHash = std::hash<std::string>{}(textToHash);
+    void Update(const LogViewerState& state) {
+        std::string query = Query;
+        std::ranges::transform(query, query.begin(), AsciiLower);
+        const bool sameCategories = MatchedCategories == state.CategoryNames.size();
+        if (sameCategories && query == MatchedQuery) return;
 
-                // Update "Current" state
-                currentLevel = entry.Level;
-                currentCategory = entry.Category;
+        // Every match of a longer query is a match of the shorter one
+        const bool refine = sameCategories && query.starts_with(MatchedQuery);
+        std::vector<std::pair<int, int>> ranked; // Rank, position in SortedCategories
+        if (refine) {
+            std::vector<int> position(state.CategoryNames.size());
+            for (int n = 0; n < (int)state.SortedCategories.size(); ++n) position[state.SortedCategories[n]] = n;
+            for (int id : Matches) {
+                const int rank = CategoryMatchRank(state.CategoryNames[id], query);
+                if (rank >= 0) ranked.emplace_back(rank, position[id]);
             }
-            else {
-                // Continuation line
-                entry.IsHeader = false;
-                entry.Level = currentLevel;
-                entry.Category = currentCategory;
-                entry.FullText = "      " + line; // Visual indent
-                entry.ContentHash = 0; // Hash irrelevant for children, they follow parent
+        } else {
+            for (int n = 0; n < (int)state.SortedCategories.size(); ++n) {
+                const int rank = CategoryMatchRank(state.CategoryNames[state.SortedCategories[n]], query);
+                if (rank >= 0) ranked.emplace_back(rank, n);
             }
+        }
+        std::ranges::sort(ranked);
+        Matches.clear();
+        for (const auto& [rank, position] : ranked) Matches.push_back(state.SortedCategories[position]);
+        MatchedQuery = std::move(query);
+        MatchedCategories = state.CategoryNames.size();
+    }
+};
+
+// Category combo: search box, then the matching categories with their line counts. Clicking a
+// category adds it to or removes it from the selection, Enter keeps only the best match.
+// Returns true when the selection changed.
+bool RenderCategoryPicker(CategoryPicker& picker, LogViewerState& state) {
+    std::string preview = "All";
+    if (state.SelectedCategories.size() == 1) preview = *state.SelectedCategories.begin();
+    else if (state.SelectedCategories.size() > 1) preview = std::to_string(state.SelectedCategories.size()) + " categories";
+    ImGui::SetNextItemWidth(150);
+    if (!ImGui::BeginCombo("Category", preview.c_str(), ImGuiComboFlags_HeightLargest)) return false;
+
+    bool changed = false;
+    if (ImGui::IsWindowAppearing()) ImGui::SetKeyboardFocusHere();
+    ImGui::SetNextItemWidth(-FLT_MIN);
+    const bool enter = ImGui::InputTextWithHint("##CategoryQuery", "Search categories", picker.Query, sizeof(picker.Query),
+                                                ImGuiInputTextFlags_EnterReturnsTrue);
+    picker.Update(state);
+    if (enter && !picker.Matches.empty()) {
+        state.SelectedCategories = {state.CategoryNames[picker.Matches[0]]};
+        changed = true;
+        ImGui::CloseCurrentPopup();
+    }
+
+    if (ImGui::SmallButton("All")) {
+        state.SelectedCategories.clear();
+        changed = true;
+    }
+    ImGui::SameLine();
+    ImGui::BeginDisabled(picker.Query[0] == '\0' || picker.Matches.empty());
+    if (ImGui::SmallButton("Only matches")) {
+        state.SelectedCategories.clear();
+        for (int id : picker.Matches) state.SelectedCategories.insert(state.CategoryNames[id]);
+        changed = true;
+    }
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    ImGui::TextDisabled("%d of %d", (int)picker.Matches.size(), (int)state.CategoryNames.size());
 
-            AllLogs.push_back(entry);
-            LevelsCount[entry.Level]++;
-            UniqueCategories.insert(entry.Category);
+    const int rows = std::clamp((int)picker.Matches.size(), 1, CATEGORY_PICKER_ROWS);
+    ImGui::BeginChild("##Categories", ImVec2(320, rows * ImGui::GetTextLineHeightWithSpacing()));
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(picker.Matches.size()));
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+            const int id = picker.Matches[i];
+            const std::string& name = state.CategoryNames[id];
+            const bool selected = state.SelectedCategories.contains(name);
+            ImGui::PushID(id);
+            if (ImGui::Selectable(name.c_str(), selected, ImGuiSelectableFlags_NoAutoClosePopups)) {
+                if (selected) state.SelectedCategories.erase(name);
+                else state.SelectedCategories.insert(name);
+                changed = true;
+            }
+            char count[16];
+            snprintf(count, sizeof(count), "%d", state.CategoryCounts[id]);
+            ImGui::SameLine();
+            ImGui::SetCursorPosX(ImGui::GetCursorPosX() + ImGui::GetContentRegionAvail().x - ImGui::CalcTextSize(count).x);
+            ImGui::TextDisabled("%s", count);
+            ImGui::PopID();
         }
-        ApplyFilters();
+    }
+    ImGui::EndChild();
+    ImGui::EndCombo();
+    return changed;
+}
+
+// =========================================================
+// --- DOCUMENTS ---
+// Every open log is a LogDocument, shown as a tab of the log dock node. All documents share
+// g_ThreadPool. When the open logs exceed the memory budget, background tabs give back what
+// is cheapest to rebuild first (see MemoryGovernor) and rebuild it when they are viewed again.
+constexpr size_t DEFAULT_MEMORY_BUDGET = size_t(2) << 30;
+
+// What a document gave back to the memory governor, from warm to cold. Each level includes the previous ones.
+enum class Residency { Full, NoFields, NoFilterView, NoLines };
+
+struct LogDocument {
+    int Id = 0;
+    LogViewerState State;
+    ProgressiveLoader Loader;
+    bool Live = false;           // Fed by a stream or network ingestion: the lines can't be read again
+    Residency Resident = Residency::Full;
+    bool Visible = false;        // Drawn this frame (selected tab), never evicted
+    bool FocusRequested = true;  // Brings the tab to the front on the next frame
+    std::chrono::steady_clock::time_point LastActive = std::chrono::steady_clock::now();
+    bool PinToBottom = false;    // Keeps the end of the file in view while it loads, until the user scrolls
+
+    // View state
+    int LastClickedIndex = -1;       // AllLogs index shown in the inspector
+    int ScrollToFilteredIndex = -1;
+    int64_t DroppedRowsSeen = 0;     // LogViewerState::DroppedFilteredRows already compensated in the scroll position
+    std::set<int> ContextSelectedIndices; // Inspector selection, AllLogs indices
+    int ContextLastClickedIndex = -1;
+    ArrowExportJob Export;           // Reads State until it is done
+    CategoryPicker Categories;
+    SimilarityIndex Similar;         // "Find Similar", indexed on the first lookup
+    bool WordWrap = false;
+    WrappedRows Wrap;                // Row heights in wrap mode
+    bool CollapseRuns = false;       // Repeated messages show once (uniq -c)
+    bool TokenColors = true;         // Paths, numbers, GUIDs and quoted names in their own colors
+    TokenCache Tokens;
+    int CenterRow = 0;               // Filtered row in the middle of the view, kept when wrap or collapse is toggled
+    float ContentWidth = 0.0f;       // Width of the list without wrap, only grows for the same log
+    size_t WidestLineBytes = 0;      // LogViewerState::WidestLineBytes ContentWidth was computed for
+
+    std::string Title() const {
+        if (State.FilePath.empty()) return "Empty";
+        if (State.FilePath[0] == '<') return State.FilePath; // <stdin>, <network>
+        return std::filesystem::path(State.FilePath).filename().string();
     }
 
+    std::string WindowName() const { return Title() + "###Log" + std::to_string(Id); } // Stable across renames
 
-    void ApplyFilters() {
-        FilteredIndices.clear();
-        SelectedIndices.clear();
+    bool IsEmpty() const { return State.FilePath.empty() && !Loader.IsActive(); }
+
+    void StartLoad(const std::string& path) {
+        Live = false;
+        Resident = Residency::Full;
         LastClickedIndex = -1;
-        std::string search(SearchBuffer);
-        std::ranges::transform(search, search.begin(), ::tolower);
+        ContextSelectedIndices.clear();
+        ContextLastClickedIndex = -1;
+        PinToBottom = Loader.Start(State, path) && Loader.IsActive();
+    }
 
-        std::set<size_t> seenHashes;
-        bool isSkippingDuplicates = false;
+    // The inspector refers to AllLogs indices, which shift down when old lines are dropped
+    void RebaseInspector(int dropped) {
+        LastClickedIndex = (LastClickedIndex >= dropped) ? LastClickedIndex - dropped : -1;
+        std::set<int> rebased;
+        for (int index : ContextSelectedIndices) {
+            if (index >= dropped) rebased.insert(index - dropped);
+        }
+        ContextSelectedIndices.swap(rebased);
+        ContextLastClickedIndex = -1;
+    }
 
+    // Lines are only given back when reading FilePath again gives the same log
+    bool CanReleaseLines() const {
+        return !Live && !State.Follow && !Loader.IsActive() && !Export.Busy && State.DroppedLines == 0 && !State.FilePath.empty();
+    }
 
+    // Releases the artifacts of one residency level. Returns the approximate bytes freed.
+    size_t Release(Residency level) {
+        if (level == Residency::NoLines) Similar.Clear(); // Before DataMutex: its pass takes it
+        std::unique_lock dataLock(State.DataMutex);
+        const size_t before = State.ApproxMemoryBytes();
+        if (level == Residency::NoFields) {
+            std::lock_guard lock(State.Fields.Mutex);
+            State.Fields.Clear(); // Extracted again by the next field filter that needs a chunk
+        } else {
+            std::vector<int>().swap(State.FilteredIndices);
+            State.FilterGeneration++;
+            Wrap.Clear();
+            Tokens.Clear();
+            State.LiveFilterScan = {};
+            State.IndexFilteredRuns(true); // No rows left
+            State.FilteredRuns.shrink_to_fit();
+            if (level == Residency::NoLines) State.Reset();
+        }
+        Resident = std::max(Resident, level);
+        return before - std::min(before, State.ApproxMemoryBytes());
+    }
 
-        for (int i = 0; i < AllLogs.size(); ++i) {
-            const auto& log = AllLogs[i];
+    // Rebuilds what the memory governor released, when the document is viewed again
+    void Restore() {
+        if (Resident == Residency::NoLines) {
+            const int clicked = LastClickedIndex;
+            StartLoad(std::string(State.FilePath));
+            LastClickedIndex = clicked;
+            PinToBottom = false;
+        } else if (Resident == Residency::NoFilterView) {
+            // Same filters on the same lines: the selection rows are still valid
+            std::set<int> selected = std::move(State.SelectedIndices);
+            const int lastClicked = State.LastClickedIndex;
+            State.ApplyFilters();
+            State.SelectedIndices = std::move(selected);
+            State.LastClickedIndex = lastClicked;
+        }
+        Resident = Residency::Full;
+    }
+};
 
-            // --- DUPLICATE HANDLING ---
-            if (log.IsHeader) {
-                // If this is a header, check if we've seen it before
-                if (!ShowDuplicates && seenHashes.contains(log.ContentHash)) {
-                    isSkippingDuplicates = true; // Start skipping this entire block
-                } else {
-                    isSkippingDuplicates = false; // Valid unique entry, stop skipping
-                    seenHashes.insert(log.ContentHash);
-                }
-            }
+// Keeps the memory of all open logs under BudgetBytes. The active and visible documents are never touched.
+// Background documents release field columns first (re-extracted lazily), then filtered views
+// (one filter pass), then the lines of plain files (reloaded), least recently viewed first.
+// The document served by the query server keeps its lines and view: its endpoints read them.
+class MemoryGovernor {
+public:
+    size_t BudgetBytes = DEFAULT_MEMORY_BUDGET; // 0 = unlimited
 
-            // If we are currently inside a duplicate block (Header + its children), skip
-            if (isSkippingDuplicates) continue;
+    size_t UsedBytes() const { return Used; }
 
+    void Update(std::vector<std::unique_ptr<LogDocument>>& documents, const LogDocument* active, const LogViewerState* served) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now - LastCheck < std::chrono::seconds(1)) return;
+        LastCheck = now;
 
-            // --- STANDARD FILTERS ---
-            if (log.Level == LogLevel::Error && !ShowErrors) continue;
-            if (log.Level == LogLevel::Warning && !ShowWarnings) continue;
-            if (log.Level == LogLevel::Display && !ShowDisplay) continue;
-            if (SelectedCategory != "All" && log.Category != SelectedCategory) continue;
+        Used = 0;
+        std::vector<LogDocument*> background;
+        for (auto& doc : documents) {
+            Used += doc->State.ApproxMemoryBytes();
+            if (!doc->Visible && doc.get() != active) background.push_back(doc.get());
+        }
+        if (BudgetBytes == 0 || Used <= BudgetBytes) return;
 
-            if (!search.empty()) {
-                std::string logLower = log.FullText;
-                std::ranges::transform(logLower, logLower.begin(), ::tolower);
-                if (logLower.find(search) == std::string::npos) continue;
+        std::ranges::sort(background, {}, &LogDocument::LastActive);
+        for (Residency level : {Residency::NoFields, Residency::NoFilterView, Residency::NoLines}) {
+            for (LogDocument* doc : background) {
+                if (Used <= BudgetBytes) return;
+                if (doc->Resident >= level) continue;
+                if (level >= Residency::NoFilterView && &doc->State == served) continue;
+                if (level == Residency::NoLines && !doc->CanReleaseLines()) continue;
+                Used -= std::min(Used, doc->Release(level));
             }
-
-            FilteredIndices.push_back(i);
         }
     }
+
+private:
+    size_t Used = 0;
+    std::chrono::steady_clock::time_point LastCheck;
 };
 
 // Global state instance
-LogViewerState g_LogState;
-int g_LastClickedIndex = -1;
+std::vector<std::unique_ptr<LogDocument>> g_Documents;
+LogDocument* g_ActiveDocument = nullptr; // Shown in the inspector and used by the panels, never null once main started
+int g_NextDocumentId = 1;
+ImGuiID g_DocumentDockId = 0;            // Dock node holding the log tabs
+MemoryGovernor g_Memory;
 std::string g_DroppedFilePath;
 std::vector<HighlightWidget> g_Highlights;
-int g_ScrollToFilteredIndex = -1;
 
-// Context window selection state
-std::set<int> g_ContextSelectedIndices; // Stores AllLogs indices
-int g_ContextLastClickedIndex = -1;
+// Corpus panel state
+CorpusIndex g_Corpus;
+char g_CorpusSearch[256] = "";
+constexpr int CORPUS_MAX_HITS = 10000;
+
+// Alerts state
+AlertEngine g_Alerts;
+char g_AlertRuleBuffer[256] = "";
+std::string g_AlertRuleError;
+int g_AlertsSeen = 0;
+std::chrono::steady_clock::time_point g_LastFollowPoll;
+
+// Makes doc the document of the inspector and panels, rebuilding what the governor released
+void ActivateDocument(LogDocument& doc) {
+    g_ActiveDocument = &doc;
+    doc.LastActive = std::chrono::steady_clock::now();
+    if (doc.Resident != Residency::Full) doc.Restore();
+}
+
+// Document for a new input: the active one while it is still empty, a new tab otherwise
+LogDocument& NewDocument() {
+    if (g_ActiveDocument && g_ActiveDocument->IsEmpty()) return *g_ActiveDocument;
+    g_Documents.push_back(std::make_unique<LogDocument>());
+    LogDocument& doc = *g_Documents.back();
+    doc.Id = g_NextDocumentId++;
+    if (g_ActiveDocument) doc.State.Retention = g_ActiveDocument->State.Retention;
+    ActivateDocument(doc);
+    return doc;
+}
+
+LogDocument* FindDocument(int id) {
+    for (auto& doc : g_Documents) {
+        if (doc->Id == id) return doc.get();
+    }
+    return nullptr;
+}
+
+// Opens path in a new tab, or brings its tab to the front when it is already open.
+// progressive = false loads synchronously (the caller needs the lines right away).
+LogDocument& OpenDocument(const std::string& path, bool progressive = true) {
+    for (auto& doc : g_Documents) {
+        if (!doc->Live && doc->State.FilePath == path) {
+            doc->FocusRequested = true;
+            ActivateDocument(*doc);
+            return *doc;
+        }
+    }
+    LogDocument& doc = NewDocument();
+    doc.FocusRequested = true;
+    if (progressive) {
+        doc.StartLoad(path);
+    } else {
+        doc.Live = false;
+        doc.State.LoadFile(path);
+    }
+    return doc;
+}
+
+// Stream input state
+StreamReader g_Stream;
+LogDocument* g_StreamDocument = nullptr;
+int g_StreamLoadGeneration = -1;
+
+// Network ingestion state
+IngestServer g_Ingest;
+LogDocument* g_IngestDocument = nullptr;
+int g_IngestPort = 8766;
+int g_IngestLoadGeneration = -1;
+
+// Starts listening for log streams from local instances into a fresh log
+bool StartIngest(int port) {
+    if (!g_Ingest.Start(port)) return false;
+    LogDocument& doc = NewDocument();
+    doc.Live = true;
+    LogViewerState& state = doc.State;
+    std::unique_lock dataLock(state.DataMutex);
+    state.Reset();
+    state.FilePath = "<network>";
+    state.LoadGeneration++;
+    state.ApplyFilters();
+    g_IngestDocument = &doc;
+    g_IngestLoadGeneration = state.LoadGeneration;
+    return true;
+}
+
+// Trends panel state
+TrendDatabase g_Trends;
+const LogDocument* g_TrendsDocument = nullptr;
+int g_TrendsLoadGeneration = -1;
+std::string g_TrendsStatus;
+
+bool g_SimilarFocus = false; // Brings the Similar Messages panel to the front
+
+// Rare Messages panel
+std::vector<int> g_RareRanking; // MessageIds of the active document, rarest first
+const LogDocument* g_RareDocument = nullptr;
+int g_RareLoadGeneration = -1;
+int64_t g_RareLines = -1;       // LogViewerState::NextLogIndex of the ranking
+int64_t g_RareDropped = -1;     // LogViewerState::DroppedLines of the ranking
+std::chrono::steady_clock::time_point g_RareRankTime;
+constexpr auto RARE_RERANK_INTERVAL = std::chrono::seconds(1); // Live logs: appended lines are ranked at most this often
+const FingerprintCounts* g_RareBaseline = nullptr;
+std::string g_RareStatus;
+
+// "Load Baseline" counts the other log on its own thread. The counts go to the document that
+// asked for them, if it is still open.
+struct BaselineLoad {
+    std::atomic<bool> Busy = false;
+    int Document = -1; // LogDocument::Id
+    std::string Path;
+    std::shared_ptr<FingerprintCounts> Counts; // Null when the file can't be read
+
+    ~BaselineLoad() { Wait(); }
+
+    void Start(int document, const std::string& path) {
+        if (Busy) return;
+        Wait();
+        Document = document;
+        Path = path;
+        Counts.reset();
+        Busy = true;
+        Job = std::thread([this] {
+            auto counts = std::make_shared<FingerprintCounts>();
+            if (CountLogFileFingerprints(Path, *counts)) Counts = std::move(counts);
+            Busy = false;
+        });
+    }
+
+    // True once, on the UI thread, when a load has finished: Counts and Path are then its result
+    bool Finished() {
+        if (Busy || !Job.joinable()) return false;
+        Job.join();
+        return true;
+    }
+
+    void Wait() {
+        if (Job.joinable()) Job.join();
+    }
+
+private:
+    std::thread Job;
+};
+BaselineLoad g_BaselineLoad;
 
 ImVec4 GenerateHighlightColor() {
     static float hue = 0.15f;
@@ -294,21 +6614,37 @@ std::string CleanLogLine(const std::string& line) {
     return trim(text);
 }
 
-void RenderLogViewer() {
-    ImGui::Begin("Unreal Log Reader");
+// One tab of the log dock node. Returns false when the tab was closed.
+bool RenderLogDocument(LogDocument& doc, ImGuiID dockspace) {
+    LogViewerState& state = doc.State;
+    ImGui::SetNextWindowDockID(g_DocumentDockId ? g_DocumentDockId : dockspace, ImGuiCond_Once);
+    if (doc.FocusRequested) {
+        ImGui::SetNextWindowFocus();
+        doc.FocusRequested = false;
+    }
+    bool open = true;
+    doc.Visible = ImGui::Begin(doc.WindowName().c_str(), &open);
+    if (!doc.Visible) {
+        ImGui::End();
+        return open;
+    }
+    if (ImGui::IsWindowFocused(ImGuiFocusedFlags_RootAndChildWindows) && g_ActiveDocument != &doc) ActivateDocument(doc);
+    if (doc.Resident != Residency::Full) doc.Restore(); // Visible next to the active tab
+    doc.LastActive = std::chrono::steady_clock::now();
+    if (g_ActiveDocument == &doc && ImGui::GetWindowDockID()) g_DocumentDockId = ImGui::GetWindowDockID();
 
     // -- Top Bar: Load & Filters --
     if (ImGui::Button("Load Log File")) {
         // --- 2. Open File Explorer ---
         NFD_Init(); // Initialize NFD
         nfdchar_t *outPath;
-        nfdfilteritem_t filterItem[1] = { { "Unreal Logs", "log,txt" } };
+        nfdfilteritem_t filterItem[1] = { { "Unreal Logs", "log,txt,gz" } };
 
         // Open the dialog
         nfdresult_t result = NFD_OpenDialog(&outPath, filterItem, 1, nullptr);
 
         if (result == NFD_OKAY) {
-            g_LogState.LoadFile(outPath); // Load the selected file
+            OpenDocument(outPath); // Load the selected file in a new tab
             NFD_FreePath(outPath);
         } else if (result == NFD_CANCEL) {
             // User pressed cancel
@@ -318,42 +6654,163 @@ void RenderLogViewer() {
         NFD_Quit();
     }
 
+    if (doc.Loader.IsActive()) {
+        ImGui::SameLine();
+        ImGui::ProgressBar(doc.Loader.Progress(), ImVec2(120, 0));
+    }
+
+    ImGui::SameLine();
+    ImGui::BeginDisabled(state.FilePath.empty() || state.Compressed || doc.Live || doc.Loader.IsActive());
+    ImGui::Checkbox("Follow", &state.Follow);
+    ImGui::SetItemTooltip("Keep reading lines appended to the file (tail -f)");
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    if (ImGui::Button("Retention")) ImGui::OpenPopup("RetentionPopup");
+    ImGui::SetItemTooltip("Drop the oldest lines while following, streaming or listening (0 = unlimited)");
+    if (ImGui::BeginPopup("RetentionPopup")) {
+        RetentionPolicy& retention = state.Retention;
+        int maxLines = static_cast<int>(retention.MaxLines);
+        int maxMegabytes = static_cast<int>(retention.MaxBytes >> 20);
+        int maxMinutes = static_cast<int>(retention.MaxAgeMs / 60000);
+        ImGui::SetNextItemWidth(120);
+        if (ImGui::InputInt("Max lines", &maxLines, 0)) retention.MaxLines = static_cast<size_t>(std::max(0, maxLines));
+        ImGui::SetNextItemWidth(120);
+        if (ImGui::InputInt("Max MB", &maxMegabytes, 0)) retention.MaxBytes = static_cast<size_t>(std::max(0, maxMegabytes)) << 20;
+        ImGui::SetNextItemWidth(120);
+        if (ImGui::InputInt("Max age (min)", &maxMinutes, 0)) retention.MaxAgeMs = static_cast<int64_t>(std::max(0, maxMinutes)) * 60000;
+        ImGui::TextDisabled("%d lines, %.1f MB retained, %lld dropped", (int)state.AllLogs.size(),
+                            state.RetainedBytes / (1024.0 * 1024.0), (long long)state.DroppedLines);
+        ImGui::Separator();
+        int budgetMegabytes = static_cast<int>(g_Memory.BudgetBytes >> 20);
+        ImGui::SetNextItemWidth(120);
+        if (ImGui::InputInt("Memory budget (MB)", &budgetMegabytes, 0)) g_Memory.BudgetBytes = static_cast<size_t>(std::max(0, budgetMegabytes)) << 20;
+        ImGui::SetItemTooltip("All open logs together. Background tabs release memory first and rebuild it when viewed again.");
+        ImGui::TextDisabled("%.1f MB used by %d open logs", g_Memory.UsedBytes() / (1024.0 * 1024.0), (int)g_Documents.size());
+        ImGui::EndPopup();
+    }
+    ImGui::SameLine();
+    ImGui::BeginDisabled(state.FilteredIndices.empty() || doc.Loader.IsActive() || doc.Export.Busy);
+    if (ImGui::Button("Export Arrow")) {
+        NFD_Init();
+        nfdchar_t *outPath;
+        nfdfilteritem_t filterItem[1] = { { "Arrow IPC / Feather", "arrow,feather" } };
+        if (NFD_SaveDialog(&outPath, filterItem, 1, nullptr, "export.arrow") == NFD_OKAY) {
+            doc.Export.Start(state, outPath);
+            NFD_FreePath(outPath);
+        }
+        NFD_Quit();
+    }
+    ImGui::EndDisabled();
+    ImGui::SetItemTooltip("Save the filtered lines as an Arrow IPC file (pandas.read_feather, polars.read_ipc)");
+    if (doc.Export.Busy) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("Exporting %d%%", static_cast<int>(100 * doc.Export.Progress.Done / std::max<int64_t>(1, doc.Export.Total)));
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Cancel##Export")) doc.Export.Progress.Cancel = true;
+    } else if (const std::string status = doc.Export.GetStatus(); !status.empty()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s", status.c_str());
+    }
+    if (g_Stream.IsActive() && g_StreamDocument == &doc) {
+        ImGui::SameLine();
+        ImGui::TextDisabled(g_Stream.IsFinished() ? "Stream ended" : "Streaming %s...", state.FilePath.c_str());
+    }
+    ImGui::SameLine();
+    bool listening = g_Ingest.IsRunning();
+    if (ImGui::Checkbox("Listen", &listening)) {
+        if (listening) StartIngest(g_IngestPort);
+        else g_Ingest.Stop();
+    }
+    ImGui::SetItemTooltip("Receive log lines from local instances over TCP/UDP on 127.0.0.1");
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(80);
+    ImGui::BeginDisabled(listening);
+    ImGui::InputInt("##IngestPort", &g_IngestPort, 0);
+    ImGui::EndDisabled();
+    if (!g_Ingest.LastError().empty()) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", g_Ingest.LastError().c_str());
+    } else if (g_Ingest.RefusedSenders() > 0) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%d senders refused, all %d source ids are taken", g_Ingest.RefusedSenders(), INGEST_MAX_SOURCE_ID);
+    }
+
     ImGui::Separator();
 
     // Checkboxes
     bool filterChanged = false;
-    filterChanged |= ImGui::Checkbox("Errors", &g_LogState.ShowErrors); ImGui::SameLine();
-    filterChanged |= ImGui::Checkbox("Warnings", &g_LogState.ShowWarnings); ImGui::SameLine();
-    filterChanged |= ImGui::Checkbox("Display", &g_LogState.ShowDisplay); ImGui::SameLine();
-    filterChanged |= ImGui::Checkbox("Show Duplicates", &g_LogState.ShowDuplicates);
+    filterChanged |= ImGui::Checkbox("Errors", &state.ShowErrors); ImGui::SameLine();
+    filterChanged |= ImGui::Checkbox("Warnings", &state.ShowWarnings); ImGui::SameLine();
+    filterChanged |= ImGui::Checkbox("Display", &state.ShowDisplay); ImGui::SameLine();
+    filterChanged |= ImGui::Checkbox("Show Duplicates", &state.ShowDuplicates); ImGui::SameLine();
+    if (ImGui::Checkbox("Wrap", &doc.WordWrap)) {
+        doc.ScrollToFilteredIndex = doc.CenterRow;
+        if (!doc.WordWrap) doc.Wrap.Clear();
+    }
+    ImGui::SetItemTooltip("Wrap long lines at the window width");
+    ImGui::SameLine();
+    if (ImGui::Checkbox("Collapse Repeats", &doc.CollapseRuns)) doc.ScrollToFilteredIndex = doc.CenterRow;
+    ImGui::SetItemTooltip("Show consecutive repeats of a message once, with their count and time span");
+    ImGui::SameLine();
+    ImGui::Checkbox("Token Colors", &doc.TokenColors);
+    ImGui::SetItemTooltip("Paths, numbers, GUIDs and quoted names in their own colors");
+    ImGui::SameLine();
+    filterChanged |= ImGui::Checkbox("Rare", &state.RareOnly);
+    ImGui::SetItemTooltip("Only messages seen at most this many times (in the baseline of the Rare Messages panel when one is loaded)");
+    if (state.RareOnly) {
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(90);
+        if (ImGui::InputInt("##RareMax", &state.RareMaxCount)) {
+            state.RareMaxCount = std::max(0, state.RareMaxCount);
+            filterChanged = true;
+        }
+    }
 
-    ImGui::Text("Warnings: %d", g_LogState.LevelsCount[LogLevel::Warning]); ImGui::SameLine();
-    ImGui::Text("Errors: %d", g_LogState.LevelsCount[LogLevel::Error]);
+    ImGui::Text("Warnings: %d", state.LevelsCount[LogLevel::Warning]); ImGui::SameLine();
+    ImGui::Text("Errors: %d", state.LevelsCount[LogLevel::Error]);
 
-    ImGui::SetNextItemWidth(150);
-    if (ImGui::BeginCombo("Category", g_LogState.SelectedCategory.c_str())) {
-        for (const auto& cat : g_LogState.UniqueCategories) {
-            bool isSelected = (g_LogState.SelectedCategory == cat);
-            if (ImGui::Selectable(cat.c_str(), isSelected)) {
-                g_LogState.SelectedCategory = cat;
+    filterChanged |= RenderCategoryPicker(doc.Categories, state);
+
+    if (state.SourceNames.size() > 1) {
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(180);
+        const int selected = state.SelectedSource;
+        const char* preview = selected < 0 ? "All sources" : state.SourceNames[selected].c_str();
+        if (ImGui::BeginCombo("Source", preview)) {
+            if (ImGui::Selectable("All sources", selected < 0)) {
+                state.SelectedSource = -1;
                 filterChanged = true;
             }
-            if (isSelected) ImGui::SetItemDefaultFocus();
+            for (int id = 1; id < (int)state.SourceNames.size(); ++id) {
+                if (ImGui::Selectable(state.SourceNames[id].c_str(), selected == id)) {
+                    state.SelectedSource = id;
+                    filterChanged = true;
+                }
+            }
+            ImGui::EndCombo();
         }
-        ImGui::EndCombo();
     }
 
     ImGui::SameLine();
     ImGui::Text("Search:"); ImGui::SameLine();
-    if (ImGui::InputText("##Search", g_LogState.SearchBuffer, sizeof(g_LogState.SearchBuffer))) {
+    if (ImGui::InputText("##Search", state.SearchBuffer, sizeof(state.SearchBuffer))) {
+        filterChanged = true;
+    }
+    ImGui::SameLine();
+    ImGui::Text("Fields:"); ImGui::SameLine();
+    ImGui::SetNextItemWidth(220);
+    if (!state.FieldFilterValid) ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.4f, 0.4f, 1.0f));
+    if (ImGui::InputTextWithHint("##Fields", "Player=123 LatencyMs>200", state.FieldFilterBuffer, sizeof(state.FieldFilterBuffer))) {
         filterChanged = true;
     }
+    if (!state.FieldFilterValid) ImGui::PopStyleColor();
+    ImGui::SetItemTooltip("Key=Value filters on structured fields. Operators: = != < <= > >=");
     ImGui::SameLine();
     if (ImGui::Button("+"))
         g_Highlights.push_back({"", GenerateHighlightColor(), 0});
 
     if (filterChanged)
-        g_LogState.ApplyFilters();
+        state.ApplyFilters();
 
     for (int h = 0; h < (int)g_Highlights.size(); ) {
         auto& hw = g_Highlights[h];
@@ -363,18 +6820,24 @@ void RenderLogViewer() {
         ImGui::InputText("##hl", hw.SearchBuffer, sizeof(hw.SearchBuffer));
         ImGui::SameLine();
         if (ImGui::Button("Next")) {
-            std::string term = hw.SearchBuffer;
-            std::ranges::transform(term, term.begin(), ::tolower);
-            if (!term.empty() && !g_LogState.FilteredIndices.empty()) {
-                int total = (int)g_LogState.FilteredIndices.size();
+            const CaseInsensitiveSearch term(hw.SearchBuffer);
+            if (!term.Empty() && !state.FilteredIndices.empty()) {
+                int total = (int)state.FilteredIndices.size();
                 int start = (hw.NextOccurrence + 1) % total;
+                BlockProbe probe;
+                probe.SetSearch(term.Folded());
                 for (int n = 0; n < total; n++) {
                     int idx = (start + n) % total;
-                    std::string text = g_LogState.AllLogs[g_LogState.FilteredIndices[idx]].FullText;
-                    std::ranges::transform(text, text.begin(), ::tolower);
-                    if (text.find(term) != std::string::npos) {
+                    // Rows in a block that can't contain the term are passed over at once
+                    if (const BlockSynopsis* block = state.FindBlock(state.FilteredIndices[idx]); block && !block->MayMatch(probe)) {
+                        const auto next = std::lower_bound(state.FilteredIndices.begin() + idx, state.FilteredIndices.end(), block->FirstLine + block->LineCount);
+                        n += static_cast<int>(next - state.FilteredIndices.begin()) - idx - 1;
+                        continue;
+                    }
+                    const LogEntry& candidate = state.AllLogs[state.FilteredIndices[idx]];
+                    if (term.Matches(candidate.FullText, candidate.Ascii)) {
                         hw.NextOccurrence = idx;
-                        g_ScrollToFilteredIndex = idx;
+                        doc.ScrollToFilteredIndex = idx;
                         break;
                     }
                 }
@@ -390,14 +6853,14 @@ void RenderLogViewer() {
 
     ImGui::Separator();
 
-    if (ImGui::GetIO().KeyCtrl && ImGui::IsKeyPressed(ImGuiKey_C)) {
-        if (!g_LogState.SelectedIndices.empty()) {
+    if (g_ActiveDocument == &doc && ImGui::GetIO().KeyCtrl && ImGui::IsKeyPressed(ImGuiKey_C)) {
+        if (!state.SelectedIndices.empty()) {
             std::string clipboardText = "```\n";
-            for (int idx : g_LogState.SelectedIndices) {
+            for (int idx : state.SelectedIndices) {
                 // Safety check
-                if (idx >= 0 && idx < g_LogState.FilteredIndices.size()) {
-                    int originalIndex = g_LogState.FilteredIndices[idx];
-                    clipboardText += CleanLogLine(g_LogState.AllLogs[originalIndex].FullText + "\n");
+                if (idx >= 0 && idx < state.FilteredIndices.size()) {
+                    int originalIndex = state.FilteredIndices[idx];
+                    clipboardText += CleanLogLine(state.AllLogs[originalIndex].FullText + "\n");
                 }
             }
             clipboardText += "```"; // End with backticks
@@ -406,189 +6869,986 @@ void RenderLogViewer() {
     }
 
     std::string newCategoryFilter;
+    int toggledRun = -1; // Applied after the rows are drawn, the rows shown depend on it
 
-    ImGui::BeginChild("LogScroll", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
-    ImGuiListClipper clipper;
-    clipper.Begin(g_LogState.FilteredIndices.size());
+    // Draws filtered row i. textHeight is the height of its wrapped text (0 without wrap), returns the height drawn.
+    auto drawRow = [&](int i, float textHeight) {
+        int originalIndex = state.FilteredIndices[i];
+        const LogEntry& log = state.AllLogs[originalIndex];
 
-    if (g_ScrollToFilteredIndex >= 0 && g_ScrollToFilteredIndex < (int)g_LogState.FilteredIndices.size())
-        clipper.IncludeItemsByIndex(g_ScrollToFilteredIndex, g_ScrollToFilteredIndex + 1);
+        // --- COLOR LOGIC ---
+        ImVec4 color = ImVec4(0.9f, 0.9f, 0.9f, 1.0f); // Default Light Grey
+        if (log.Level == LogLevel::Error) color = ImVec4(1.0f, 0.4f, 0.4f, 1.0f); // Red
+        else if (log.Level == LogLevel::Warning) color = ImVec4(1.0f, 0.9f, 0.4f, 1.0f); // Yellow
+        else if (log.Category == "LogCook") color = ImVec4(0.6f, 0.8f, 1.0f, 1.0f); // Light Blue
 
-    while (clipper.Step()) {
-        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
-            int originalIndex = g_LogState.FilteredIndices[i];
-            const LogEntry& log = g_LogState.AllLogs[originalIndex];
+        bool highlighted = false;
+        for (const auto& hw : g_Highlights) {
+            if (hw.SearchBuffer[0] == '\0') continue;
+            if (CaseInsensitiveSearch(hw.SearchBuffer).Matches(log.FullText, log.Ascii)) {
+                color = hw.Color;
+                highlighted = true;
+            }
+        }
+
+        // --- SELECTION LOGIC ---
+        bool isSelected = state.SelectedIndices.contains(i);
+
+        ImGui::PushStyleColor(ImGuiCol_Text, color);
+
+        // Generate a unique ID for Selectable using "##" + index
+        std::string label = "##Line" + std::to_string(i);
+
+        // Draw the selectable line (spans full width, and all the wrapped lines). The run badge and
+        // the expander of very long lines are drawn over it.
+        const std::string expander = LongLineLabel(state, log);
+        const int run = doc.CollapseRuns ? state.FindRunView(i) : -1;
+        const bool overlap = !expander.empty() || run >= 0;
+        const ImGuiSelectableFlags flags = ImGuiSelectableFlags_SpanAllColumns | (overlap ? ImGuiSelectableFlags_AllowOverlap : 0);
+        if (ImGui::Selectable(label.c_str(), isSelected, flags, ImVec2(0, textHeight))) {
+            // 1. Handle CTRL+Click (Toggle)
+            if (ImGui::GetIO().KeyCtrl) {
+                if (isSelected) state.SelectedIndices.erase(i);
+                else state.SelectedIndices.insert(i);
+                state.LastClickedIndex = i;
+            }
+            // 2. Handle SHIFT+Click (Range)
+            else if (ImGui::GetIO().KeyShift && state.LastClickedIndex != -1) {
+                int start = std::min(state.LastClickedIndex, i);
+                int end = std::max(state.LastClickedIndex, i);
+
+                // Clear previous selection if you want standard OS behavior,
+                // or keep it if you want additive. Standard is usually to clear:
+                state.SelectedIndices.clear();
+
+                for (int n = start; n <= end; n++) {
+                    state.SelectedIndices.insert(n);
+                }
+            }
+            // 3. Handle Normal Click (Single select)
+            else {
+                state.SelectedIndices.clear();
+                state.SelectedIndices.insert(i);
+                state.LastClickedIndex = i;
+                doc.LastClickedIndex = originalIndex;
+                doc.ContextSelectedIndices.clear();
+                doc.ContextLastClickedIndex = -1;
+            }
+        }
+
+        // Draw the actual text on top of the Selectable
+        ImGui::SameLine();
+        if (run >= 0) {
+            const RunView& view = state.FilteredRuns[run];
+            ImGui::PushID(i);
+            if (ImGui::SmallButton(RunBadgeLabel(state, view).c_str())) toggledRun = run;
+            ImGui::PopID();
+            ImGui::SetItemTooltip(view.Hidden ? "Show the %d repeats" : "Collapse the %d repeats", state.Runs[view.Run].Repeats);
+            ImGui::SameLine();
+            if (const std::string span = RunTimeSpan(state, view); !span.empty()) {
+                ImGui::TextDisabled("%s", span.c_str());
+                ImGui::SameLine();
+            }
+        }
+        if (log.IsHeader && state.NewFingerprints.contains(log.ContentHash)) {
+            ImGui::TextColored(ImVec4(1.0f, 0.5f, 1.0f, 1.0f), "NEW");
+            ImGui::SameLine();
+        }
+        if (!expander.empty()) {
+            ImGui::PushID(i);
+            if (ImGui::SmallButton(expander.c_str())) {
+                if (!state.ExpandedLines.erase(log.LogIndex)) state.ExpandedLines.insert(log.LogIndex);
+                else doc.ContentWidth = 0.0f; // Collapsed: back to the widest line
+            }
+            ImGui::PopID();
+            ImGui::SetItemTooltip("%.1f KB line", log.FullText.size() / 1024.0);
+            ImGui::SameLine();
+        }
+        if (doc.TokenColors && !highlighted && !doc.WordWrap) TokenLineText(ShownLogText(state, log), doc.Tokens.Get(state, originalIndex));
+        else LogLineText(ShownLogText(state, log));
+        textHeight = ImGui::GetItemRectSize().y;
+        if (!doc.WordWrap) doc.ContentWidth = std::max(doc.ContentWidth, ImGui::GetItemRectMax().x - ImGui::GetWindowPos().x + ImGui::GetScrollX());
+
+        ImGui::PopStyleColor();
+
+        // Right-Click Context Menu
+        std::string contextMenuId = "##ctx" + std::to_string(i);
+        if (ImGui::BeginPopupContextItem(contextMenuId.c_str())) {
+            if (ImGui::Selectable("Copy")) {
+                const std::string text = "```\n" + CleanLogLine(log.FullText) + "\n```";
+                ImGui::SetClipboardText(text.c_str());
+            }
+            if (ImGui::Selectable("Filter to this Category")) {
+                newCategoryFilter = log.Category;
+            }
+            if (log.IsHeader && !g_Corpus.Root.empty() && !g_Corpus.Busy && ImGui::Selectable("Find in Corpus")) {
+                g_Corpus.FindFingerprint(log.ContentHash, CORPUS_MAX_HITS);
+            }
+            if (log.MessageId >= 0 && ImGui::Selectable("Find Similar")) {
+                doc.Similar.Query = log.MessageId;
+                doc.Similar.QueryGeneration = state.LoadGeneration;
+                doc.Similar.QueryPending = true;
+                doc.Similar.Results.clear();
+                if (!doc.Similar.IsCurrent(state)) doc.Similar.Update(state);
+                g_SimilarFocus = true;
+            }
+            ImGui::EndPopup();
+        }
+        return textHeight;
+    };
+
+    if (!doc.WordWrap) {
+        // The horizontal scrollbar spans the longest line and only grows, so it doesn't jump as rows scroll in
+        if (state.WidestLineBytes < doc.WidestLineBytes) doc.ContentWidth = 0.0f; // Another log
+        doc.WidestLineBytes = state.WidestLineBytes;
+        const int64_t widest = state.WidestLine - state.DroppedLines;
+        if (widest >= 0 && widest < (int64_t)state.AllLogs.size()) {
+            const LogEntry& log = state.AllLogs[widest];
+            const float width = ImGui::GetStyle().ItemSpacing.x + LogRowPrefixWidth(state, log) + LogTextWidth(ShownLogText(state, log));
+            doc.ContentWidth = std::max(doc.ContentWidth, width);
+        }
+        ImGui::SetNextWindowContentSize(ImVec2(doc.ContentWidth, 0.0f));
+    }
+    ImGui::BeginChild("LogScroll", ImVec2(0, 0), false, doc.WordWrap ? ImGuiWindowFlags_None : ImGuiWindowFlags_HorizontalScrollbar);
+    // Rows dropped by retention: scroll up by as much so the visible lines stay in place (the wrap layout does it itself)
+    if (doc.DroppedRowsSeen != state.DroppedFilteredRows) {
+        const int64_t removedRows = state.DroppedFilteredRows - doc.DroppedRowsSeen;
+        if (removedRows > 0) {
+            if (!doc.WordWrap) ImGui::SetScrollY(std::max(0.0f, ImGui::GetScrollY() - removedRows * ImGui::GetTextLineHeightWithSpacing()));
+            if (doc.ScrollToFilteredIndex >= 0) doc.ScrollToFilteredIndex = std::max<int64_t>(0, doc.ScrollToFilteredIndex - removedRows);
+        }
+        doc.DroppedRowsSeen = state.DroppedFilteredRows;
+    }
+    // Rows of the list: the filtered rows, or the collapsed rows mapped to them
+    const bool collapse = doc.CollapseRuns;
+    const int rowCount = collapse ? state.CollapsedRowCount() : static_cast<int>(state.FilteredIndices.size());
+    auto filteredRow = [&](int row) { return collapse ? state.CollapsedToFiltered(row) : row; };
+    int scrollToRow = -1;
+    if (doc.ScrollToFilteredIndex >= 0 && doc.ScrollToFilteredIndex < (int)state.FilteredIndices.size())
+        scrollToRow = collapse ? state.FilteredToCollapsed(doc.ScrollToFilteredIndex) : doc.ScrollToFilteredIndex;
+    if (scrollToRow >= 0) doc.ScrollToFilteredIndex = -1; // Centered this frame
+
+    if (!doc.WordWrap) {
+        ImGuiListClipper clipper;
+        clipper.Begin(rowCount);
+
+        if (scrollToRow >= 0)
+            clipper.IncludeItemsByIndex(scrollToRow, scrollToRow + 1);
+
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                if (row == scrollToRow) ImGui::SetScrollHereY(0.5f);
+                drawRow(filteredRow(row), 0.0f);
+            }
+        }
+        const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+        const int centerRow = static_cast<int>((ImGui::GetScrollY() + ImGui::GetWindowHeight() * 0.5f) / rowHeight);
+        doc.CenterRow = filteredRow(std::clamp(centerRow, 0, std::max(rowCount - 1, 0)));
+    } else if (rowCount > 0) {
+        // Only the rows in view are laid out, at their offset in the row height tree. When the
+        // layout moves the scroll position, this frame is drawn shifted by as much, as ImGui
+        // applies the new position on the next frame. Rows are placed in screen space from the
+        // view origin in double: local float positions are off by pixels past 2^24 (~1M rows).
+        const float top = ImGui::GetCursorPosY();
+        const float left = ImGui::GetCursorPosX();
+        const float rowsX = ImGui::GetCursorScreenPos().x;
+        ImGuiWindow* window = ImGui::GetCurrentWindow();
+        const double origin = static_cast<double>(window->DC.CursorStartPos.y) + window->DC.CursorStartPosLossyness.y +
+                              window->Scroll.y + (window->DC.CursorPos.y - window->DC.CursorStartPos.y); // Offset 0 at scroll 0
+        const float wrapRight = left + ImGui::GetContentRegionAvail().x;
+        const float textX = left + ImGui::GetStyle().ItemSpacing.x; // After the Selectable, on the same line
+        const float scrollY = ImGui::GetScrollY();
+        const float viewHeight = ImGui::GetWindowHeight();
+        const double scroll = doc.Wrap.Update(state, collapse, wrapRight - textX, scrollY, viewHeight, scrollToRow);
+        if (std::abs(scroll - scrollY) > 0.5) ImGui::SetScrollY(static_cast<float>(scroll));
+
+        const float spacing = ImGui::GetStyle().ItemSpacing.y;
+        ImGui::PushTextWrapPos(wrapRight);
+        for (int row = static_cast<int>(doc.Wrap.RowAt(scroll)); row < rowCount; ++row) {
+            const double offset = doc.Wrap.Offset(row);
+            if (offset >= scroll + viewHeight) break;
+            ImGui::SetCursorScreenPos(ImVec2(rowsX, static_cast<float>(origin + (offset - scroll))));
+            const float height = drawRow(filteredRow(row), static_cast<float>(doc.Wrap.Height(row) - spacing));
+            doc.Wrap.Correct(row, height + spacing);
+        }
+        ImGui::PopTextWrapPos();
+        ImGui::SetCursorPosY(static_cast<float>(top + doc.Wrap.Total() - spacing));
+        ImGui::Dummy(ImVec2(0, 0)); // Extends the content to the last row
+        doc.CenterRow = filteredRow(static_cast<int>(doc.Wrap.RowAt(scroll + viewHeight * 0.5)));
+    }
+    if (toggledRun >= 0) state.ToggleRunExpanded(toggledRun);
+
+    // While loading, the end of the file is shown under the lines loaded so far
+    if (doc.Loader.IsActive()) {
+        ImGui::Separator();
+        ImGui::TextDisabled("... loading %.0f%%, end of the file (unfiltered):", doc.Loader.Progress() * 100.0f);
+        ImGuiListClipper tailClipper;
+        tailClipper.Begin(static_cast<int>(doc.Loader.TailPreview.size()));
+        while (tailClipper.Step()) {
+            for (int i = tailClipper.DisplayStart; i < tailClipper.DisplayEnd; i++) {
+                const LogEntry& log = doc.Loader.TailPreview[i];
+                ImVec4 color = ImVec4(0.9f, 0.9f, 0.9f, 1.0f);
+                if (log.Level == LogLevel::Error) color = ImVec4(1.0f, 0.4f, 0.4f, 1.0f);
+                else if (log.Level == LogLevel::Warning) color = ImVec4(1.0f, 0.9f, 0.4f, 1.0f);
+                ImGui::PushStyleColor(ImGuiCol_Text, color);
+                LogLineText(ShownLogText(state, log));
+                ImGui::PopStyleColor();
+            }
+        }
+    }
+    if (doc.PinToBottom) {
+        if (ImGui::IsWindowHovered() && (ImGui::GetIO().MouseWheel != 0.0f || ImGui::IsMouseDown(ImGuiMouseButton_Left)))
+            doc.PinToBottom = false;
+        else
+            ImGui::SetScrollHereY(1.0f);
+        if (!doc.Loader.IsActive()) doc.PinToBottom = false; // Loaded: this was the jump to the real end
+    }
+    ImGui::EndChild();
+
+    if (!newCategoryFilter.empty()) {
+        state.SelectedCategories = {newCategoryFilter};
+        state.ApplyFilters();
+    }
+
+    ImGui::End();
+    return open;
+}
+
+// The Context Window, for the active document
+void RenderInspector() {
+    LogDocument& doc = *g_ActiveDocument;
+    const LogViewerState& state = doc.State;
+    ImGui::Begin("Log Context (Inspector)");
+
+    ImGui::BeginChild("LogContext", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
+    if (doc.LastClickedIndex != -1 && doc.LastClickedIndex < state.AllLogs.size()) {
+
+        // Calculate bounds (5 before, 5 after)
+        int startIdx = std::max(0, doc.LastClickedIndex - 8);
+        int endIdx = std::min(static_cast<int>(state.AllLogs.size()), doc.LastClickedIndex + 9);
+
+        ImGui::Text("Context around log #%d:", doc.LastClickedIndex);
+        ImGui::Separator();
+
+        // Ctrl+C: copy selected context lines
+        if (ImGui::GetIO().KeyCtrl && ImGui::IsKeyPressed(ImGuiKey_C) && ImGui::IsWindowFocused()) {
+            if (!doc.ContextSelectedIndices.empty()) {
+                std::string clipboardText;
+                for (int idx : doc.ContextSelectedIndices) {
+                    clipboardText += CleanLogLine(state.AllLogs[idx].FullText);
+                }
+                ImGui::SetClipboardText(clipboardText.c_str());
+            }
+        }
+
+        for (int i = startIdx; i < endIdx; i++) {
+            const auto& log = state.AllLogs[i];
 
-            if (i == g_ScrollToFilteredIndex) {
-                ImGui::SetScrollHereY(0.5f);
-                g_ScrollToFilteredIndex = -1;
+            ImGui::PushID(i);
+
+            bool isSelected = doc.ContextSelectedIndices.contains(i);
+
+            // Highlighted line gets green, others dimmed, but selection overrides to normal brightness
+            ImVec4 color = (i == doc.LastClickedIndex)
+                ? ImVec4(0, 1, 0, 1)
+                : (isSelected ? ImVec4(0.95f, 0.96f, 0.98f, 1.0f) : ImVec4(0.7f, 0.7f, 0.7f, 1.0f));
+
+            ImGui::PushStyleColor(ImGuiCol_Text, color);
+
+            std::string label = "##ctx" + std::to_string(i);
+            if (ImGui::Selectable(label.c_str(), isSelected, ImGuiSelectableFlags_SpanAllColumns)) {
+                if (ImGui::GetIO().KeyCtrl) {
+                    if (isSelected) doc.ContextSelectedIndices.erase(i);
+                    else            doc.ContextSelectedIndices.insert(i);
+                    doc.ContextLastClickedIndex = i;
+                } else if (ImGui::GetIO().KeyShift && doc.ContextLastClickedIndex != -1) {
+                    int rangeStart = std::min(doc.ContextLastClickedIndex, i);
+                    int rangeEnd   = std::max(doc.ContextLastClickedIndex, i);
+                    doc.ContextSelectedIndices.clear();
+                    for (int n = rangeStart; n <= rangeEnd; n++)
+                        doc.ContextSelectedIndices.insert(n);
+                } else {
+                    doc.ContextSelectedIndices.clear();
+                    doc.ContextSelectedIndices.insert(i);
+                    doc.ContextLastClickedIndex = i;
+                }
+            }
+
+            ImGui::SameLine();
+            ImGui::Text("[%d]", i);
+            ImGui::SameLine();
+            LogLineText(ShownLogText(state, log));
+
+            ImGui::PopStyleColor();
+
+            if (ImGui::BeginPopupContextItem("ctxmenu")) {
+                if (ImGui::MenuItem("Copy")) {
+                    const std::string text = "```\n" + CleanLogLine(log.FullText) + "\n```";
+                    ImGui::SetClipboardText(text.c_str());
+                }
+                ImGui::EndPopup();
+            }
+
+            ImGui::PopID();
+        }
+    } else {
+        ImGui::TextDisabled("Select a log line to view context.");
+    }
+    ImGui::EndChild();
+    ImGui::End();
+}
+
+
+// Query panel state
+char g_QueryBuffer[256] = "count by category where level = Error";
+QueryResult g_QueryResult;
+bool g_QueryResultSorted = true;
+QueryServer g_QueryServer;
+int g_QueryServerPort = 8765;
+const LogDocument* g_QueryDocument = nullptr; // Document of g_QueryResult
+
+void RenderQueryPanel() {
+    LogViewerState& state = g_ActiveDocument->State;
+    if (g_QueryDocument != g_ActiveDocument) {
+        g_QueryDocument = g_ActiveDocument;
+        g_QueryResult = {};
+    }
+    ImGui::Begin("Query");
+
+    ImGui::SetNextItemWidth(-80);
+    bool run = ImGui::InputText("##Query", g_QueryBuffer, sizeof(g_QueryBuffer), ImGuiInputTextFlags_EnterReturnsTrue);
+    ImGui::SetItemTooltip("count [by level|category|fingerprint|day|hour|minute, ...] [where key = value and ...]");
+    ImGui::SameLine();
+    run |= ImGui::Button("Run");
+
+    if (run) {
+        AggregationQuery query;
+        std::string error;
+        if (ParseAggregationQuery(g_QueryBuffer, state, query, error)) {
+            g_QueryResult = RunAggregationQuery(query, state);
+            g_QueryResultSorted = false;
+        } else {
+            g_QueryResult = {};
+            g_QueryResult.Error = error;
+        }
+    }
+
+    if (!g_QueryResult.Error.empty()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", g_QueryResult.Error.c_str());
+    } else if (!g_QueryResult.Rows.empty()) {
+        ImGui::Text("%d groups in %.1f ms", (int)g_QueryResult.Rows.size(), g_QueryResult.ElapsedMs);
+    }
+
+    if (ImGui::CollapsingHeader("Local server")) {
+        bool serving = g_QueryServer.IsRunning();
+        ImGui::SetNextItemWidth(100);
+        ImGui::BeginDisabled(serving);
+        ImGui::InputInt("Port", &g_QueryServerPort, 0);
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        if (ImGui::Checkbox("Serve on 127.0.0.1", &serving)) {
+            if (serving) g_QueryServer.Start(state, g_QueryServerPort);
+            else g_QueryServer.Stop();
+        }
+        if (!g_QueryServer.LastError().empty())
+            ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", g_QueryServer.LastError().c_str());
+        else if (g_QueryServer.IsRunning())
+            ImGui::TextDisabled("NDJSON endpoints: /count /filter /lines /query on http://127.0.0.1:%d", g_QueryServer.Port());
+    }
+
+    const int columnCount = (int)g_QueryResult.Columns.size() + 1;
+    const ImGuiTableFlags flags = ImGuiTableFlags_Sortable | ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg |
+                                  ImGuiTableFlags_ScrollY | ImGuiTableFlags_BordersInnerV;
+    if (!g_QueryResult.Rows.empty() && ImGui::BeginTable("QueryResult", columnCount, flags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        for (const auto& column : g_QueryResult.Columns)
+            ImGui::TableSetupColumn(column.c_str());
+        ImGui::TableSetupColumn("Count", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+        ImGui::TableHeadersRow();
+
+        if (ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs(); specs && (specs->SpecsDirty || !g_QueryResultSorted)) {
+            const ImGuiTableColumnSortSpecs& spec = specs->Specs[0];
+            const int column = spec.ColumnIndex;
+            const bool ascending = spec.SortDirection == ImGuiSortDirection_Ascending;
+            std::ranges::stable_sort(g_QueryResult.Rows, [&](const QueryResultRow& a, const QueryResultRow& b) {
+                if (column == columnCount - 1)
+                    return ascending ? a.Count < b.Count : a.Count > b.Count;
+                return ascending ? a.Cells[column] < b.Cells[column] : a.Cells[column] > b.Cells[column];
+            });
+            specs->SpecsDirty = false;
+            g_QueryResultSorted = true;
+        }
+
+        ImGuiListClipper clipper;
+        clipper.Begin((int)g_QueryResult.Rows.size());
+        while (clipper.Step()) {
+            for (int r = clipper.DisplayStart; r < clipper.DisplayEnd; r++) {
+                const QueryResultRow& row = g_QueryResult.Rows[r];
+                ImGui::TableNextRow();
+                for (const auto& cell : row.Cells) {
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(cell.c_str());
+                }
+                ImGui::TableNextColumn();
+                ImGui::Text("%lld", static_cast<long long>(row.Count));
+                const int64_t line = row.FirstLogIndex - state.DroppedLines;
+                if (ImGui::IsItemHovered() && line >= 0 && line < (int64_t)state.AllLogs.size())
+                    ImGui::SetTooltip("%s", state.AllLogs[line].FullText.c_str());
+            }
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+void OpenCorpusHit(const CorpusHit& hit) {
+    LogDocument& doc = OpenDocument((g_Corpus.Root / g_Corpus.Files[hit.FileId].Path).string(), false);
+    doc.LastClickedIndex = hit.LineIndex;
+    doc.ContextSelectedIndices.clear();
+    doc.ContextLastClickedIndex = -1;
+    auto it = std::ranges::lower_bound(doc.State.FilteredIndices, hit.LineIndex);
+    if (it != doc.State.FilteredIndices.end() && *it == hit.LineIndex)
+        doc.ScrollToFilteredIndex = static_cast<int>(it - doc.State.FilteredIndices.begin());
+}
+
+void RenderCorpusPanel() {
+    ImGui::Begin("Corpus");
+    const bool busy = g_Corpus.Busy;
+
+    ImGui::BeginDisabled(busy);
+    if (ImGui::Button("Open Folder")) {
+        NFD_Init();
+        nfdchar_t* outPath;
+        if (NFD_PickFolder(&outPath, nullptr) == NFD_OKAY) {
+            g_Corpus.OpenAndUpdate(outPath);
+            NFD_FreePath(outPath);
+        }
+        NFD_Quit();
+    }
+    ImGui::SameLine();
+    ImGui::BeginDisabled(g_Corpus.Root.empty());
+    if (ImGui::Button("Update Index"))
+        g_Corpus.OpenAndUpdate(g_Corpus.Root);
+    ImGui::EndDisabled();
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    ImGui::TextDisabled("%s", g_Corpus.Root.empty() ? "No folder" : g_Corpus.Root.string().c_str());
+
+    if (busy && g_Corpus.Total > 0) {
+        ImGui::ProgressBar(static_cast<float>(g_Corpus.Done) / g_Corpus.Total, ImVec2(-1, 0));
+    }
+    ImGui::TextUnformatted(g_Corpus.GetStatus().c_str());
+
+    ImGui::BeginDisabled(busy || g_Corpus.Root.empty());
+    ImGui::SetNextItemWidth(-80);
+    bool search = ImGui::InputTextWithHint("##CorpusSearch", "Search all files...", g_CorpusSearch, sizeof(g_CorpusSearch),
+                                           ImGuiInputTextFlags_EnterReturnsTrue);
+    ImGui::SameLine();
+    search |= ImGui::Button("Search");
+    ImGui::EndDisabled();
+    if (search && g_CorpusSearch[0] != '\0')
+        g_Corpus.Search(g_CorpusSearch, CORPUS_MAX_HITS);
+
+    // Read again: a button above may have started a job, which now owns Files and the results
+    if (g_Corpus.Busy) {
+        ImGui::End();
+        return;
+    }
+
+    if (!g_Corpus.FingerprintFiles.empty()) {
+        const CorpusFile& first = g_Corpus.Files[g_Corpus.FingerprintFiles.front()];
+        ImGui::Text("First appeared in %s", first.Path.c_str());
+    }
+    if (g_Corpus.HitsTruncated)
+        ImGui::TextDisabled("Showing the first %d hits", CORPUS_MAX_HITS);
+
+    const ImGuiTableFlags flags = ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_BordersInnerV;
+    if (!g_Corpus.Hits.empty() && ImGui::BeginTable("CorpusHits", 3, flags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("File", ImGuiTableColumnFlags_WidthFixed, 250.0f);
+        ImGui::TableSetupColumn("Line", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+        ImGui::TableSetupColumn("Text");
+        ImGui::TableHeadersRow();
+
+        const CorpusHit* toOpen = nullptr;
+        ImGuiListClipper clipper;
+        clipper.Begin((int)g_Corpus.Hits.size());
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                const CorpusHit& hit = g_Corpus.Hits[i];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::PushID(i);
+                if (ImGui::Selectable(g_Corpus.Files[hit.FileId].Path.c_str(), false,
+                                      ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowDoubleClick) &&
+                    ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+                    toOpen = &hit;
+                }
+                ImGui::SetItemTooltip("Double-click to open");
+                ImGui::PopID();
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", hit.LineIndex);
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(hit.Text.c_str());
+            }
+        }
+        ImGui::EndTable();
+        if (toOpen) OpenCorpusHit(*toOpen);
+    }
+
+    ImGui::End();
+}
+
+// Flags the Warning/Error fingerprints of a freshly loaded log that no recorded run contains
+void RefreshNewFingerprints(LogViewerState& state) {
+    state.NewFingerprints.clear();
+    if (g_Trends.Runs.empty()) return;
+    for (const LogEntry& log : state.AllLogs) {
+        if (log.IsHeader && log.Level != LogLevel::Display && !g_Trends.Series.contains(log.ContentHash))
+            state.NewFingerprints.insert(log.ContentHash);
+    }
+}
+
+void RenderTrendsPanel() {
+    LogDocument& doc = *g_ActiveDocument;
+    LogViewerState& state = doc.State;
+    if (g_TrendsDocument != &doc || g_TrendsLoadGeneration != state.LoadGeneration) {
+        g_TrendsDocument = &doc;
+        g_TrendsLoadGeneration = state.LoadGeneration;
+        RefreshNewFingerprints(state);
+        g_TrendsStatus.clear();
+    }
+
+    ImGui::Begin("Trends");
+    ImGui::Text("%d runs recorded", (int)g_Trends.Runs.size());
+    ImGui::SameLine();
+    ImGui::BeginDisabled(state.AllLogs.empty());
+    if (ImGui::Button("Record This Run")) {
+        // Nightly runs reuse the file name: a run is the file started at a given time
+        TrendRun run;
+        const auto firstTimestamp = std::ranges::find_if(state.AllLogs, [](const LogEntry& log) { return log.Timestamp != 0; });
+        run.Timestamp = firstTimestamp != state.AllLogs.end() ? firstTimestamp->Timestamp : FileModifiedTimeMs(state.FilePath);
+        run.Id = std::filesystem::path(state.FilePath).filename().string() + " " + FormatLogTimestamp(run.Timestamp);
+
+        std::vector<uint64_t> fingerprints;
+        std::vector<uint32_t> counts;
+        CountRunFingerprints(state, fingerprints, counts);
+        g_TrendsStatus = g_Trends.Record(run, fingerprints, counts)
+            ? "Recorded " + run.Id + " (" + std::to_string(fingerprints.size()) + " fingerprints)"
+            : "Already recorded or cannot write " + std::string(TRENDS_DB_NAME);
+    }
+    ImGui::EndDisabled();
+    if (!g_TrendsStatus.empty()) ImGui::TextDisabled("%s", g_TrendsStatus.c_str());
+
+    if (!g_Trends.Runs.empty())
+        ImGui::Text("New warnings/errors in this log: %d", (int)state.NewFingerprints.size());
+    ImGui::Separator();
+
+    if (doc.LastClickedIndex >= 0 && doc.LastClickedIndex < (int)state.AllLogs.size()) {
+        // Continuation lines follow the fingerprint of their header
+        int header = doc.LastClickedIndex;
+        while (header > 0 && !state.AllLogs[header].IsHeader) header--;
+        const LogEntry& log = state.AllLogs[header];
+
+        const std::vector<float> history = g_Trends.History(log.ContentHash);
+        const int firstRun = g_Trends.FirstRun(log.ContentHash);
+        ImGui::TextWrapped("%s", CleanLogLine(log.FullText).c_str());
+        if (firstRun >= 0)
+            ImGui::Text("First seen in %s", g_Trends.Runs[firstRun].Id.c_str());
+        else
+            ImGui::TextDisabled("Never recorded");
+        if (!history.empty())
+            ImGui::PlotHistogram("##History", history.data(), (int)history.size(), 0, "Occurrences per run (oldest to newest)",
+                                 0.0f, FLT_MAX, ImVec2(-1, 120));
+    } else {
+        ImGui::TextDisabled("Select a log line to see its history.");
+    }
+
+    ImGui::End();
+}
+
+// Shows a line in the inspector, and in the list when it passes the filters
+void ShowLine(LogDocument& doc, int line) {
+    doc.LastClickedIndex = line;
+    doc.ContextSelectedIndices.clear();
+    doc.ContextLastClickedIndex = -1;
+    auto it = std::ranges::lower_bound(doc.State.FilteredIndices, line);
+    if (it != doc.State.FilteredIndices.end() && *it == line)
+        doc.ScrollToFilteredIndex = static_cast<int>(it - doc.State.FilteredIndices.begin());
+}
+
+void RenderRarePanel() {
+    if (g_BaselineLoad.Finished()) {
+        if (LogDocument* target = FindDocument(g_BaselineLoad.Document)) {
+            if (g_BaselineLoad.Counts) {
+                target->State.Baseline = std::move(g_BaselineLoad.Counts);
+                target->State.BaselineName = std::filesystem::path(g_BaselineLoad.Path).filename().string();
+                if (target->State.RareOnly) target->State.ApplyFilters();
+                g_RareStatus.clear();
+            } else {
+                g_RareStatus = "Cannot read " + g_BaselineLoad.Path;
             }
+        }
+    }
+    LogDocument& doc = *g_ActiveDocument;
+    LogViewerState& state = doc.State;
+    if (!ImGui::Begin("Rare Messages")) { // Hidden tab: nothing to rank
+        ImGui::End();
+        return;
+    }
+    if (g_RareDocument != &doc || g_RareLoadGeneration != state.LoadGeneration) g_RareStatus.clear();
+    const auto now = std::chrono::steady_clock::now();
+    if (g_RareDocument != &doc || g_RareLoadGeneration != state.LoadGeneration || g_RareBaseline != state.Baseline.get() ||
+        ((g_RareLines != state.NextLogIndex || g_RareDropped != state.DroppedLines) && now - g_RareRankTime >= RARE_RERANK_INTERVAL)) {
+        g_RareRankTime = now;
+        g_RareDocument = &doc;
+        g_RareLoadGeneration = state.LoadGeneration;
+        g_RareLines = state.NextLogIndex;
+        g_RareDropped = state.DroppedLines;
+        g_RareBaseline = state.Baseline.get();
+        g_RareRanking = RankRareMessages(state, g_RareBaseline);
+    }
+
+    ImGui::BeginDisabled(g_BaselineLoad.Busy);
+    if (ImGui::Button("Load Baseline")) {
+        NFD_Init();
+        nfdchar_t* outPath;
+        nfdfilteritem_t filterItem[1] = { { "Unreal Logs", "log,txt,gz" } };
+        if (NFD_OpenDialog(&outPath, filterItem, 1, nullptr) == NFD_OKAY) {
+            g_BaselineLoad.Start(doc.Id, outPath);
+            NFD_FreePath(outPath);
+        }
+        NFD_Quit();
+    }
+    ImGui::EndDisabled();
+    ImGui::SetItemTooltip("Count occurrences in another log (e.g. a good run) instead of this one");
+    ImGui::SameLine();
+    if (g_BaselineLoad.Busy) {
+        ImGui::TextDisabled("Counting %s...", std::filesystem::path(g_BaselineLoad.Path).filename().string().c_str());
+    } else if (state.Baseline) {
+        if (ImGui::Button("Clear Baseline")) {
+            state.Baseline.reset();
+            state.BaselineName.clear();
+            if (state.RareOnly) state.ApplyFilters();
+        } else {
+            ImGui::SameLine();
+            ImGui::TextDisabled("%s (%zu messages)", state.BaselineName.c_str(), state.Baseline->size());
+        }
+    } else {
+        ImGui::TextDisabled("No baseline, occurrences in this log");
+    }
+    if (!g_RareStatus.empty()) ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", g_RareStatus.c_str());
 
-            // --- COLOR LOGIC ---
-            ImVec4 color = ImVec4(0.9f, 0.9f, 0.9f, 1.0f); // Default Light Grey
-            if (log.Level == LogLevel::Error) color = ImVec4(1.0f, 0.4f, 0.4f, 1.0f); // Red
-            else if (log.Level == LogLevel::Warning) color = ImVec4(1.0f, 0.9f, 0.4f, 1.0f); // Yellow
-            else if (log.Category == "LogCook") color = ImVec4(0.6f, 0.8f, 1.0f, 1.0f); // Light Blue
+    const FingerprintCounts* baseline = state.Baseline.get();
+    const auto rare = std::ranges::partition_point(g_RareRanking, [&](int message) {
+        return state.MessageOccurrences(message, baseline) <= state.RareMaxCount;
+    });
+    ImGui::Text("%zu distinct messages, %d seen at most %d times", g_RareRanking.size(),
+                static_cast<int>(rare - g_RareRanking.begin()), state.RareMaxCount);
+    ImGui::Separator();
 
-            for (const auto& hw : g_Highlights) {
-                if (hw.SearchBuffer[0] == '\0') continue;
-                std::string term = hw.SearchBuffer;
-                std::ranges::transform(term, term.begin(), ::tolower);
-                std::string text = log.FullText;
-                std::ranges::transform(text, text.begin(), ::tolower);
-                if (text.find(term) != std::string::npos)
-                    color = hw.Color;
-            }
+    const int columnCount = baseline ? 5 : 4;
+    if (ImGui::BeginTable("##Rare", columnCount, ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Seen", ImGuiTableColumnFlags_WidthFixed);
+        if (baseline) ImGui::TableSetupColumn("Baseline", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("Level", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("Category", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("Message", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableHeadersRow();
 
-            // --- SELECTION LOGIC ---
-            bool isSelected = g_LogState.SelectedIndices.contains(i);
+        ImGuiListClipper clipper;
+        clipper.Begin((int)g_RareRanking.size());
+        while (clipper.Step()) {
+            for (int r = clipper.DisplayStart; r < clipper.DisplayEnd; r++) {
+                const int message = g_RareRanking[r];
+                // The first occurrence may have been dropped by retention
+                const int64_t line = state.MessageFirstLines[message] - state.DroppedLines;
+                const LogEntry* log = (line >= 0 && line < (int64_t)state.AllLogs.size()) ? &state.AllLogs[line] : nullptr;
 
-            ImGui::PushStyleColor(ImGuiCol_Text, color);
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::PushID(message);
+                const std::string seen = std::to_string(state.MessageCounts[message]);
+                if (ImGui::Selectable(seen.c_str(), doc.LastClickedIndex == line, ImGuiSelectableFlags_SpanAllColumns) && log)
+                    ShowLine(doc, static_cast<int>(line));
+                ImGui::PopID();
+                if (baseline) {
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%d", state.MessageOccurrences(message, baseline));
+                }
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(log ? LogLevelName(log->Level) : "");
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(log ? log->Category.c_str() : "");
+                ImGui::TableNextColumn();
+                if (log) LogLineText(CleanLogLine(log->FullText));
+                else ImGui::TextDisabled("(dropped)");
+            }
+        }
+        ImGui::EndTable();
+    }
 
-            // Generate a unique ID for Selectable using "##" + index
-            std::string label = "##Line" + std::to_string(i);
+    ImGui::End();
+}
 
-            // Draw the selectable line (spans full width)
-            if (ImGui::Selectable(label.c_str(), isSelected, ImGuiSelectableFlags_SpanAllColumns)) {
-                // 1. Handle CTRL+Click (Toggle)
-                if (ImGui::GetIO().KeyCtrl) {
-                    if (isSelected) g_LogState.SelectedIndices.erase(i);
-                    else g_LogState.SelectedIndices.insert(i);
-                    g_LogState.LastClickedIndex = i;
-                }
-                // 2. Handle SHIFT+Click (Range)
-                else if (ImGui::GetIO().KeyShift && g_LogState.LastClickedIndex != -1) {
-                    int start = std::min(g_LogState.LastClickedIndex, i);
-                    int end = std::max(g_LogState.LastClickedIndex, i);
+void RenderSimilarPanel() {
+    LogDocument& doc = *g_ActiveDocument;
+    LogViewerState& state = doc.State;
+    SimilarityIndex& index = doc.Similar;
+    if (index.Collect()) index.QueryPending = false;
+    if (index.QueryPending && !index.Busy) {
+        if (index.QueryGeneration != state.LoadGeneration) index.QueryPending = false; // Another log was loaded
+        else if (!index.Covers(state, index.Query)) index.Update(state);
+        else index.Search(state);
+    }
 
-                    // Clear previous selection if you want standard OS behavior,
-                    // or keep it if you want additive. Standard is usually to clear:
-                    g_LogState.SelectedIndices.clear();
+    if (g_SimilarFocus) {
+        ImGui::SetNextWindowFocus();
+        g_SimilarFocus = false;
+    }
+    if (!ImGui::Begin("Similar Messages")) {
+        ImGui::End();
+        return;
+    }
+    if (index.Query < 0 || index.QueryGeneration != state.LoadGeneration) {
+        ImGui::TextDisabled("Right-click a line and choose Find Similar.");
+        ImGui::End();
+        return;
+    }
 
-                    for (int n = start; n <= end; n++) {
-                        g_LogState.SelectedIndices.insert(n);
-                    }
-                }
-                // 3. Handle Normal Click (Single select)
-                else {
-                    g_LogState.SelectedIndices.clear();
-                    g_LogState.SelectedIndices.insert(i);
-                    g_LogState.LastClickedIndex = i;
-                    g_LastClickedIndex = log.LogIndex;
-                    g_ContextSelectedIndices.clear();
-                    g_ContextLastClickedIndex = -1;
-                }
-            }
+    ImGui::TextDisabled("Similar to:");
+    ImGui::SameLine();
+    const std::string_view query = MessageFirstText(state, index.Query);
+    ImGui::TextWrapped("%s", CleanLogLine(std::string(query)).c_str());
+    if (index.Busy && !index.Searching) {
+        const int total = std::max(1, index.Total.load());
+        ImGui::ProgressBar(static_cast<float>(index.Done) / total, ImVec2(-1, 0), "Indexing messages");
+    } else if (index.QueryPending) {
+        ImGui::TextDisabled("Searching...");
+    } else {
+        ImGui::Text("%zu similar messages", index.Results.size());
+    }
+    ImGui::Separator();
 
-            // Draw the actual text on top of the Selectable
-            ImGui::SameLine();
-            ImGui::TextUnformatted(log.FullText.c_str());
+    if (!index.QueryPending && !index.Results.empty() &&
+        ImGui::BeginTable("##Similar", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Similarity", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("Seen", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("Level", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("Category", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("Message", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableHeadersRow();
 
-            ImGui::PopStyleColor();
+        ImGuiListClipper clipper;
+        clipper.Begin((int)index.Results.size());
+        while (clipper.Step()) {
+            for (int r = clipper.DisplayStart; r < clipper.DisplayEnd; r++) {
+                const SimilarMessage& result = index.Results[r];
+                const int64_t line = state.MessageFirstLines[result.Message] - state.DroppedLines;
+                const LogEntry* log = (line >= 0 && line < (int64_t)state.AllLogs.size()) ? &state.AllLogs[line] : nullptr;
 
-            // Right-Click Context Menu
-            std::string contextMenuId = "##ctx" + std::to_string(i);
-            if (ImGui::BeginPopupContextItem(contextMenuId.c_str())) {
-                if (ImGui::Selectable("Copy")) {
-                    const std::string text = "```\n" + CleanLogLine(log.FullText) + "\n```";
-                    ImGui::SetClipboardText(text.c_str());
-                }
-                if (ImGui::Selectable("Filter to this Category")) {
-                    g_LogState.SelectedCategory = log.Category;
-                    newCategoryFilter = log.Category;
-                }
-                ImGui::EndPopup();
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::PushID(r);
+                char similarity[16];
+                snprintf(similarity, sizeof(similarity), "%.0f%%", result.Similarity * 100.0f);
+                if (ImGui::Selectable(similarity, doc.LastClickedIndex == line, ImGuiSelectableFlags_SpanAllColumns) && log)
+                    ShowLine(doc, static_cast<int>(line));
+                ImGui::PopID();
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", state.MessageCounts[result.Message]);
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(log ? LogLevelName(log->Level) : "");
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(log ? log->Category.c_str() : "");
+                ImGui::TableNextColumn();
+                if (log) LogLineText(CleanLogLine(log->FullText));
+                else ImGui::TextDisabled("(dropped)");
             }
         }
-    }
-    ImGui::EndChild();
-
-    if (!newCategoryFilter.empty()) {
-        g_LogState.SelectedCategory = newCategoryFilter;
-        g_LogState.ApplyFilters();
+        ImGui::EndTable();
     }
 
     ImGui::End();
+}
 
-    // The Context Window
-    ImGui::Begin("Log Context (Inspector)");
+// Starts reading a stream ("-" for stdin) into a fresh log
+bool StartStreamInput(const std::string& path) {
+    LogDocument& doc = NewDocument();
+    doc.Live = true;
+    LogViewerState& state = doc.State;
+    {
+        std::unique_lock dataLock(state.DataMutex);
+        state.Reset();
+        state.FilePath = (path == "-") ? "<stdin>" : path;
+        state.LoadGeneration++;
+        state.ApplyFilters();
+    }
+    g_Stream.Detach(); // The previous reader thread exits on its next block
+    g_StreamDocument = &doc;
+    g_StreamLoadGeneration = state.LoadGeneration;
+    return g_Stream.Start(path);
+}
 
-    ImGui::BeginChild("LogContext", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
-    if (g_LastClickedIndex != -1 && g_LastClickedIndex < g_LogState.AllLogs.size()) {
+// Runs append (returns the index of the first new line), then rebases the inspector over
+// the lines dropped by retention and runs the alert rules on the new lines only
+template <typename Fn>
+void AppendLiveLines(LogDocument& doc, Fn&& append) {
+    LogViewerState& state = doc.State;
+    const int generation = state.LoadGeneration;
+    const int64_t dropped = state.DroppedLines;
+    const int firstNewLine = append();
 
-        // Calculate bounds (5 before, 5 after)
-        int startIdx = std::max(0, g_LastClickedIndex - 8);
-        int endIdx = std::min(static_cast<int>(g_LogState.AllLogs.size()), g_LastClickedIndex + 9);
+    if (generation != state.LoadGeneration) g_Alerts.ResetWindows();
+    if (dropped != state.DroppedLines) doc.RebaseInspector(static_cast<int>(state.DroppedLines - dropped));
+    const size_t firstEvent = g_Alerts.Events.size();
+    g_Alerts.Evaluate(state, firstNewLine);
+    for (size_t n = firstEvent; n < g_Alerts.Events.size(); ++n) g_Alerts.Events[n].Document = doc.Id;
+}
 
-        ImGui::Text("Context around log #%d:", g_LastClickedIndex);
-        ImGui::Separator();
+// Follow, stream and network modes: every document with a live input gets its new lines
+void UpdateLiveInput() {
+    // Loading another file into its document ends the stream / network ingestion
+    if (g_Stream.IsActive() && g_StreamLoadGeneration != g_StreamDocument->State.LoadGeneration) g_Stream.Detach();
+    if (g_Ingest.IsRunning() && g_IngestLoadGeneration != g_IngestDocument->State.LoadGeneration) g_Ingest.Stop();
 
-        // Ctrl+C: copy selected context lines
-        if (ImGui::GetIO().KeyCtrl && ImGui::IsKeyPressed(ImGuiKey_C) && ImGui::IsWindowFocused()) {
-            if (!g_ContextSelectedIndices.empty()) {
-                std::string clipboardText;
-                for (int idx : g_ContextSelectedIndices) {
-                    clipboardText += CleanLogLine(g_LogState.AllLogs[idx].FullText);
-                }
-                ImGui::SetClipboardText(clipboardText.c_str());
-            }
+    if (g_Ingest.IsRunning()) {
+        LogViewerState& state = g_IngestDocument->State;
+        std::vector<LogEntry> entries;
+        std::vector<std::pair<int, std::string>> newSources;
+        g_Ingest.Take(entries, newSources);
+        for (auto& [id, name] : newSources) {
+            if (id >= (int)state.SourceNames.size()) state.SourceNames.resize(id + 1);
+            state.SourceNames[id] = std::move(name);
         }
+        if (!entries.empty()) AppendLiveLines(*g_IngestDocument, [&] { return state.AppendEntries(entries); });
+    }
+    if (g_Stream.IsActive()) {
+        LogViewerState& state = g_StreamDocument->State;
+        if (!g_Stream.IsFinished()) {
+            const std::string bytes = g_Stream.Take();
+            if (!bytes.empty()) AppendLiveLines(*g_StreamDocument, [&] { return state.AppendText(bytes); });
+        } else if (!state.PartialLine.empty()) {
+            AppendLiveLines(*g_StreamDocument, [&] { return state.FlushPartialLine(); }); // Nothing more will come
+        }
+    }
 
-        for (int i = startIdx; i < endIdx; i++) {
-            const auto& log = g_LogState.AllLogs[i];
-
-            ImGui::PushID(i);
-
-            bool isSelected = g_ContextSelectedIndices.contains(i);
-
-            // Highlighted line gets green, others dimmed, but selection overrides to normal brightness
-            ImVec4 color = (i == g_LastClickedIndex)
-                ? ImVec4(0, 1, 0, 1)
-                : (isSelected ? ImVec4(0.95f, 0.96f, 0.98f, 1.0f) : ImVec4(0.7f, 0.7f, 0.7f, 1.0f));
+    const auto now = std::chrono::steady_clock::now();
+    if (now - g_LastFollowPoll < std::chrono::milliseconds(250)) return;
+    g_LastFollowPoll = now;
+    for (auto& doc : g_Documents) {
+        LogViewerState& state = doc->State;
+        if (state.Retention.MaxAgeMs > 0 && !doc->Loader.IsActive()) AppendLiveLines(*doc, [&] { return state.ExpireOldLines(); });
+        if (!state.Follow || state.FilePath.empty() || doc->Live || doc->Loader.IsActive()) continue;
+        AppendLiveLines(*doc, [&] { return state.PollFollowedFile(); });
+    }
+}
 
-            ImGui::PushStyleColor(ImGuiCol_Text, color);
+void RenderAlertsPanel() {
+    const int unseen = static_cast<int>(g_Alerts.Events.size()) - g_AlertsSeen;
+    const std::string title = unseen > 0 ? "Alerts (" + std::to_string(unseen) + ")###Alerts" : "Alerts###Alerts";
+    if (!ImGui::Begin(title.c_str())) {
+        ImGui::End();
+        return;
+    }
+    if (ImGui::IsWindowFocused()) g_AlertsSeen = static_cast<int>(g_Alerts.Events.size());
 
-            std::string label = "##ctx" + std::to_string(i);
-            if (ImGui::Selectable(label.c_str(), isSelected, ImGuiSelectableFlags_SpanAllColumns)) {
-                if (ImGui::GetIO().KeyCtrl) {
-                    if (isSelected) g_ContextSelectedIndices.erase(i);
-                    else            g_ContextSelectedIndices.insert(i);
-                    g_ContextLastClickedIndex = i;
-                } else if (ImGui::GetIO().KeyShift && g_ContextLastClickedIndex != -1) {
-                    int rangeStart = std::min(g_ContextLastClickedIndex, i);
-                    int rangeEnd   = std::max(g_ContextLastClickedIndex, i);
-                    g_ContextSelectedIndices.clear();
-                    for (int n = rangeStart; n <= rangeEnd; n++)
-                        g_ContextSelectedIndices.insert(n);
-                } else {
-                    g_ContextSelectedIndices.clear();
-                    g_ContextSelectedIndices.insert(i);
-                    g_ContextLastClickedIndex = i;
-                }
-            }
+    ImGui::SetNextItemWidth(-60);
+    bool add = ImGui::InputTextWithHint("##Rule", "category=LogNet level=Error count>10 window=30s", g_AlertRuleBuffer,
+                                        sizeof(g_AlertRuleBuffer), ImGuiInputTextFlags_EnterReturnsTrue);
+    ImGui::SetItemTooltip("Terms: level=Error|Warning|Display category=Name text=\"substring\" count>N window=30s");
+    ImGui::SameLine();
+    add |= ImGui::Button("Add");
+    if (add) {
+        AlertRule rule;
+        if (CompileAlertRule(g_AlertRuleBuffer, rule, g_AlertRuleError)) {
+            g_Alerts.Rules.push_back(std::move(rule));
+            g_AlertRuleBuffer[0] = '\0';
+            g_AlertRuleError.clear();
+        }
+    }
+    if (!g_AlertRuleError.empty())
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", g_AlertRuleError.c_str());
 
-            ImGui::SameLine();
-            ImGui::Text("[%d] %s", i, log.FullText.c_str());
+    for (int r = 0; r < (int)g_Alerts.Rules.size(); ) {
+        ImGui::PushID(r);
+        const bool remove = ImGui::SmallButton("x");
+        ImGui::SameLine();
+        ImGui::TextUnformatted(g_Alerts.Rules[r].Source.c_str());
+        ImGui::PopID();
+        if (remove) g_Alerts.Rules.erase(g_Alerts.Rules.begin() + r);
+        else r++;
+    }
+    if (!g_ActiveDocument->State.Follow && !g_Alerts.Rules.empty())
+        ImGui::TextDisabled("Rules are evaluated on new lines while \"Follow\" is enabled.");
 
-            ImGui::PopStyleColor();
+    ImGui::Separator();
+    if (ImGui::SmallButton("Clear")) {
+        g_Alerts.Events.clear();
+        g_AlertsSeen = 0;
+    }
 
-            if (ImGui::BeginPopupContextItem("ctxmenu")) {
-                if (ImGui::MenuItem("Copy")) {
-                    const std::string text = "```\n" + CleanLogLine(log.FullText) + "\n```";
-                    ImGui::SetClipboardText(text.c_str());
-                }
-                ImGui::EndPopup();
+    ImGui::BeginChild("AlertEvents", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
+    ImGuiListClipper clipper;
+    clipper.Begin((int)g_Alerts.Events.size());
+    while (clipper.Step()) {
+        for (int n = clipper.DisplayStart; n < clipper.DisplayEnd; n++) {
+            // Newest first
+            const AlertEvent& event = g_Alerts.Events[g_Alerts.Events.size() - 1 - n];
+            ImGui::PushID(n);
+            const std::string label = (event.Time ? FormatLogTimestamp(event.Time) : std::string("-")) + "  " + event.Rule;
+            LogDocument* doc = FindDocument(event.Document);
+            const int64_t line = doc && doc->State.LoadGeneration == event.LoadGeneration ? event.LogIndex - doc->State.DroppedLines : -1;
+            if (ImGui::Selectable(label.c_str()) && line >= 0 && line < (int64_t)doc->State.AllLogs.size()) {
+                doc->FocusRequested = true;
+                ActivateDocument(*doc);
+                doc->LastClickedIndex = static_cast<int>(line);
+                auto it = std::ranges::lower_bound(doc->State.FilteredIndices, static_cast<int>(line));
+                if (it != doc->State.FilteredIndices.end() && *it == line)
+                    doc->ScrollToFilteredIndex = static_cast<int>(it - doc->State.FilteredIndices.begin());
             }
-
+            ImGui::SetItemTooltip("%s", event.Text.c_str());
             ImGui::PopID();
         }
-    } else {
-        ImGui::TextDisabled("Select a log line to view context.");
     }
     ImGui::EndChild();
     ImGui::End();
 }
 
+void CloseDocument(LogDocument* doc) {
+    if (g_StreamDocument == doc) {
+        g_Stream.Detach();
+        g_StreamDocument = nullptr;
+    }
+    if (g_IngestDocument == doc) {
+        g_Ingest.Stop();
+        g_IngestDocument = nullptr;
+    }
+    if (g_QueryServer.Serves(doc->State)) g_QueryServer.Stop();
+    if (g_QueryDocument == doc) g_QueryDocument = nullptr;
+    if (g_TrendsDocument == doc) g_TrendsDocument = nullptr;
+    std::erase_if(g_Documents, [&](const auto& open) { return open.get() == doc; });
+
+    if (g_ActiveDocument == doc) {
+        g_ActiveDocument = nullptr;
+        if (g_Documents.empty()) NewDocument(); // There is always a tab to load the next log in
+        else ActivateDocument(*g_Documents.back());
+        g_ActiveDocument->FocusRequested = true;
+    }
+}
+
+void RenderDocuments(ImGuiID dockspace) {
+    std::vector<LogDocument*> closed;
+    for (auto& doc : g_Documents) {
+        if (!RenderLogDocument(*doc, dockspace)) closed.push_back(doc.get());
+    }
+    for (LogDocument* doc : closed) CloseDocument(doc);
+    RenderInspector();
+}
+
 // =========================================================
 
 void SetupModernStyle() {
@@ -626,9 +7886,858 @@ void SetupModernStyle() {
     colors[ImGuiCol_FrameBgActive]          = ImVec4(0.30f, 0.30f, 0.33f, 1.00f);
 }
 
+// =========================================================
+// --- UI BENCHMARK ---
+// --bench-ui renders the log view without a window or GPU: the ImGui context has no
+// platform/renderer backend and its textures are acknowledged without being uploaded.
+// A script of user actions is replayed as ImGui input events against a synthetic log,
+// and the CPU time of every frame is recorded. Script: one command per line, # comments.
+//   frames N                 N frames without input
+//   wheel DY [N]             mouse wheel over the log list, N times (negative DY scrolls down)
+//   click ROW [shift|ctrl]   clicks the ROWth visible row of the list
+//   search [TEXT]            focuses the search box and replaces its text (nothing clears it)
+//   copy                     Ctrl+C
+//   highlight TEXT           adds a highlight term
+//   wrap on|off              word wrap
+//   collapse on|off          collapse repeated messages
+constexpr const char* DEFAULT_UI_BENCH_SCRIPT = R"(
+frames 30
+wheel -3 120
+click 2
+click 12 shift
+copy
+highlight LatencyMs
+wheel -10 60
+search error
+frames 10
+wheel -3 60
+click 0
+click 30 shift
+copy
+search
+highlight Player=7
+wheel 5 60
+frames 30
+)";
+constexpr int DEFAULT_UI_BENCH_LINES = 200000;
+
+// Deterministic log with the usual mix: levels, categories, structured fields, repeated
+// messages, call stack continuation lines and a few very long lines (up to 256 KB)
+std::string GenerateSyntheticLog(int lines) {
+    static const char* categories[] = {"LogTemp", "LogNet", "LogCook", "LogStreaming", "LogRHI", "LogAudio", "LogBlueprint"};
+    std::mt19937 random(1234);
+    std::string text;
+    text.reserve(static_cast<size_t>(lines) * 110);
+    int64_t timestamp = ParseLogTimestamp("[2024.01.01-14.00.00:000]");
+    for (int i = 0; i < lines; ++i) {
+        timestamp += random() % 50;
+        const unsigned roll = random() % 100;
+        if (roll < 3 && i > 0) {
+            text += "    0x00007ff6" + std::to_string(random()) + " UnrealEditor-Engine.dll!UWorld::Tick() [World.cpp:" + std::to_string(random() % 9000) + "]\n";
+            continue;
+        }
+        text += "[" + FormatLogTimestamp(timestamp) + "][" + std::to_string(i % 1000) + "]";
+        text += categories[random() % std::size(categories)];
+        text += roll < 8 ? ": Error: " : roll < 20 ? ": Warning: " : ": Display: ";
+        if (roll % 5 == 0) {
+            text += "Repeated message that shows up all the time"; // Duplicates
+        } else {
+            text += "Client update Player=" + std::to_string(random() % 64) + " LatencyMs=" + std::to_string(random() % 400) +
+                    " Map=\"/Game/Maps/Level" + std::to_string(random() % 8) + "\"";
+        }
+        if (roll == 99) text += " " + std::string(i % 10 == 0 ? 256 * 1024 : 4000, 'x'); // Huge serialized payload
+        text += '\n';
+    }
+    return text;
+}
+
+static double Percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) return 0.0;
+    std::ranges::sort(values);
+    return values[std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()))];
+}
+
+int RunUiBenchmark(const std::string& scriptPath, int lines) {
+    std::string script = DEFAULT_UI_BENCH_SCRIPT;
+    if (!scriptPath.empty()) {
+        std::ifstream file(scriptPath, std::ios::binary);
+        if (!file.is_open()) {
+            fprintf(stderr, "Cannot open %s\n", scriptPath.c_str());
+            return 1;
+        }
+        script.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    LogDocument& doc = NewDocument();
+    doc.State.AppendText(GenerateSyntheticLog(lines));
+    doc.State.FilePath = "<synthetic>";
+    doc.State.LoadGeneration++;
+    doc.State.ApplyFilters();
+
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.DisplaySize = ImVec2(1600, 900);
+    io.DeltaTime = 1.0f / 60.0f;
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures;
+    SetupModernStyle();
+
+    std::vector<double> viewMs;
+    std::vector<double> frameMs;
+    auto frame = [&] {
+        using Clock = std::chrono::steady_clock;
+        const auto frameStart = Clock::now();
+        ImGui::NewFrame();
+        ImGui::SetNextWindowPos(ImVec2(0, 0));
+        ImGui::SetNextWindowSize(ImVec2(1200, 900));
+        const auto viewStart = Clock::now();
+        RenderLogDocument(doc, 0);
+        viewMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - viewStart).count());
+        ImGui::SetNextWindowPos(ImVec2(1200, 0));
+        ImGui::SetNextWindowSize(ImVec2(400, 900));
+        RenderInspector();
+        ImGui::Render();
+        // Null renderer: every texture request is acknowledged
+        for (ImTextureData* texture : ImGui::GetPlatformIO().Textures) {
+            if (texture->Status == ImTextureStatus_WantCreate) texture->SetTexID(1);
+            if (texture->Status == ImTextureStatus_WantDestroy) {
+                texture->SetTexID(ImTextureID_Invalid);
+                texture->SetStatus(ImTextureStatus_Destroyed);
+            } else if (texture->Status != ImTextureStatus_OK && texture->Status != ImTextureStatus_Destroyed) {
+                texture->SetStatus(ImTextureStatus_OK);
+            }
+        }
+        frameMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count());
+    };
+    frame(); // Layout for the first command
+
+    // Geometry of the previous frame
+    auto listWindow = [&]() -> ImGuiWindow* {
+        ImGuiWindow* docWindow = ImGui::FindWindowByName(doc.WindowName().c_str());
+        for (ImGuiWindow* window : ImGui::GetCurrentContext()->Windows) {
+            if (window->ParentWindow == docWindow && std::strstr(window->Name, "/LogScroll_")) return window;
+        }
+        return nullptr;
+    };
+    auto press = [&](ImGuiKey key) {
+        io.AddKeyEvent(key, true);
+        frame();
+        io.AddKeyEvent(key, false);
+    };
+
+    std::istringstream commands(script);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(commands, line)) {
+        lineNumber++;
+        std::istringstream words(line.substr(0, line.find('#')));
+        std::string command;
+        if (!(words >> command)) continue;
+        ImGuiWindow* list = listWindow();
+        if (!list) {
+            fprintf(stderr, "Line %d: '%s': the log view is not visible\n", lineNumber, command.c_str());
+            ImGui::DestroyContext();
+            return 1;
+        }
+        const ImVec2 listCenter = list->InnerRect.GetCenter();
+
+        if (command == "frames") {
+            int count = 1;
+            words >> count;
+            for (int n = 0; n < count; ++n) frame();
+        } else if (command == "wheel") {
+            float notches = 0.0f;
+            int count = 1;
+            words >> notches >> count;
+            io.AddMousePosEvent(listCenter.x, listCenter.y);
+            for (int n = 0; n < count; ++n) {
+                io.AddMouseWheelEvent(0.0f, notches);
+                frame();
+            }
+        } else if (command == "click") {
+            int row = 0;
+            std::string modifier;
+            words >> row >> modifier;
+            // In double from the unscrolled origin, like the wrapped rows are placed
+            const double rowHeight = ImGui::GetTextLineHeightWithSpacing();
+            const double origin = static_cast<double>(list->DC.CursorStartPos.y) + list->DC.CursorStartPosLossyness.y + list->Scroll.y;
+            double offset = (std::floor(list->Scroll.y / rowHeight) + row) * rowHeight;
+            if (doc.WordWrap) offset = doc.Wrap.Offset(doc.Wrap.RowAt(list->Scroll.y) + row);
+            const float y = static_cast<float>(origin + (offset - list->Scroll.y) + ImGui::GetTextLineHeight() * 0.5);
+            const ImGuiKey modifierKey = modifier == "shift" ? ImGuiMod_Shift : modifier == "ctrl" ? ImGuiMod_Ctrl : ImGuiKey_None;
+            io.AddMousePosEvent(list->InnerRect.Min.x + 100.0f, y);
+            if (modifierKey != ImGuiKey_None) io.AddKeyEvent(modifierKey, true);
+            io.AddMouseButtonEvent(ImGuiMouseButton_Left, true);
+            frame();
+            io.AddMouseButtonEvent(ImGuiMouseButton_Left, false);
+            if (modifierKey != ImGuiKey_None) io.AddKeyEvent(modifierKey, false);
+            frame();
+        } else if (command == "search") {
+            std::string text;
+            std::getline(words >> std::ws, text);
+            ImGui::ActivateItemByID(ImGui::FindWindowByName(doc.WindowName().c_str())->GetID("##Search"));
+            frame(); // Activated with its text selected, typing replaces it
+            if (text.empty()) press(ImGuiKey_Backspace);
+            for (char c : text) {
+                io.AddInputCharacter(static_cast<unsigned char>(c));
+                frame();
+            }
+            press(ImGuiKey_Enter);
+            frame();
+        } else if (command == "copy") {
+            io.AddKeyEvent(ImGuiMod_Ctrl, true);
+            press(ImGuiKey_C);
+            io.AddKeyEvent(ImGuiMod_Ctrl, false);
+            frame();
+        } else if (command == "highlight") {
+            std::string text;
+            std::getline(words >> std::ws, text);
+            HighlightWidget highlight{"", GenerateHighlightColor(), 0};
+            snprintf(highlight.SearchBuffer, sizeof(highlight.SearchBuffer), "%s", text.c_str());
+            g_Highlights.push_back(highlight);
+            frame();
+        } else if (command == "wrap") {
+            std::string mode;
+            words >> mode;
+            doc.WordWrap = mode != "off";
+            frame();
+        } else if (command == "collapse") {
+            std::string mode;
+            words >> mode;
+            doc.CollapseRuns = mode != "off";
+            frame();
+        } else if (command == "tokens") {
+            std::string mode;
+            words >> mode;
+            doc.TokenColors = mode != "off";
+            frame();
+        } else {
+            fprintf(stderr, "Line %d: unknown command '%s'\n", lineNumber, command.c_str());
+            ImGui::DestroyContext();
+            return 1;
+        }
+    }
+
+    const char* clipboard = ImGui::GetClipboardText();
+    printf("%d synthetic lines, %d shown after the script, %d selected, %zu bytes copied, %zu frames\n", lines,
+           (int)doc.State.FilteredIndices.size(), (int)doc.State.SelectedIndices.size(), clipboard ? strlen(clipboard) : 0, frameMs.size());
+    printf("%-10s %8s %8s %8s %8s  (ms CPU)\n", "", "p50", "p90", "p99", "max");
+    for (const auto& [name, samples] : {std::pair{"log view", &viewMs}, std::pair{"frame", &frameMs}}) {
+        printf("%-10s %8.3f %8.3f %8.3f %8.3f\n", name, Percentile(*samples, 0.5), Percentile(*samples, 0.9),
+               Percentile(*samples, 0.99), Percentile(*samples, 1.0));
+    }
+    ImGui::DestroyContext();
+    return 0;
+}
+
+// =========================================================
+// --- SELF TEST ---
+// --self-test checks case folding, block skipping, the row layouts and the gzip index on
+// generated logs, then runs the network endpoints on 127.0.0.1 (ports picked by the OS) against
+// stand-in clients. Exits non-zero when a check fails. Registered with CTest.
+struct SelfTest {
+    int Failures = 0;
+
+    void Check(bool ok, const char* what) {
+        printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+        if (!ok) ++Failures;
+    }
+};
+
+static SocketHandle SelfTestConnect(int port, int type) {
+    const SocketHandle client = socket(AF_INET, type, type == SOCK_STREAM ? IPPROTO_TCP : IPPROTO_UDP);
+    if (client == INVALID_SOCKET_HANDLE) return client;
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        CloseSocket(client);
+        return INVALID_SOCKET_HANDLE;
+    }
+    return client;
+}
+
+// Sends a raw HTTP request, returns the whole response (empty when the connection failed)
+static std::string SelfTestHttp(int port, const std::string& request) {
+    const SocketHandle client = SelfTestConnect(port, SOCK_STREAM);
+    if (client == INVALID_SOCKET_HANDLE) return {};
+    send(client, request.data(), static_cast<int>(request.size()), 0);
+    std::string response;
+    char buffer[4096];
+    for (int received; (received = recv(client, buffer, sizeof(buffer), 0)) > 0;) response.append(buffer, received);
+    CloseSocket(client);
+    return response;
+}
+
+static void SelfTestQueryServer(SelfTest& test) {
+    LogViewerState state;
+    state.AppendText("[2024.01.01-10.00.00:000][  0]LogNet: Error: Connection lost\n"
+                     "[2024.01.01-10.00.01:000][  1]LogNet: Warning: LatencyMs=250\n"
+                     "[2024.01.01-10.00.02:000][  2]LogTemp: Display: Bad byte \xFF here\n");
+    QueryServer server;
+    test.Check(server.Start(state, 0), "query server listens on 127.0.0.1");
+    if (!server.IsRunning()) return;
+    auto get = [&](const std::string& target) { return SelfTestHttp(server.Port(), "GET " + target + " HTTP/1.1\r\n\r\n"); };
+    auto isStatus = [](const std::string& response, const char* status) { return response.starts_with(std::string("HTTP/1.1 ") + status); };
+
+    std::string response = get("/count");
+    test.Check(isStatus(response, "200") && response.contains("{\"count\":3,\"total\":3}"), "/count counts every line");
+    test.Check(get("/count?display=0&category=LogNet").contains("{\"count\":2,"), "/count applies levels and categories");
+    response = get("/filter?search=bad+byte");
+    test.Check(response.contains("Bad byte \xEF\xBF\xBD here") && !response.contains('\xFF'), "/filter replaces invalid UTF-8 with U+FFFD");
+    test.Check(get("/lines?from=1&to=2").contains("\"line\":1,\"level\":\"Warning\""), "/lines returns a range");
+    test.Check(get("/query?q=count+by+category").contains("{\"category\":\"LogNet\",\"count\":2}"), "/query aggregates");
+    response = get("/query?q=sum+by+category");
+    test.Check(isStatus(response, "400") && response.contains("{\"error\":"), "/query rejects a malformed query with 400");
+    test.Check(isStatus(get("/nowhere"), "404"), "unknown endpoints answer 404");
+    test.Check(isStatus(SelfTestHttp(server.Port(), "POST /count HTTP/1.1\r\n\r\n"), "400"), "methods other than GET answer 400");
+    server.Stop();
+}
+
+static void SelfTestIngest(SelfTest& test) {
+    IngestServer server;
+    test.Check(server.Start(0), "ingestion listens on 127.0.0.1");
+    if (!server.IsRunning()) return;
+
+    // Stand-in senders: a TCP connection whose last line has no newline, and a UDP sender
+    const std::string tcpLines = "[2024.01.01-10.00.00:000][  0]LogNet: Error: tcp one\n"
+                                 "[2024.01.01-10.00.01:000][  0]LogNet: Display: tcp two";
+    const std::string udpLines = "[2024.01.01-10.00.02:000][  0]LogTemp: Warning: udp one\n"
+                                 "[2024.01.01-10.00.03:000][  0]LogTemp: Display: udp two\n";
+    const SocketHandle tcp = SelfTestConnect(server.Port(), SOCK_STREAM);
+    const SocketHandle udp = SelfTestConnect(server.Port(), SOCK_DGRAM);
+    test.Check(tcp != INVALID_SOCKET_HANDLE && udp != INVALID_SOCKET_HANDLE, "senders connect");
+    if (tcp != INVALID_SOCKET_HANDLE) {
+        send(tcp, tcpLines.data(), static_cast<int>(tcpLines.size()), 0);
+        CloseSocket(tcp);
+    }
+    if (udp != INVALID_SOCKET_HANDLE) {
+        send(udp, udpLines.data(), static_cast<int>(udpLines.size()), 0);
+        CloseSocket(udp);
+    }
+
+    std::vector<LogEntry> entries;
+    std::vector<std::pair<int, std::string>> sources;
+    for (int wait = 0; wait < 100 && (entries.size() < 4 || server.ConnectionThreadCount() > 0); ++wait) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        std::vector<LogEntry> batch;
+        std::vector<std::pair<int, std::string>> newSources;
+        server.Take(batch, newSources);
+        std::ranges::move(batch, std::back_inserter(entries));
+        std::ranges::move(newSources, std::back_inserter(sources));
+    }
+    test.Check(entries.size() == 4, "every line arrives, including a last line without newline");
+    auto linesOf = [&](const char* protocol) {
+        auto source = std::ranges::find_if(sources, [&](const auto& s) { return s.second.starts_with(protocol); });
+        if (source == sources.end()) return -1;
+        return static_cast<int>(std::ranges::count_if(entries, [&](const LogEntry& log) {
+            return log.SourceId == source->first && log.FullText.contains(std::string(protocol) + " ");
+        }));
+    };
+    test.Check(sources.size() == 2 && sources[0].first != sources[1].first && linesOf("tcp") == 2 && linesOf("udp") == 2,
+               "each sender gets its own source id");
+    test.Check(server.ConnectionThreadCount() == 0, "closed connections are joined without waiting for Stop()");
+    server.Stop();
+}
+
+static void SelfTestCaseFolding(SelfTest& test) {
+    test.Check(FoldCase("\xC6\xA0\xC6\xAF \xC8\x98\xC8\x9A \xE1\x82\xA0 \xE1\xBA\x9E \xCE\xA3\xCE\x91\xCF\x82 \xD0\x96")
+                   == "\xC6\xA1\xC6\xB0 \xC8\x99\xC8\x9B \xE2\xB4\x80 \xC3\x9F \xCF\x83\xCE\xB1\xCF\x83 \xD0\xB6",
+               "FoldCase folds Vietnamese, Romanian, Georgian, Greek and Cyrillic");
+    test.Check(FoldCase("K\xE2\x84\xAA \xC4\xB0 \xC3\x9F") == "kk \xC4\xB0 \xC3\x9F", "FoldCase uses the simple folding only");
+    test.Check(FoldCase("A\xFF" "B\xC3") == "a\xFF" "b\xC3" && FoldCase("\xE0\x80\xAFZ") == "\xE0\x80\xAF" "z",
+               "FoldCase keeps malformed UTF-8 bytes as they are");
+
+    // 40 bytes and more: the SSE2 loop runs, with matches in it and in the scalar tail
+    const std::string ascii = "[2024.01.01-10.00.00:000][  0]LogStreaming: Warning: Failed to load /Game/Maps/Arena";
+    test.Check(CaseInsensitiveSearch("FAILED TO LOAD").Matches(ascii, true) && CaseInsensitiveSearch("maps/ARENA").Matches(ascii, true)
+                   && !CaseInsensitiveSearch("maps/arenas").Matches(ascii, true) && !CaseInsensitiveSearch("logstreaming:  ").Matches(ascii, true),
+               "ASCII search ignores case");
+    const std::string text = "[2024.01.01-10.00.00:000][  0]LogOnline: Display: Utilizator \xC8\x98tefan \xC8\x9Binut, \xC6\xAF\xE1\xBB\x9B" "c";
+    test.Check(CaseInsensitiveSearch("\xC8\x99TEFAN \xC8\x9AINUT").Matches(text) && CaseInsensitiveSearch("\xC6\xB0\xE1\xBB\x9A").Matches(text)
+                   && !CaseInsensitiveSearch("\xC8\x99tefana").Matches(text),
+               "non-ASCII search ignores case");
+    test.Check(CaseInsensitiveSearch("\xFF" "ab").Matches("x\xFF" "AB", false) && !CaseInsensitiveSearch("\xC3\xA9").Matches("\xC3 \xA9", false),
+               "search on malformed UTF-8 compares the bytes");
+}
+
+// Log text with a line per 100 ms from line first: categories change every 1500 lines, errors
+// only around line 4000, a few words that appear once and a message repeated every 700 lines
+static std::string SelfTestLogLines(int first, int count) {
+    std::string text;
+    char line[256];
+    for (int i = first; i < first + count; ++i) {
+        const int seconds = i / 10;
+        const char* level = (i >= 4000 && i < 4010) ? "Error" : (i % 97 == 0) ? "Warning" : "Display";
+        const char* extra = (i == 5555) ? " zebrafish" : (i == 9100) ? " ZEBRAFISH" : (i % 250 == 0) ? " \xC8\x98terge" : "";
+        snprintf(line, sizeof(line), "[2024.01.01-%02d.%02d.%02d:%03d][%3d]LogCat%d: %s: Processing item %d of batch %d in the streaming region%s\n",
+                 10 + seconds / 3600, seconds / 60 % 60, seconds % 60, i % 10 * 100, i % 1000, i / 1500 % 8, level, i % 300, i / 50, extra);
+        if (i % 700 == 350) snprintf(line, sizeof(line), "[2024.01.01-%02d.%02d.%02d:%03d][%3d]LogRetry: Warning: Retrying the connection\n",
+                                     10 + seconds / 3600, seconds / 60 % 60, seconds % 60, i % 10 * 100, i % 1000);
+        text += line;
+    }
+    return text;
+}
+
+static void SelfTestBlockSkipping(SelfTest& test) {
+    LogViewerState state;
+    state.AppendText(SelfTestLogLines(0, 6000));
+    const int openBlockStart = state.BlockEnd;
+    state.AppendText(SelfTestLogLines(6000, 4000));
+    test.Check(state.Blocks.size() > 8 && std::ranges::any_of(state.Blocks, [&](const BlockSynopsis& block) {
+                   return block.FirstLine == openBlockStart && block.FirstLine < 6000 && block.FirstLine + block.LineCount > 6000;
+               }), "a block closed by an append covers lines of both appends");
+    BlockProbe rare;
+    rare.SetSearch("zebrafish");
+    test.Check(std::ranges::count_if(state.Blocks, [&](const BlockSynopsis& block) { return block.MayMatch(rare); }) <= 2,
+               "synopses rule out the blocks without a rare word");
+
+    std::vector<LogFilter> filters(9);
+    filters[0].Search = "zebrafish";
+    filters[1].Search = "batch 7 ";
+    filters[2].Search = "\xC8\x99TERGE";
+    filters[3].ShowDisplay = filters[3].ShowWarnings = false;
+    filters[4].Categories = {"LogCat3", "LogCat5"};
+    filters[5].FromTime = state.AllLogs[5990].Timestamp;
+    filters[5].ToTime = state.AllLogs[6020].Timestamp;
+    filters[6].Categories = {"LogCat2"};
+    filters[6].Search = "item 7 ";
+    filters[6].ShowDuplicates = false;
+    filters[7].ShowDisplay = false;
+    filters[7].FromTime = state.AllLogs[3000].Timestamp;
+    filters[8].FromTime = state.AllLogs[7000].Timestamp; // Skipped blocks still mark their messages as seen
+    filters[8].ShowDuplicates = false;
+    auto runAll = [&](LogViewerState& target) {
+        std::vector<std::vector<int>> rows(filters.size());
+        for (size_t n = 0; n < filters.size(); ++n) target.RunFilter(filters[n], rows[n]);
+        return rows;
+    };
+    const std::vector<std::vector<int>> withBlocks = runAll(state);
+    std::vector<BlockSynopsis> blocks = std::move(state.Blocks);
+    state.Blocks.clear();
+    const std::vector<std::vector<int>> withoutBlocks = runAll(state);
+    state.Blocks = std::move(blocks);
+    test.Check(withBlocks == withoutBlocks && std::ranges::none_of(withoutBlocks, &std::vector<int>::empty),
+               "filters return the same rows with and without block synopses");
+
+    // Synopses of a sidecar, taken before the same lines are loaded again
+    const std::vector<unsigned char> saved = state.SaveBlocks();
+    LogViewerState reloaded;
+    test.Check(reloaded.LoadBlocks(saved, 10000), "saved synopses load back");
+    reloaded.AppendText(SelfTestLogLines(0, 10000));
+    test.Check(runAll(reloaded) == withoutBlocks && reloaded.SaveBlocks() == saved, "loaded synopses filter like computed ones");
+    std::vector<unsigned char> broken = saved;
+    reinterpret_cast<BlockSynopsis*>(broken.data())[2].FirstLine++;
+    LogViewerState rejected;
+    test.Check(!rejected.LoadBlocks(broken, 10000) && !rejected.LoadBlocks(saved, 9000) && rejected.Blocks.empty(),
+               "synopses with gaps or past the last line are rejected");
+}
+
+static void SelfTestRowHeights(SelfTest& test) {
+    std::mt19937 random(7);
+    RowHeightTree tree;
+    std::vector<double> heights; // Plain copy of the rows, the front is erased on drop
+    bool ok = true;
+    for (int step = 0; step < 3000 && ok; ++step) {
+        const int action = static_cast<int>(random() % 10);
+        if (action < 7 || heights.empty()) {
+            heights.push_back(13.0 + random() % 60);
+            tree.Append(heights.back());
+        } else if (action < 9) {
+            const size_t row = random() % heights.size();
+            const double delta = static_cast<double>(random() % 40) - std::min(heights[row] - 1.0, 20.0);
+            heights[row] += delta;
+            tree.Add(row, delta);
+        } else {
+            const size_t rows = random() % (heights.size() / 2 + 1);
+            heights.erase(heights.begin(), heights.begin() + rows);
+            tree.DropFront(rows);
+        }
+        double offset = 0.0;
+        ok = tree.size() == heights.size();
+        for (size_t row = 0; row < heights.size() && ok; ++row) {
+            ok = tree.Offset(row) == offset && tree.Height(row) == heights[row] && tree.RowAt(offset) == row
+                 && tree.RowAt(offset + heights[row] - 0.5) == row;
+            offset += heights[row];
+        }
+        ok = ok && tree.Total() == offset && (heights.empty() || tree.RowAt(offset + 100.0) == heights.size() - 1);
+    }
+    test.Check(ok, "row height tree matches plain sums through appends, resizes and drops");
+}
+
+static void SelfTestCollapsedRows(SelfTest& test) {
+    // Runs of repeated messages, some with continuation lines, between single ones
+    const char* messages[] = {"LogNet: Warning: Packet lost", "LogTemp: Display: Tick", "LogCook: Error: Missing asset", "LogAI: Display: Path found"};
+    std::mt19937 random(11);
+    std::string text;
+    int message = 0;
+    for (int n = 0; n < 600; ++n) {
+        if (random() % 2) message = static_cast<int>(random() % 4);
+        text += "[2024.01.01-10.00.00:000][  0]" + std::string(messages[message]) + "\n";
+        if (random() % 5 == 0) text += "    at Function() in Source.cpp\n";
+    }
+    LogViewerState state;
+    state.AppendText(text);
+
+    bool ok = true;
+    for (const bool showDisplay : {true, false}) {
+        state.ShowDisplay = showDisplay;
+        state.ApplyFilters();
+        for (int view = 0; view < (int)state.FilteredRuns.size(); view += 3) state.ToggleRunExpanded(view);
+
+        std::vector<int> visible; // Filtered rows shown, in order
+        std::vector<int> collapsedRow(state.FilteredIndices.size());
+        for (int row = 0; row < (int)state.FilteredIndices.size(); ++row) {
+            const auto folder = std::ranges::find_if(state.FilteredRuns, [&](const RunView& view) {
+                return row >= view.HiddenBegin && row < view.HiddenBegin + view.Hidden;
+            });
+            collapsedRow[row] = folder == state.FilteredRuns.end() ? static_cast<int>(visible.size()) : collapsedRow[folder->Head];
+            if (folder == state.FilteredRuns.end()) visible.push_back(row);
+        }
+        ok = ok && state.HiddenRunRows > 0 && state.CollapsedRowCount() == (int)visible.size();
+        for (int row = 0; row < (int)visible.size() && ok; ++row) ok = state.CollapsedToFiltered(row) == visible[row];
+        for (int row = 0; row < (int)collapsedRow.size() && ok; ++row) ok = state.FilteredToCollapsed(row) == collapsedRow[row];
+    }
+    test.Check(ok, "collapsed and filtered rows map to each other, with folded and unfolded runs");
+}
+
+static void SelfTestGzipIndex(SelfTest& test) {
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / ("ulr-self-test-" + std::to_string(std::random_device()()) + ".log.gz");
+    const std::string text = SelfTestLogLines(0, 110000); // About 13 MB: several checkpoints
+    if (gzFile file = gzopen(path.string().c_str(), "wb1")) {
+        gzwrite(file, text.data(), static_cast<unsigned>(text.size()));
+        gzclose(file);
+    }
+    GzipIndex index;
+    std::string built;
+    const bool ok = index.Build(path, [&](std::string_view data) { built.append(data); return true; });
+    test.Check(ok && built == text && index.Checkpoints.size() >= 3, "building the gzip index inflates the whole file");
+
+    if (index.Checkpoints.size() >= 3) {
+        const GzipCheckpoint& middle = index.Checkpoints[index.Checkpoints.size() / 2];
+        std::string tail;
+        index.ReadFrom(middle.Out, [&](std::string_view data) { tail.append(data); return true; });
+        test.Check(tail == text.substr(middle.Out), "inflating from a checkpoint matches a full inflate");
+
+        // Lines straddling the checkpoint, from the index in memory and from its sidecar
+        std::vector<std::string> expected;
+        std::istringstream stream(text);
+        for (std::string line; std::getline(stream, line);)
+            if ((int64_t)expected.size() < middle.Line + 5) expected.push_back(std::move(line));
+        expected.erase(expected.begin(), expected.end() - 10);
+        std::vector<std::string> lines, saved;
+        GzipIndex loaded;
+        index.ReadLines(middle.Line - 5, 10, lines);
+        const bool reloaded = index.Save() && loaded.Load(path) && loaded.ReadLines(middle.Line - 5, 10, saved);
+        test.Check(lines == expected && reloaded && saved == expected, "lines around a checkpoint read the same from memory and from the sidecar");
+    }
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    std::filesystem::remove(GzipIndex::SidecarPath(path), error);
+}
+
+int RunSelfTest() {
+    SelfTest test;
+    SelfTestCaseFolding(test);
+    SelfTestBlockSkipping(test);
+    SelfTestRowHeights(test);
+    SelfTestCollapsedRows(test);
+    SelfTestGzipIndex(test);
+    SelfTestQueryServer(test);
+    SelfTestIngest(test);
+    printf("%d check(s) failed\n", test.Failures);
+    return test.Failures == 0 ? 0 : 1;
+}
+
+// =========================================================
+// --- COMMAND LINE ---
+//   UnrealLogsReader [<file>]... [--filter "<search>"] [--timing]
+//                    [--follow <file> | --stream <pipe> | - | --listen <port>]
+//                    [--max-lines N] [--max-bytes N[K|M|G]] [--max-age <duration>]
+//                    [--memory-budget N[K|M|G]]
+//                    [--alert "<rule>"]... [--on-alert "<command>"] [--headless]
+//   UnrealLogsReader --bench-load <file> [--warm]
+//   UnrealLogsReader --bench-ui [--script <file>] [--lines N]
+//   UnrealLogsReader <file>... [--filter "<search>"] --export-arrow <out.arrow>
+//   UnrealLogsReader --self-test
+// Each <file> opens in a tab, with --filter in its search box. The files start loading
+// before the window is created. --timing prints when the window, the first frame and the
+// loaded logs were ready. "-" (or --stream -) reads stdin. --headless follows the input without opening a window,
+// prints every alert on stdout and runs the --on-alert command with ULR_ALERT_RULE /
+// ULR_ALERT_TEXT set in its environment. --bench-load compares the read backends on a file
+// (page cache dropped before every run unless --warm) and exits. --bench-ui replays a UI
+// script without a window and prints frame time percentiles (see UI BENCHMARK). --export-arrow
+// writes the lines of the files matching --filter to an Arrow IPC file and exits (see ARROW EXPORT).
+// --self-test checks the network endpoints on localhost and exits (see SELF TEST).
+struct CommandLineOptions {
+    std::vector<std::string> FilePaths;
+    std::string Filter;
+    bool Timing = false;
+    std::string FollowPath;
+    std::string StreamPath;
+    RetentionPolicy Retention;
+    size_t MemoryBudget = DEFAULT_MEMORY_BUDGET;
+    int ListenPort = 0;
+    std::vector<std::string> AlertRules;
+    std::string AlertCommand;
+    bool Headless = false;
+    std::string BenchLoadPath;
+    bool BenchWarm = false;
+    bool BenchUi = false;
+    std::string BenchUiScript; // Empty = DEFAULT_UI_BENCH_SCRIPT
+    int BenchUiLines = DEFAULT_UI_BENCH_LINES;
+    std::string ExportArrowPath;
+    bool SelfTest = false;
+};
+
+// "512M" -> 536870912. Plain numbers are bytes.
+static size_t ParseByteSize(const std::string& text) {
+    char* end = nullptr;
+    const double value = std::max(0.0, std::strtod(text.c_str(), &end));
+    switch (std::toupper(static_cast<unsigned char>(*end))) {
+        case 'K': return static_cast<size_t>(value * 1024);
+        case 'M': return static_cast<size_t>(value * 1024 * 1024);
+        case 'G': return static_cast<size_t>(value * 1024 * 1024 * 1024);
+    }
+    return static_cast<size_t>(value);
+}
+
+bool ParseCommandLine(int argc, char** argv, CommandLineOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--follow" && hasValue) options.FollowPath = argv[++i];
+        else if (arg == "--stream" && hasValue) options.StreamPath = argv[++i];
+        else if (arg == "-") options.StreamPath = "-";
+        else if (arg == "--listen" && hasValue) options.ListenPort = std::atoi(argv[++i]);
+        else if (arg == "--max-lines" && hasValue) options.Retention.MaxLines = static_cast<size_t>(std::max(0LL, std::atoll(argv[++i])));
+        else if (arg == "--max-bytes" && hasValue) options.Retention.MaxBytes = ParseByteSize(argv[++i]);
+        else if (arg == "--memory-budget" && hasValue) options.MemoryBudget = ParseByteSize(argv[++i]);
+        else if (arg == "--max-age" && hasValue) {
+            if (!ParseDurationMs(argv[++i], options.Retention.MaxAgeMs)) {
+                fprintf(stderr, "Invalid duration for --max-age: %s (use ms, s, m or h)\n", argv[i]);
+                return false;
+            }
+        }
+        else if (arg == "--alert" && hasValue) options.AlertRules.push_back(argv[++i]);
+        else if (arg == "--on-alert" && hasValue) options.AlertCommand = argv[++i];
+        else if (arg == "--headless") options.Headless = true;
+        else if (arg == "--bench-load" && hasValue) options.BenchLoadPath = argv[++i];
+        else if (arg == "--warm") options.BenchWarm = true;
+        else if (arg == "--bench-ui") options.BenchUi = true;
+        else if (arg == "--script" && hasValue) options.BenchUiScript = argv[++i];
+        else if (arg == "--lines" && hasValue) options.BenchUiLines = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--filter" && hasValue) options.Filter = argv[++i];
+        else if (arg == "--timing") options.Timing = true;
+        else if (arg == "--export-arrow" && hasValue) options.ExportArrowPath = argv[++i];
+        else if (arg == "--self-test") options.SelfTest = true;
+        else if (!arg.starts_with("-")) options.FilePaths.push_back(arg);
+        else {
+            fprintf(stderr, "Unknown or incomplete argument: %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+static void SetEnvironmentValue(const char* name, const std::string& value) {
+#ifdef _WIN32
+    _putenv_s(name, value.c_str());
+#else
+    setenv(name, value.c_str(), 1);
+#endif
+}
+
+// Opens the --follow / --stream input of the command line
+bool StartCommandLineInput(const CommandLineOptions& options) {
+    g_ActiveDocument->State.Retention = options.Retention; // Inherited by the document of the input
+    g_Memory.BudgetBytes = options.MemoryBudget;
+    if (options.ListenPort > 0) {
+        if (StartIngest(options.ListenPort)) return true;
+        fprintf(stderr, "%s\n", g_Ingest.LastError().c_str());
+        return false;
+    }
+    if (!options.StreamPath.empty()) {
+        if (StartStreamInput(options.StreamPath)) return true;
+        fprintf(stderr, "Cannot open %s\n", options.StreamPath.c_str());
+        return false;
+    }
+    if (!options.FollowPath.empty()) {
+        LogDocument& doc = OpenDocument(options.FollowPath, false);
+        doc.State.Follow = true;
+    }
+    for (const std::string& path : options.FilePaths) {
+        LogDocument& doc = NewDocument();
+        snprintf(doc.State.SearchBuffer, sizeof(doc.State.SearchBuffer), "%s", options.Filter.c_str());
+        doc.StartLoad(path); // Parses on the pool while the window and the GL context are created
+    }
+    return true;
+}
+
+// --timing: milliseconds since the process started, printed at each startup milestone
+struct StartupTiming {
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    bool Enabled = false;
+    bool LogsReported = false;
+
+    void Mark(const char* milestone) const {
+        if (!Enabled) return;
+        printf("%-14s %8.1f ms\n", milestone, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count());
+        fflush(stdout);
+    }
+};
+
+StartupTiming g_Startup;
+
+bool InstallAlertRules(const CommandLineOptions& options) {
+    for (const std::string& source : options.AlertRules) {
+        AlertRule rule;
+        std::string error;
+        if (!CompileAlertRule(source, rule, error)) {
+            fprintf(stderr, "Invalid alert rule \"%s\": %s\n", source.c_str(), error.c_str());
+            return false;
+        }
+        g_Alerts.Rules.push_back(std::move(rule));
+    }
+    return true;
+}
+
+// For every backend: raw read throughput, then a full load (read + parse)
+int RunLoadBenchmark(const CommandLineOptions& options) {
+    std::error_code error;
+    const uint64_t size = std::filesystem::file_size(options.BenchLoadPath, error);
+    if (error) {
+        fprintf(stderr, "Cannot open %s\n", options.BenchLoadPath.c_str());
+        return 1;
+    }
+    const double megabytes = size / (1024.0 * 1024.0);
+    printf("%s: %.1f MB, %zu KB blocks, %d in flight\n", options.BenchLoadPath.c_str(), megabytes, READ_BLOCK_SIZE >> 10, READ_QUEUE_DEPTH);
+
+    auto prepare = [&] {
+        if (!options.BenchWarm && !DropFileCache(options.BenchLoadPath)) printf("  (cannot drop the page cache, reads are warm)\n");
+        return std::chrono::steady_clock::now();
+    };
+    auto seconds = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    LogViewerState state;
+    for (ReadBackend backend : {ReadBackend::Stream, ReadBackend::Threads, ReadBackend::IoUring}) {
+        if (backend == ReadBackend::IoUring && !HAS_IO_URING) continue;
+
+        auto start = prepare();
+        FileBlockReader reader;
+        uint64_t read = 0;
+        if (reader.Open(options.BenchLoadPath, backend)) {
+            std::string_view block;
+            while (reader.Next(block)) read += block.size();
+        }
+        const double readSeconds = seconds(start);
+        if (reader.Backend() != backend) {
+            printf("%-9s unavailable\n", ReadBackendName(backend));
+            continue;
+        }
+        reader.Close();
+
+        state.Reset(); // Freeing the previous run's lines is not part of the measure
+        start = prepare();
+        state.LoadFile(options.BenchLoadPath, backend);
+        const double loadSeconds = seconds(start);
+
+        printf("%-9s read %8.1f MB/s (%.2f s)   load %8.1f MB/s (%.2f s, %zu lines)%s\n", ReadBackendName(backend),
+               read / (1024.0 * 1024.0) / readSeconds, readSeconds, megabytes / loadSeconds, loadSeconds,
+               state.AllLogs.size(), read == size ? "" : "  SHORT READ");
+    }
+    return 0;
+}
+
+int RunHeadless(const CommandLineOptions& options) {
+    if (options.FollowPath.empty() && options.StreamPath.empty() && options.ListenPort == 0) {
+        fprintf(stderr, "--headless needs --follow <file>, --stream <pipe> or --listen <port>\n");
+        return 1;
+    }
+    if (!InstallAlertRules(options) || !StartCommandLineInput(options)) return 1;
+
+    const LogViewerState& state = g_ActiveDocument->State;
+    printf("Following %s (%d lines, %d rules)\n", state.FilePath.c_str(), (int)state.AllLogs.size(), (int)g_Alerts.Rules.size());
+    fflush(stdout);
+
+    for (;;) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        const bool streamEnded = g_Stream.IsActive() && g_Stream.IsFinished();
+        const size_t firstEvent = g_Alerts.Events.size();
+        UpdateLiveInput();
+        for (size_t n = firstEvent; n < g_Alerts.Events.size(); ++n) {
+            const AlertEvent& event = g_Alerts.Events[n];
+            printf("[ALERT] %s | %s\n", event.Rule.c_str(), event.Text.c_str());
+            fflush(stdout);
+            if (!options.AlertCommand.empty()) {
+                SetEnvironmentValue("ULR_ALERT_RULE", event.Rule);
+                SetEnvironmentValue("ULR_ALERT_TEXT", event.Text);
+                std::system(options.AlertCommand.c_str());
+            }
+        }
+        if (streamEnded) return 0;
+    }
+}
+
+// --export-arrow: one file per input, "out.arrow" becoming "out.2.arrow" for the second one
+int RunArrowExport(const CommandLineOptions& options) {
+    if (options.FilePaths.empty()) {
+        fprintf(stderr, "--export-arrow needs a log file\n");
+        return 1;
+    }
+    for (size_t n = 0; n < options.FilePaths.size(); ++n) {
+        LogViewerState state;
+        snprintf(state.SearchBuffer, sizeof(state.SearchBuffer), "%s", options.Filter.c_str());
+        state.LoadFile(options.FilePaths[n]);
+        if (state.FilePath.empty()) {
+            fprintf(stderr, "Cannot open %s\n", options.FilePaths[n].c_str());
+            return 1;
+        }
+        std::filesystem::path outPath = options.ExportArrowPath;
+        if (n > 0) outPath.replace_extension(std::to_string(n + 1) + outPath.extension().string());
+        std::string error;
+        const auto start = std::chrono::steady_clock::now();
+        if (!ArrowWriter::Write(state, ArrowWriter::Lines(state, state.FilteredIndices), outPath.string(), error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        printf("%s: %zu rows -> %s (%lld ms)\n", options.FilePaths[n].c_str(), state.FilteredIndices.size(),
+               outPath.string().c_str(), static_cast<long long>(ms));
+    }
+    return 0;
+}
+
 // Main Boilerplate
-int main(int, char**)
+int main(int argc, char** argv)
 {
+    CommandLineOptions options;
+    if (!ParseCommandLine(argc, argv, options))
+        return 1;
+    if (!options.BenchLoadPath.empty())
+        return RunLoadBenchmark(options);
+    if (options.BenchUi)
+        return RunUiBenchmark(options.BenchUiScript, options.BenchUiLines);
+    if (!options.ExportArrowPath.empty())
+        return RunArrowExport(options);
+    if (options.SelfTest)
+        return RunSelfTest();
+    NewDocument();
+    if (options.Headless)
+        return RunHeadless(options);
+    if (!InstallAlertRules(options))
+        return 1;
+
+    // The logs load while the window is being set up
+    g_Startup.Enabled = options.Timing;
+    g_Trends.Open(TRENDS_DB_NAME);
+    if (!StartCommandLineInput(options))
+        return 1;
+    g_Startup.Mark("load started");
+
     // 1. Setup Window
     if (!glfwInit())
         return 1;
@@ -658,6 +8767,7 @@ int main(int, char**)
     ImGui_ImplOpenGL3_Init(glsl_version);
 
     SetupModernStyle();
+    g_Startup.Mark("window");
 
     // --- 2. LOAD FONT (Crucial for modern look) ---
     // Windows usually has Segoe UI. We load it at 18px size.
@@ -675,18 +8785,27 @@ int main(int, char**)
         glfwPollEvents();
 
         if (!g_DroppedFilePath.empty()) {
-            g_LogState.LoadFile(g_DroppedFilePath);
+            OpenDocument(g_DroppedFilePath);
             g_DroppedFilePath.clear();
         }
+        for (auto& doc : g_Documents) doc->Loader.Update(doc->State);
+        UpdateLiveInput();
+        g_Memory.Update(g_Documents, g_ActiveDocument, g_QueryServer.Served());
 
         // Start the Dear ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
-        ImGui::DockSpaceOverViewport(0, ImGui::GetMainViewport(), ImGuiDockNodeFlags_PassthruCentralNode);
+        const ImGuiID dockspace = ImGui::DockSpaceOverViewport(0, ImGui::GetMainViewport(), ImGuiDockNodeFlags_PassthruCentralNode);
 
-        RenderLogViewer();
+        RenderDocuments(dockspace);
+        RenderQueryPanel();
+        RenderCorpusPanel();
+        RenderTrendsPanel();
+        RenderRarePanel();
+        RenderSimilarPanel();
+        RenderAlertsPanel();
 
         // Rendering
         ImGui::Render();
@@ -698,6 +8817,12 @@ int main(int, char**)
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
         glfwSwapBuffers(window);
+
+        if (ImGui::GetFrameCount() == 1) g_Startup.Mark("first frame");
+        if (!g_Startup.LogsReported && std::ranges::none_of(g_Documents, [](const auto& doc) { return doc->Loader.IsActive(); })) {
+            g_Startup.LogsReported = true;
+            g_Startup.Mark("logs loaded");
+        }
     }
 
     // Cleanup